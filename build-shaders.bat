@@ -2,4 +2,14 @@ glslc --target-env=vulkan1.3 -o resources/shaders/triangle.vert.spv shaders/tria
 glslc --target-env=vulkan1.3 -o resources/shaders/triangle.frag.spv shaders/triangle.frag
 
 glslc --target-env=vulkan1.3 -o resources/shaders/composite.vert.spv shaders/composite.vert
-glslc --target-env=vulkan1.3 -o resources/shaders/composite.frag.spv shaders/composite.frag
\ No newline at end of file
+glslc --target-env=vulkan1.3 -o resources/shaders/composite.frag.spv shaders/composite.frag
+
+glslc --target-env=vulkan1.3 -o resources/shaders/cull.comp.spv shaders/cull.comp
+glslc --target-env=vulkan1.3 -o resources/shaders/hiz.comp.spv shaders/hiz.comp
+
+glslc --target-env=vulkan1.3 -o resources/shaders/impostor.vert.spv shaders/impostor.vert
+glslc --target-env=vulkan1.3 -o resources/shaders/impostor.frag.spv shaders/impostor.frag
+
+glslc --target-env=vulkan1.3 -o resources/shaders/terrain.vert.spv shaders/terrain.vert
+
+glslc --target-env=vulkan1.3 -o resources/shaders/scatter.comp.spv shaders/scatter.comp
\ No newline at end of file
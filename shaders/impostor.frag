@@ -0,0 +1,49 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inClipPos;
+layout(location = 2) flat in vec4 inClipOffset;
+layout(location = 3) in vec4 inLightSpacePos;
+layout(location = 4) flat in vec4 inLightSpaceOffset;
+layout(location = 5) flat in mat3 inNormalMatrix;
+
+layout(binding = 1) uniform LightUBO {
+    vec4 lightDirection;
+    vec4 lightColor;
+    float lightIntensity;
+} ubo;
+
+layout(binding = 2) uniform sampler2DShadow shadowMap;
+
+// Layer 0 albedo and coverage, layer 1 object-space normal and depth toward the viewer
+layout(set = 1, binding = 0) uniform sampler2DArray atlas;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec4 albedo = texture(atlas, vec3(inUV, 0.0));
+    if (albedo.a < 0.5)
+        discard;
+    vec4 normalDepth = texture(atlas, vec3(inUV, 1.0));
+
+    // Move from the quad onto the baked surface, so impostors intersect the scene and receive
+    // shadows where the geometry would
+    float offset = normalDepth.a * 2.0 - 1.0;
+    vec4 clipPos = inClipPos + inClipOffset * offset;
+    gl_FragDepth = clipPos.z / clipPos.w;
+    vec4 lightSpacePos = inLightSpacePos + inLightSpaceOffset * offset;
+
+    vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
+    projCoords.xy = projCoords.xy * 0.5 + 0.5;
+    float shadow = texture(shadowMap, projCoords);
+
+    // Same shading as triangle.frag
+    vec3 objectColor = vec3(0.8, 0.8, 0.8) * albedo.rgb;
+    vec3 ambient = objectColor * 0.1;
+    vec3 normal = normalize(inNormalMatrix * (normalDepth.xyz * 2.0 - 1.0));
+    vec3 lightDir = normalize(-ubo.lightDirection.xyz);
+    float diffuseFactor = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = objectColor * ubo.lightColor.rgb * ubo.lightIntensity * diffuseFactor;
+
+    outColor = vec4(ambient + diffuse * shadow, 1.0);
+}
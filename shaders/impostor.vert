@@ -0,0 +1,78 @@
+#version 450
+
+// One quad per impostor instance (see Impostor.hpp for the atlas layout). The quad faces the atlas
+// view nearest to the camera's direction in object space, so it shows exactly what that view
+// baked; the fragment shader then restores depth and normals from the atlas.
+
+layout(location = 4) in mat4 inModel; // per instance, locations 4-7
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outClipPos;
+layout(location = 2) flat out vec4 outClipOffset; // clip-space step of one radius toward the viewer
+layout(location = 3) out vec4 outLightSpacePos;
+layout(location = 4) flat out vec4 outLightSpaceOffset;
+layout(location = 5) flat out mat3 outNormalMatrix; // locations 5-7
+
+layout(binding = 0) uniform SceneUBO {
+    mat4 view;
+    mat4 projection;
+    mat4 lightSpaceMatrix;
+} ubo;
+
+layout(push_constant) uniform Push {
+    vec4 bounds; // object-space centre and radius the atlas was baked around
+    vec4 eye;    // xyz camera position, w views per atlas side
+} pc;
+
+const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                               vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+// impostorGridCoord() and impostorDirection()
+vec2 gridCoord(vec3 d)
+{
+    d.y = max(d.y, 0.0);
+    float sum = abs(d.x) + d.y + abs(d.z);
+    if (sum <= 0.0)
+        return vec2(0.5);
+    vec2 q = d.xz / sum;
+    return vec2(q.x + q.y, q.x - q.y) * 0.5 + 0.5;
+}
+
+vec3 viewDirection(vec2 coord)
+{
+    vec2 p = coord * 2.0 - 1.0;
+    vec2 q = vec2(p.x + p.y, p.x - p.y) * 0.5;
+    return normalize(vec3(q.x, 1.0 - abs(q.x) - abs(q.y), q.y));
+}
+
+void main() {
+    mat3 linear = mat3(inModel);
+    float scale = max(length(linear[0]), max(length(linear[1]), length(linear[2])));
+    vec3 worldCenter = (inModel * vec4(pc.bounds.xyz, 1.0)).xyz;
+
+    // The transpose undoes the rotation; the scale drops out in the normalize
+    vec3 toEye = normalize(transpose(linear) * (pc.eye.xyz - worldCenter));
+    float grid = pc.eye.w;
+    vec2 frame = clamp(floor(gridCoord(toEye) * grid), vec2(0.0), vec2(grid - 1.0));
+    vec3 direction = viewDirection((frame + 0.5) / grid);
+
+    // impostorFrameBasis()
+    vec3 side = cross(vec3(0.0, 1.0, 0.0), direction);
+    vec3 right = length(side) > 1e-4 ? normalize(side) : vec3(1.0, 0.0, 0.0);
+    vec3 up = cross(direction, right);
+
+    vec2 corner = corners[gl_VertexIndex];
+    vec3 local = pc.bounds.xyz + (right * corner.x + up * corner.y) * pc.bounds.w;
+    vec4 worldPos = inModel * vec4(local, 1.0);
+    vec4 towardViewer = inModel * vec4(direction * pc.bounds.w, 0.0);
+    mat4 viewProjection = ubo.projection * ubo.view;
+
+    gl_Position = viewProjection * worldPos;
+    // Frame rows run downwards, so +up is the top of the frame
+    outUV = (frame + vec2(corner.x, -corner.y) * 0.5 + 0.5) / grid;
+    outClipPos = gl_Position;
+    outClipOffset = viewProjection * towardViewer;
+    outLightSpacePos = ubo.lightSpaceMatrix * worldPos;
+    outLightSpaceOffset = ubo.lightSpaceMatrix * towardViewer;
+    outNormalMatrix = linear / scale;
+}
@@ -0,0 +1,72 @@
+#version 450
+
+// CDLOD terrain chunks (see Terrain.hpp). There is no vertex buffer: every chunk draws the same
+// grid of gridSize quads, placed over its node by gl_VertexIndex. Odd vertices slide onto their
+// even neighbours as they near the end of their level's reach, so a chunk has become the next
+// coarser grid by the time it meets a neighbour of that level. Shaded by triangle.frag.
+
+layout(location = 0) in vec4 inNode;  // per chunk: first sample within the tile, samples per quad, layer
+layout(location = 1) in vec4 inMorph; // morph start and end distance, world XZ of the tile's corner
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec4 outLightSpacePos;
+layout(location = 3) out vec3 outColor;
+
+layout(binding = 0) uniform SceneUBO {
+    mat4 view;
+    mat4 projection;
+    mat4 lightSpaceMatrix;
+} ubo;
+
+layout(set = 1, binding = 0) uniform usampler2DArray heights;
+
+layout(push_constant) uniform Push {
+    vec4 eye;     // xyz camera position, w world units between samples
+    vec4 terrain; // height of sample 0, height per sample step, last sample index, grid quads per side
+} pc;
+
+// The depth prepass and the main pass must place every vertex identically
+invariant gl_Position;
+
+float heightAt(vec2 samplePos)
+{
+    ivec2 texel = clamp(ivec2(samplePos), ivec2(0), ivec2(int(pc.terrain.z)));
+    uint value = texelFetch(heights, ivec3(texel, int(inNode.w)), 0).r;
+    return pc.terrain.x + float(value) * pc.terrain.y;
+}
+
+// Central differences over one quad of the level, so normals are as smooth as its grid
+vec3 normalAt(vec2 samplePos, float step)
+{
+    float dx = heightAt(samplePos + vec2(step, 0.0)) - heightAt(samplePos - vec2(step, 0.0));
+    float dz = heightAt(samplePos + vec2(0.0, step)) - heightAt(samplePos - vec2(0.0, step));
+    return normalize(vec3(-dx, 2.0 * step * pc.eye.w, -dz));
+}
+
+void main() {
+    int rows = int(pc.terrain.w) + 1;
+    vec2 grid = vec2(gl_VertexIndex % rows, gl_VertexIndex / rows);
+    float step = inNode.z;
+
+    vec2 fineSample = inNode.xy + grid * step;
+    vec2 coarseSample = inNode.xy + (grid - mod(grid, 2.0)) * step;
+    vec3 fine = vec3(fineSample.x, heightAt(fineSample), fineSample.y);
+    vec3 coarse = vec3(coarseSample.x, heightAt(coarseSample), coarseSample.y);
+
+    // Measured before moving, so both chunks on a shared edge agree
+    vec3 fineWorld = vec3(inMorph.z + fine.x * pc.eye.w, fine.y, inMorph.w + fine.z * pc.eye.w);
+    float morph = clamp((distance(pc.eye.xyz, fineWorld) - inMorph.x) / (inMorph.y - inMorph.x), 0.0, 1.0);
+
+    vec3 blended = mix(fine, coarse, morph);
+    vec4 worldPos = vec4(inMorph.z + blended.x * pc.eye.w, blended.y, inMorph.w + blended.z * pc.eye.w, 1.0);
+    gl_Position = ubo.projection * ubo.view * worldPos;
+
+    vec3 normal = normalize(mix(normalAt(fineSample, step), normalAt(coarseSample, 2.0 * step), morph));
+
+    outWorldPos = worldPos.xyz;
+    outNormal = normal;
+    outLightSpacePos = ubo.lightSpaceMatrix * worldPos;
+    // Grass on the flats, rock on the slopes
+    outColor = mix(vec3(0.5, 0.46, 0.4), vec3(0.35, 0.55, 0.25), smoothstep(0.7, 0.85, normal.y));
+}
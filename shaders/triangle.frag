@@ -3,6 +3,7 @@
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec4 inLightSpacePos;
+layout(location = 3) in vec3 inColor;
 
 layout(binding = 1) uniform LightUBO {
     vec4 lightDirection;
@@ -32,7 +33,8 @@ float calculateShadow()
 }
 
 void main() {
-    vec3 objectColor = vec3(0.8, 0.8, 0.8);
+    // Vertex colours default to white, and impostors bake them into their albedo
+    vec3 objectColor = vec3(0.8, 0.8, 0.8) * inColor;
 
     vec3 ambient = objectColor * 0.1;
 
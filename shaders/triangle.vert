@@ -4,10 +4,12 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec3 inColor;
 layout(location = 3) in vec2 inTexCoord;
+layout(location = 4) in mat4 inModel; // per instance, locations 4-7
 
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec4 outLightSpacePos;
+layout(location = 3) out vec3 outColor;
 
 layout(binding = 0) uniform SceneUBO {
     mat4 view;
@@ -15,15 +17,12 @@ layout(binding = 0) uniform SceneUBO {
     mat4 lightSpaceMatrix;
 } ubo;
 
-layout(push_constant) uniform PushConstants {
-    mat4 model;
-} push;
-
 void main() {
-    vec4 worldPos = push.model * vec4(inPosition, 1.0);
+    vec4 worldPos = inModel * vec4(inPosition, 1.0);
     gl_Position = ubo.projection * ubo.view * worldPos;
 
     outWorldPos = worldPos.xyz;
-    outNormal = normalize(mat3(push.model) * inNormal);
+    outNormal = normalize(mat3(inModel) * inNormal);
     outLightSpacePos = ubo.lightSpaceMatrix * worldPos;
+    outColor = inColor;
 }
\ No newline at end of file
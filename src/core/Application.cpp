@@ -21,6 +21,11 @@ void Application::initialize() {
     m_eventManager->subscribe(EventType::MouseButtonPressed, m_orbitController.get());
     m_eventManager->subscribe(EventType::MouseButtonReleased, m_orbitController.get());
 
+    // Culling runs on the GPU, with Hi-Z occlusion and LOD selection in a compute pass, or on the
+    // CPU, with software occlusion and impostors. The CPU-only features are left unset on the GPU
+    // path; a device that cannot run it culls on the CPU without them.
+    constexpr bool gpuCulling = true;
+
     RendererConfig config{
         .windowWidth = 1280,
         .windowHeight = 720,
@@ -28,16 +33,39 @@ void Application::initialize() {
         .vertShaderPath = "../resources/shaders/triangle.vert.spv",
         .fragShaderPath = "../resources/shaders/triangle.frag.spv",
         .compositeVertShaderPath = "../resources/shaders/composite.vert.spv",
-        .compositeFragShaderPath = "../resources/shaders/composite.frag.spv"
+        .compositeFragShaderPath = "../resources/shaders/composite.frag.spv",
+        .cullShaderPath = gpuCulling ? "../resources/shaders/cull.comp.spv" : "",
+        .hizShaderPath = gpuCulling ? "../resources/shaders/hiz.comp.spv" : "",
+        .softwareOcclusion = !gpuCulling,
+        .impostorVertShaderPath = gpuCulling ? "" : "../resources/shaders/impostor.vert.spv",
+        .impostorFragShaderPath = gpuCulling ? "" : "../resources/shaders/impostor.frag.spv",
+        .worldDirectory = "../resources/world",
+        .terrainDirectory = "../resources/terrain",
+        .terrainVertShaderPath = "../resources/shaders/terrain.vert.spv",
+        .scatterDirectory = "../resources/scatter",
+        .scatterShaderPath = "../resources/shaders/scatter.comp.spv",
+        .scenePath = "../resources/scene.rscene"
     };
 
     m_renderer = std::make_unique<VulkanRenderer>(config, *m_window, *m_camera);
+    m_orbitController->setPicker([renderer = m_renderer.get()](double x, double y) {
+        return renderer->pick(x, y);
+    });
+    reseatCamera();
+}
+
+void Application::reseatCamera() const {
+    if (const auto camera = m_renderer->takeLoadedCamera()) {
+        m_orbitController->setView(camera->position, camera->target);
+    }
 }
 
 void Application::run() const {
     while (!m_window->shouldClose()) {
         Window::pollEvents();
+        m_renderer->setStreamingFocus(m_orbitController->getTarget());
         m_renderer->drawFrame();
+        reseatCamera();
     }
 }
 
@@ -27,6 +27,8 @@ public:
 
 private:
     void initialize();
+    // Points the orbit controller at the camera of a scene the renderer just loaded.
+    void reseatCamera() const;
 
     std::unique_ptr<EventManager> m_eventManager;
     std::unique_ptr<Window> m_window;
@@ -0,0 +1,276 @@
+#include "AssetLoader.hpp"
+
+#include "AsyncIO.hpp"
+#include "ModelIO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+
+namespace reactor
+{
+
+struct AssetLoader::LoadScope
+{
+    AssetLoader& loader;
+    bool reading = true;
+
+    explicit LoadScope(AssetLoader& owner)
+        : loader(owner)
+    {
+        std::lock_guard lock(loader.m_mutex);
+        loader.m_active++;
+        loader.m_reading++;
+    }
+
+    void finishReading()
+    {
+        if (!reading)
+            return;
+        reading = false;
+        std::lock_guard lock(loader.m_mutex);
+        loader.m_reading--;
+        loader.m_idle.notify_all();
+    }
+
+    ~LoadScope()
+    {
+        finishReading();
+        std::lock_guard lock(loader.m_mutex);
+        loader.m_active--;
+        loader.m_idle.notify_all();
+    }
+};
+
+AssetLoader::AssetLoader(UploadScheduler& scheduler, size_t workerCount)
+    : m_workers(workerCount), m_scheduler(scheduler)
+{}
+
+AssetLoader::~AssetLoader()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_active == 0; });
+}
+
+void AssetLoader::waitForReads()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_reading == 0; });
+}
+
+MeshHandle AssetLoader::requestMesh(const std::string& path, uint32_t meshIndex, const glm::vec3& position)
+{
+    MeshHandle handle;
+    spawn(loadInto(handle, path, meshIndex, position), [] {});
+    return handle;
+}
+
+Task<std::vector<MeshToc>> AssetLoader::readTocAsync(std::string path)
+{
+    LoadScope scope(*this);
+    co_await m_workers.schedule();
+    co_return readModelToc(path);
+}
+
+MeshHandle AssetLoader::requestMeshLevel(const std::string& path, const MeshChunk& level, const glm::vec3& position)
+{
+    MeshHandle handle;
+    spawn(loadLevelInto(handle, path, level, position), [] {});
+    return handle;
+}
+
+Task<std::shared_ptr<const OccluderMesh>> AssetLoader::readOccluderAsync(std::string path, MeshChunk level)
+{
+    LoadScope scope(*this);
+    std::shared_ptr<OccluderMesh> occluder;
+    std::vector<Vertex> vertices;
+
+    try
+    {
+        if (level.vertexCount == 0 || level.indexCount == 0)
+        {
+            spdlog::error("{} has an empty mesh level", path);
+            co_return nullptr;
+        }
+
+        occluder = std::make_shared<OccluderMesh>();
+        vertices.resize(level.vertexCount);
+        occluder->indices.resize(level.indexCount);
+
+        std::vector<ReadRequest> reads(2);
+        reads[0].path = path;
+        reads[0].offset = level.vertexOffset;
+        reads[0].size = level.vertexCount * sizeof(Vertex);
+        reads[0].destination = vertices.data();
+        reads[1].path = path;
+        reads[1].offset = level.indexOffset;
+        reads[1].size = level.indexCount * sizeof(uint32_t);
+        reads[1].destination = occluder->indices.data();
+        const std::vector<ReadResult> results = co_await AsyncIO::shared().readAllAsync(std::move(reads), m_workers);
+        scope.finishReading();
+
+        if (!results[0].ok || !results[1].ok)
+        {
+            spdlog::error("Failed to read occluder from {}", path);
+            co_return nullptr;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Failed to load occluder from {}: {}", path, e.what());
+        co_return nullptr;
+    }
+
+    // The rasterizer indexes positions without checking
+    const auto vertexCount = static_cast<uint64_t>(vertices.size());
+    if (std::any_of(occluder->indices.begin(), occluder->indices.end(), [&](uint32_t i) { return i >= vertexCount; }))
+    {
+        spdlog::error("{} has an occluder index out of range", path);
+        co_return nullptr;
+    }
+
+    occluder->positions.reserve(vertices.size());
+    for (const Vertex& vertex : vertices)
+    {
+        occluder->positions.push_back(vertex.pos);
+    }
+    co_return occluder;
+}
+
+Task<std::shared_ptr<const ImpostorAtlas>> AssetLoader::readImpostorAsync(std::string path)
+{
+    LoadScope scope(*this);
+    auto atlas = std::make_shared<ImpostorAtlas>();
+
+    try
+    {
+        co_await m_workers.schedule();
+        if (!std::filesystem::exists(path))
+        {
+            co_return nullptr;
+        }
+
+        ReadRequest request;
+        request.path = path;
+        const ReadResult result = co_await AsyncIO::shared().readAsync(std::move(request), m_workers);
+        scope.finishReading();
+
+        if (!result.ok)
+        {
+            spdlog::error("Failed to read impostor {}", path);
+            co_return nullptr;
+        }
+        if (!parseImpostor(result.data.data(), result.data.size(), path, *atlas))
+        {
+            co_return nullptr;
+        }
+        generateImpostorMips(*atlas);
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Failed to load impostor {}: {}", path, e.what());
+        co_return nullptr;
+    }
+    co_return atlas;
+}
+
+Task<void> AssetLoader::loadInto(MeshHandle handle, std::string path, uint32_t meshIndex, glm::vec3 position)
+{
+    LoadScope scope(*this);
+    MeshChunk level;
+
+    try
+    {
+        // Header parsing issues small dependent reads, so it runs on a worker
+        co_await m_workers.schedule();
+        const std::vector<MeshToc> toc = readModelToc(path);
+        if (meshIndex >= toc.size())
+        {
+            spdlog::error("{} has no mesh {}", path, meshIndex);
+            handle.fail();
+            co_return;
+        }
+        level = toc[meshIndex].lods.front();
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Failed to load {}: {}", path, e.what());
+        handle.fail();
+        co_return;
+    }
+
+    co_await uploadLevel(handle, path, level, position, scope);
+}
+
+Task<void> AssetLoader::loadLevelInto(MeshHandle handle, std::string path, MeshChunk level, glm::vec3 position)
+{
+    LoadScope scope(*this);
+    co_await uploadLevel(handle, path, level, position, scope);
+}
+
+Task<void> AssetLoader::uploadLevel(MeshHandle handle, const std::string& path, MeshChunk level, glm::vec3 position, LoadScope& scope)
+{
+    std::vector<UploadReservation> uploads;
+
+    try
+    {
+        if (level.vertexCount == 0 || level.indexCount == 0)
+        {
+            spdlog::error("{} has an empty mesh level", path);
+            handle.fail();
+            co_return;
+        }
+
+        // The cooked payload is GPU-ready, so it is read straight into upload memory
+        uploads.push_back(m_scheduler.reserve(
+            level.vertexCount * sizeof(Vertex), vk::BufferUsageFlagBits::eVertexBuffer, "Vertex Buffer", position));
+        uploads.push_back(m_scheduler.reserve(
+            level.indexCount * sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer, "Index Buffer", position));
+        std::shared_ptr<Buffer> vertexBuffer = uploads[0].destination;
+        std::shared_ptr<Buffer> indexBuffer = uploads[1].destination;
+
+        // Both reads go out as one batch so they are in flight together
+        const uint64_t offsets[] = {level.vertexOffset, level.indexOffset};
+        std::vector<ReadRequest> reads(uploads.size());
+        for (size_t i = 0; i < uploads.size(); ++i)
+        {
+            reads[i].path = path;
+            reads[i].offset = offsets[i];
+            reads[i].size = uploads[i].size();
+            reads[i].destination = uploads[i].data();
+        }
+        const std::vector<ReadResult> results = co_await AsyncIO::shared().readAllAsync(std::move(reads), m_workers);
+        scope.finishReading();
+
+        const bool readOk = std::all_of(results.begin(), results.end(), [](const ReadResult& r) { return r.ok; });
+
+        if (!readOk)
+        {
+            for (auto& upload : uploads)
+                m_scheduler.abandon(std::move(upload));
+            uploads.clear();
+            handle.fail();
+            co_return;
+        }
+
+        // Resumes on the render thread once the copies are recorded
+        co_await m_scheduler.uploadAsync(std::move(uploads));
+        uploads.clear();
+
+        handle.publish(
+            std::make_shared<Mesh>(std::move(vertexBuffer), std::move(indexBuffer), static_cast<uint32_t>(level.indexCount)));
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Failed to load {}: {}", path, e.what());
+        for (auto& upload : uploads)
+        {
+            if (upload.destination)
+                m_scheduler.abandon(std::move(upload));
+        }
+        handle.fail();
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../vulkan/Mesh.hpp"
+#include "../vulkan/UploadScheduler.hpp"
+#include "Impostor.hpp"
+#include "ModelIO.hpp"
+#include "Task.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+namespace reactor
+{
+
+// Coroutine front end for asset loading. Each load runs as a chain of awaitable steps: header
+// parsing on a worker, payload reads through AsyncIO straight into upload memory, and the copy
+// through the UploadScheduler. Nothing blocks the render thread.
+class AssetLoader
+{
+public:
+    explicit AssetLoader(UploadScheduler& scheduler, size_t workerCount = ThreadPool::defaultThreadCount());
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Returns a handle immediately and loads in the background.
+    MeshHandle requestMesh(const std::string& path, uint32_t meshIndex = 0, const glm::vec3& position = glm::vec3(0.0f));
+
+    // Table of contents of a .mesh file, read on a worker. Empty when the file is missing or malformed.
+    Task<std::vector<MeshToc>> readTocAsync(std::string path);
+
+    // Loads one level already located through the table of contents, skipping the header reads.
+    MeshHandle requestMeshLevel(const std::string& path, const MeshChunk& level, const glm::vec3& position);
+
+    // Reads one level into CPU memory as occluder geometry. Null when it cannot be read or its
+    // indices are out of range.
+    Task<std::shared_ptr<const OccluderMesh>> readOccluderAsync(std::string path, MeshChunk level);
+
+    // Reads an impostor atlas and builds its mip chain on a worker. Null when the file is missing,
+    // which is the common case and not logged, or malformed.
+    Task<std::shared_ptr<const ImpostorAtlas>> readImpostorAsync(std::string path);
+
+    // Blocks until no load is still reading from disk. Loads already handed to the upload scheduler
+    // may remain; they finish when the scheduler flushes or is destroyed.
+    void waitForReads();
+
+private:
+    // Tracks one load in m_active / m_reading for the shutdown waits.
+    struct LoadScope;
+
+    Task<void> loadInto(MeshHandle handle, std::string path, uint32_t meshIndex, glm::vec3 position);
+    Task<void> loadLevelInto(MeshHandle handle, std::string path, MeshChunk level, glm::vec3 position);
+    Task<void> uploadLevel(MeshHandle handle, const std::string& path, MeshChunk level, glm::vec3 position, LoadScope& scope);
+
+    ThreadPool m_workers;
+    UploadScheduler& m_scheduler;
+
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    uint32_t m_active = 0;
+    uint32_t m_reading = 0;
+};
+
+} // namespace reactor
@@ -0,0 +1,272 @@
+#include "AssetManager.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+namespace reactor
+{
+
+namespace
+{
+
+// Device-local heaps are considered under pressure above this fraction of their VMA budget.
+constexpr double kHeapPressure = 0.9;
+
+// Frames a finer LOD level stays resident after it was last wanted, so small camera moves do not
+// stream the same level in and out.
+constexpr uint64_t kLodGraceFrames = 120;
+
+uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// 64-bit content hash, eight bytes at a time.
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = mix(seed ^ (size * 0x9e3779b97f4a7c15ull));
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        h = mix(h ^ word) * 0x9e3779b97f4a7c15ull;
+    }
+    uint64_t tail = 0;
+    if (size > i)
+    {
+        memcpy(&tail, bytes + i, size - i);
+    }
+    return mix(h ^ tail);
+}
+
+bool sameContents(const MeshData& mesh, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    return mesh.vertices.size() == vertices.size() && mesh.indices.size() == indices.size()
+        && (vertices.empty() || memcmp(mesh.vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0)
+        && (indices.empty() || memcmp(mesh.indices.data(), indices.data(), indices.size() * sizeof(uint32_t)) == 0);
+}
+
+} // namespace
+
+AssetManager::AssetManager(Allocator& allocator, FrameManager& frameManager, UploadScheduler& scheduler, AssetLoader& loader)
+    : m_allocator(allocator), m_frameManager(frameManager), m_scheduler(scheduler), m_loader(loader)
+{}
+
+std::string AssetManager::fileKey(const std::string& path, uint32_t meshIndex)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return (error ? path : canonical.string()) + "#" + std::to_string(meshIndex);
+}
+
+MeshHandle AssetManager::acquireMesh(const std::string& path, uint32_t meshIndex, const glm::vec3& position)
+{
+    const std::string key = fileKey(path, meshIndex);
+    if (auto it = m_entries.find(key); it != m_entries.end() && !it->second.handle.hasFailed())
+    {
+        it->second.lastUsedFrame = m_frameManager.getFrameNumber();
+        return it->second.handle;
+    }
+    return insert(key, m_loader.requestMesh(path, meshIndex, position));
+}
+
+std::shared_ptr<LodMesh> AssetManager::acquireLodMesh(const std::string& path,
+                                                      uint32_t meshIndex,
+                                                      const glm::vec3& position)
+{
+    const std::string key = fileKey(path, meshIndex);
+    if (auto it = m_lodMeshes.find(key); it != m_lodMeshes.end() && !it->second->hasFailed())
+    {
+        return it->second;
+    }
+
+    auto mesh = std::make_shared<LodMesh>(m_loader, m_frameManager, path, meshIndex, position);
+    mesh->load();
+    m_lodMeshes[key] = mesh;
+    return mesh;
+}
+
+MeshHandle AssetManager::acquireMesh(const std::vector<Vertex>& vertices,
+                                     const std::vector<uint32_t>& indices,
+                                     const glm::vec3& position)
+{
+    const uint64_t hash = hashBytes(indices.data(),
+                                    indices.size() * sizeof(uint32_t),
+                                    hashBytes(vertices.data(), vertices.size() * sizeof(Vertex), 0));
+    const std::string base = "content:" + std::to_string(hash);
+
+    // A hash hit only counts when the geometry matches; colliding meshes probe further keys
+    std::string key = base;
+    for (uint32_t probe = 1;; ++probe)
+    {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+        {
+            break;
+        }
+        if (it->second.content && sameContents(*it->second.content, vertices, indices))
+        {
+            it->second.lastUsedFrame = m_frameManager.getFrameNumber();
+            return it->second.handle;
+        }
+        key = base + "#" + std::to_string(probe);
+    }
+
+    MeshHandle handle = insert(key, MeshHandle(std::make_shared<Mesh>(m_scheduler, vertices, indices, position)));
+    m_entries[key].content = std::make_shared<const MeshData>(MeshData{vertices, indices});
+    return handle;
+}
+
+MeshHandle AssetManager::insert(const std::string& key, MeshHandle handle)
+{
+    Entry& entry = m_entries[key];
+    entry.handle = handle;
+    entry.lastUsedFrame = m_frameManager.getFrameNumber();
+    return handle;
+}
+
+void AssetManager::update()
+{
+    const uint64_t frame = m_frameManager.getFrameNumber();
+
+    m_stats.meshCount = m_entries.size() + m_lodMeshes.size();
+    m_stats.referencedCount = 0;
+    m_stats.loadingCount = 0;
+    m_stats.residentBytes = 0;
+    m_stats.budgetBytes = m_budget;
+    m_stats.lodLevels = 0;
+    m_stats.residentLodLevels = 0;
+
+    struct Candidate
+    {
+        uint64_t lastUsedFrame;
+        const std::string* key;
+        bool lod;
+    };
+    std::vector<Candidate> candidates;
+
+    for (auto& [key, entry] : m_entries)
+    {
+        if (entry.handle.isLoading())
+        {
+            m_stats.loadingCount++;
+        }
+        if (const auto mesh = entry.handle.shared())
+        {
+            m_stats.residentBytes += mesh->getMemorySize();
+        }
+
+        // The cache holds one handle itself
+        if (entry.handle.useCount() > 1)
+        {
+            entry.lastUsedFrame = frame;
+            m_stats.referencedCount++;
+        }
+        else if (!entry.handle.isLoading())
+        {
+            candidates.push_back({entry.lastUsedFrame, &key, false});
+        }
+    }
+
+    for (auto& [key, mesh] : m_lodMeshes)
+    {
+        if (mesh->isLoading())
+        {
+            m_stats.loadingCount++;
+        }
+
+        if (mesh.use_count() > 1)
+        {
+            mesh->trim(kLodGraceFrames);
+            m_stats.referencedCount++;
+        }
+        else if (!mesh->isLoading())
+        {
+            candidates.push_back({mesh->lastUsedFrame(), &key, true});
+        }
+
+        m_stats.residentBytes += mesh->residentBytes();
+        m_stats.lodLevels += mesh->levelCount();
+        m_stats.residentLodLevels += mesh->residentLevelCount();
+    }
+
+    // Bytes to free: whichever of the mesh budget and device-local heap pressure demands more
+    vk::DeviceSize excess = 0;
+    if (m_budget > 0 && m_stats.residentBytes > m_budget)
+    {
+        excess = m_stats.residentBytes - m_budget;
+    }
+
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(m_allocator.getAllocator(), &memoryProperties);
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(m_allocator.getAllocator(), budgets.data());
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+    {
+        if ((memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+        {
+            continue;
+        }
+        const auto limit = static_cast<vk::DeviceSize>(static_cast<double>(budgets[i].budget) * kHeapPressure);
+        if (budgets[i].usage > limit)
+        {
+            excess = std::max(excess, budgets[i].usage - limit);
+        }
+    }
+
+    if (excess == 0 || candidates.empty())
+    {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsedFrame < b.lastUsedFrame;
+    });
+
+    vk::DeviceSize freed = 0;
+    for (const Candidate& candidate : candidates)
+    {
+        if (freed >= excess)
+        {
+            break;
+        }
+
+        // Frames still in flight may draw the mesh, so its buffers go through deferred release
+        if (candidate.lod)
+        {
+            auto it = m_lodMeshes.find(*candidate.key);
+            freed += it->second->residentBytes();
+            it->second->evict();
+            m_lodMeshes.erase(it);
+        }
+        else
+        {
+            auto it = m_entries.find(*candidate.key);
+            if (auto mesh = it->second.handle.shared())
+            {
+                freed += mesh->getMemorySize();
+                m_frameManager.retire(std::move(mesh));
+            }
+            m_entries.erase(it);
+        }
+        m_stats.evictions++;
+    }
+
+    m_stats.meshCount = m_entries.size() + m_lodMeshes.size();
+    m_stats.residentBytes -= std::min(freed, m_stats.residentBytes);
+    spdlog::info("Asset cache evicted meshes: freed {} KiB, {} meshes remain", freed / 1024, m_stats.meshCount);
+}
+
+} // namespace reactor
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../vulkan/Allocator.hpp"
+#include "../vulkan/FrameManager.hpp"
+#include "../vulkan/Mesh.hpp"
+#include "../vulkan/UploadScheduler.hpp"
+#include "AssetLoader.hpp"
+#include "LodMesh.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace reactor
+{
+
+struct AssetCacheStats
+{
+    size_t meshCount = 0;
+    size_t referencedCount = 0;
+    size_t loadingCount = 0;
+    vk::DeviceSize residentBytes = 0;
+    vk::DeviceSize budgetBytes = 0; // 0 = only device-local heap pressure triggers eviction
+    uint64_t evictions = 0;
+    uint32_t lodLevels = 0;
+    uint32_t residentLodLevels = 0;
+};
+
+// Owns every shared mesh. Loads of the same file, or meshes with identical contents, resolve to one
+// handle. A mesh counts as referenced while any handle besides the cache's own is alive; when mesh
+// memory exceeds the budget, or a device-local heap nears its VMA budget, unreferenced meshes are
+// evicted least recently used first. Evicted meshes reload on the next acquire. Render thread only.
+class AssetManager
+{
+public:
+    AssetManager(Allocator& allocator, FrameManager& frameManager, UploadScheduler& scheduler, AssetLoader& loader);
+
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    // Mesh meshIndex of a cooked .mesh file, keyed by canonical path.
+    MeshHandle acquireMesh(const std::string& path, uint32_t meshIndex = 0, const glm::vec3& position = glm::vec3(0.0f));
+
+    // Mesh meshIndex of a cooked .mesh file with per-level residency, keyed by canonical path.
+    std::shared_ptr<LodMesh> acquireLodMesh(const std::string& path,
+                                            uint32_t meshIndex = 0,
+                                            const glm::vec3& position = glm::vec3(0.0f));
+
+    // In-memory geometry, keyed by its contents. A copy is kept to tell hash collisions apart.
+    MeshHandle acquireMesh(const std::vector<Vertex>& vertices,
+                           const std::vector<uint32_t>& indices,
+                           const glm::vec3& position = glm::vec3(0.0f));
+
+    void setBudget(vk::DeviceSize meshBytes)
+    {
+        m_budget = meshBytes;
+    }
+
+    // Refreshes recency for referenced meshes, retires LOD levels that are no longer wanted and
+    // evicts while over budget. Call once per frame.
+    void update();
+
+    [[nodiscard]] const AssetCacheStats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct Entry
+    {
+        MeshHandle handle;
+        uint64_t lastUsedFrame = 0;
+        std::shared_ptr<const MeshData> content; // in-memory meshes, compared on a hash hit
+    };
+
+    MeshHandle insert(const std::string& key, MeshHandle handle);
+    static std::string fileKey(const std::string& path, uint32_t meshIndex);
+
+    Allocator& m_allocator;
+    FrameManager& m_frameManager;
+    UploadScheduler& m_scheduler;
+    AssetLoader& m_loader;
+
+    std::unordered_map<std::string, Entry> m_entries;
+    std::unordered_map<std::string, std::shared_ptr<LodMesh>> m_lodMeshes;
+    vk::DeviceSize m_budget = 0;
+    AssetCacheStats m_stats;
+};
+
+} // namespace reactor
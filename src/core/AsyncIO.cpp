@@ -0,0 +1,452 @@
+#include "AsyncIO.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef REACTOR_HAS_IO_URING
+#include <liburing.h>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace reactor
+{
+
+namespace
+{
+
+// Blocking reads issued from pool workers; parallelism comes from the number of workers.
+class ThreadPoolIO final : public AsyncIO
+{
+public:
+    explicit ThreadPoolIO(size_t workerCount)
+        : m_pool(workerCount)
+    {}
+
+    void submit(std::vector<ReadRequest> batch) override
+    {
+        for (auto& request : batch)
+        {
+            m_pool.enqueue([request = std::move(request)]() mutable { execute(request); });
+        }
+    }
+
+    [[nodiscard]] const char* backendName() const override
+    {
+        return "thread pool";
+    }
+
+private:
+    static void execute(ReadRequest& request)
+    {
+        ReadResult result;
+        result.path = request.path;
+
+        std::ifstream file(request.path, std::ios::binary | std::ios::ate);
+        if (file.is_open())
+        {
+            const auto fileSize = static_cast<uint64_t>(file.tellg());
+            if (request.offset <= fileSize)
+            {
+                uint64_t size = request.size;
+                if (size == 0)
+                {
+                    size = fileSize - request.offset;
+                }
+
+                char* target = static_cast<char*>(request.destination);
+                if (!target)
+                {
+                    result.data.resize(size);
+                    target = result.data.data();
+                }
+
+                file.seekg(static_cast<std::streamoff>(request.offset));
+                file.read(target, static_cast<std::streamsize>(size));
+                result.bytesRead = static_cast<uint64_t>(file.gcount());
+                result.ok = result.bytesRead == size;
+            }
+        }
+
+        if (!result.ok)
+        {
+            spdlog::error("Failed to read {}", request.path);
+        }
+        if (request.onComplete)
+        {
+            request.onComplete(std::move(result));
+        }
+    }
+
+    ThreadPool m_pool;
+};
+
+#ifdef REACTOR_HAS_IO_URING
+
+// One ring shared by all callers. Requests are split into fixed-size chunks that are all queued
+// at once so a single large file still keeps the device busy; a reaper thread handles completions
+// and finishes short reads.
+class UringIO final : public AsyncIO
+{
+public:
+    static constexpr unsigned kQueueDepth = 256;
+    static constexpr uint64_t kChunkSize = 1024 * 1024;
+
+    static std::unique_ptr<UringIO> tryCreate()
+    {
+        auto io = std::unique_ptr<UringIO>(new UringIO());
+        const int error = io_uring_queue_init(kQueueDepth, &io->m_ring, 0);
+        if (error < 0)
+        {
+            spdlog::warn("io_uring unavailable ({}), using thread pool I/O", error);
+            return nullptr;
+        }
+        io->m_ringReady = true;
+        io->m_reaper = std::thread([raw = io.get()] { raw->reapLoop(); });
+        return io;
+    }
+
+    ~UringIO() override
+    {
+        // Destroyed by tryCreate when the kernel refused the ring
+        if (!m_ringReady)
+        {
+            return;
+        }
+
+        {
+            std::unique_lock lock(m_idleMutex);
+            m_idle.wait(lock, [this] { return m_inFlight.load() == 0 || m_reaperStopped.load(); });
+        }
+
+        // A NOP without user data tells the reaper to exit
+        if (m_reaper.joinable() && !m_reaperStopped.load())
+        {
+            std::lock_guard lock(m_submitMutex);
+            io_uring_sqe* sqe = acquireSqe();
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+            io_uring_submit(&m_ring);
+        }
+        if (m_reaper.joinable())
+        {
+            m_reaper.join();
+        }
+        io_uring_queue_exit(&m_ring);
+    }
+
+    void submit(std::vector<ReadRequest> batch) override
+    {
+        // Requests that fail to open, or are empty, complete outside the lock so their callbacks
+        // may submit again.
+        std::vector<File*> completed;
+        {
+            std::lock_guard lock(m_submitMutex);
+            for (auto& request : batch)
+            {
+                if (File* file = start(std::move(request)))
+                {
+                    completed.push_back(file);
+                }
+            }
+            io_uring_submit(&m_ring);
+        }
+        for (File* file : completed)
+        {
+            finish(file);
+        }
+    }
+
+    [[nodiscard]] const char* backendName() const override
+    {
+        return "io_uring";
+    }
+
+private:
+    struct File
+    {
+        ReadRequest request;
+        ReadResult result;
+        int fd = -1;
+        char* target = nullptr;
+        std::atomic<uint32_t> pendingChunks{0};
+        std::atomic<uint64_t> bytesRead{0};
+        std::atomic<bool> failed{false};
+    };
+
+    struct Chunk
+    {
+        File* file;
+        uint64_t offset; // relative to the request offset
+        uint64_t length;
+        uint64_t done = 0;
+    };
+
+    UringIO() = default;
+
+    io_uring_sqe* acquireSqe()
+    {
+        // The submission queue is full; flush it so the kernel frees entries
+        io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+        while (!sqe)
+        {
+            io_uring_submit(&m_ring);
+            std::this_thread::yield();
+            sqe = io_uring_get_sqe(&m_ring);
+        }
+        return sqe;
+    }
+
+    // Caller holds m_submitMutex.
+    void queueChunk(Chunk* chunk)
+    {
+        File& file = *chunk->file;
+        io_uring_sqe* sqe = acquireSqe();
+        io_uring_prep_read(sqe,
+                           file.fd,
+                           file.target + chunk->offset + chunk->done,
+                           static_cast<unsigned>(chunk->length - chunk->done),
+                           file.request.offset + chunk->offset + chunk->done);
+        io_uring_sqe_set_data(sqe, chunk);
+    }
+
+    // Caller holds m_submitMutex. Returns the file when it completed without queuing any reads.
+    File* start(ReadRequest&& request)
+    {
+        auto* file = new File();
+        file->request = std::move(request);
+        file->result.path = file->request.path;
+
+        file->fd = open(file->request.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info = {};
+        if (m_reaperStopped.load() || file->fd < 0 || fstat(file->fd, &info) != 0
+            || file->request.offset > static_cast<uint64_t>(info.st_size))
+        {
+            file->failed = true;
+            return file;
+        }
+
+        uint64_t size = file->request.size;
+        if (size == 0)
+        {
+            size = static_cast<uint64_t>(info.st_size) - file->request.offset;
+        }
+        file->request.size = size;
+
+        file->target = static_cast<char*>(file->request.destination);
+        if (!file->target)
+        {
+            file->result.data.resize(size);
+            file->target = file->result.data.data();
+        }
+
+        if (size == 0)
+        {
+            return file;
+        }
+
+        const auto chunkCount = static_cast<uint32_t>((size + kChunkSize - 1) / kChunkSize);
+        file->pendingChunks = chunkCount;
+        m_inFlight.fetch_add(1);
+        for (uint32_t i = 0; i < chunkCount; ++i)
+        {
+            const uint64_t offset = static_cast<uint64_t>(i) * kChunkSize;
+            queueChunk(new Chunk{file, offset, std::min(kChunkSize, size - offset)});
+        }
+        return nullptr;
+    }
+
+    void finish(File* file)
+    {
+        if (file->fd >= 0)
+        {
+            close(file->fd);
+        }
+        file->result.bytesRead = file->bytesRead.load();
+        file->result.ok = file->fd >= 0 && !file->failed.load() && file->result.bytesRead == file->request.size;
+        if (!file->result.ok)
+        {
+            spdlog::error("Failed to read {}", file->request.path);
+        }
+        if (file->request.onComplete)
+        {
+            file->request.onComplete(std::move(file->result));
+        }
+        delete file;
+    }
+
+    // Blocking read of what a short read left of chunk; marks the file failed on error or EOF.
+    static void readRemainder(Chunk& chunk)
+    {
+        File& file = *chunk.file;
+        while (chunk.done < chunk.length)
+        {
+            const ssize_t count = pread(file.fd,
+                                        file.target + chunk.offset + chunk.done,
+                                        chunk.length - chunk.done,
+                                        static_cast<off_t>(file.request.offset + chunk.offset + chunk.done));
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                file.failed = true;
+                return;
+            }
+            chunk.done += static_cast<uint64_t>(count);
+            file.bytesRead.fetch_add(static_cast<uint64_t>(count));
+        }
+    }
+
+    void reapLoop()
+    {
+        for (;;)
+        {
+            io_uring_cqe* cqe = nullptr;
+            const int error = io_uring_wait_cqe(&m_ring, &cqe);
+            if (error == -EINTR)
+            {
+                continue;
+            }
+            if (error < 0)
+            {
+                // Reads still in flight never complete; later submissions fail straight away
+                spdlog::error("io_uring wait failed ({}), asset I/O stopped", error);
+                m_reaperStopped = true;
+                std::lock_guard lock(m_idleMutex);
+                m_idle.notify_all();
+                return;
+            }
+            auto* chunk = static_cast<Chunk*>(io_uring_cqe_get_data(cqe));
+            const int res = cqe->res;
+            io_uring_cqe_seen(&m_ring, cqe);
+
+            if (!chunk)
+            {
+                return;
+            }
+
+            File* file = chunk->file;
+            if (res > 0)
+            {
+                chunk->done += static_cast<uint64_t>(res);
+                file->bytesRead.fetch_add(static_cast<uint64_t>(res));
+                if (chunk->done < chunk->length)
+                {
+                    // Short read: finish the chunk here. Requeueing it would need m_submitMutex,
+                    // whose holder may be waiting in acquireSqe for this thread to reap.
+                    readRemainder(*chunk);
+                }
+            }
+            else
+            {
+                // Error, or end of file before the requested size
+                file->failed = true;
+            }
+
+            delete chunk;
+            if (file->pendingChunks.fetch_sub(1) == 1)
+            {
+                finish(file);
+                if (m_inFlight.fetch_sub(1) == 1)
+                {
+                    std::lock_guard lock(m_idleMutex);
+                    m_idle.notify_all();
+                }
+            }
+        }
+    }
+
+    io_uring m_ring{};
+    bool m_ringReady = false; // set once io_uring_queue_init succeeded
+    std::mutex m_submitMutex;
+    std::thread m_reaper;
+
+    std::atomic<uint32_t> m_inFlight{0};
+    std::atomic<bool> m_reaperStopped{false};
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<AsyncIO> AsyncIO::create(size_t workerCount)
+{
+#ifdef REACTOR_HAS_IO_URING
+    if (auto io = UringIO::tryCreate())
+    {
+        spdlog::info("Asset I/O backend: io_uring");
+        return io;
+    }
+#endif
+    spdlog::info("Asset I/O backend: thread pool ({} workers)", workerCount);
+    return std::make_unique<ThreadPoolIO>(workerCount);
+}
+
+AsyncIO& AsyncIO::shared()
+{
+    static const std::unique_ptr<AsyncIO> instance = create();
+    return *instance;
+}
+
+std::future<ReadResult> AsyncIO::read(const std::string& path, uint64_t offset, uint64_t size)
+{
+    auto promise = std::make_shared<std::promise<ReadResult>>();
+    std::future<ReadResult> future = promise->get_future();
+
+    ReadRequest request;
+    request.path = path;
+    request.offset = offset;
+    request.size = size;
+    request.onComplete = [promise](ReadResult&& result) { promise->set_value(std::move(result)); };
+
+    std::vector<ReadRequest> batch;
+    batch.push_back(std::move(request));
+    submit(std::move(batch));
+    return future;
+}
+
+std::vector<ReadResult> AsyncIO::readAll(const std::vector<std::string>& paths)
+{
+    std::vector<std::future<ReadResult>> futures;
+    std::vector<ReadRequest> batch;
+    futures.reserve(paths.size());
+    batch.reserve(paths.size());
+
+    for (const auto& path : paths)
+    {
+        auto promise = std::make_shared<std::promise<ReadResult>>();
+        futures.push_back(promise->get_future());
+
+        ReadRequest request;
+        request.path = path;
+        request.onComplete = [promise](ReadResult&& result) { promise->set_value(std::move(result)); };
+        batch.push_back(std::move(request));
+    }
+    submit(std::move(batch));
+
+    std::vector<ReadResult> results;
+    results.reserve(futures.size());
+    for (auto& future : futures)
+    {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+} // namespace reactor
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+struct ReadResult
+{
+    std::string path;
+    std::vector<char> data; // empty when the request supplied its own destination
+    uint64_t bytesRead = 0;
+    bool ok = false;
+};
+
+struct ReadRequest
+{
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t size = 0; // 0 reads from offset to the end of the file
+
+    // When set, bytes are written here instead of ReadResult::data. size must be given and the
+    // memory must stay valid until onComplete has run.
+    void* destination = nullptr;
+
+    // Runs on an I/O thread and must not block on other reads.
+    std::function<void(ReadResult&&)> onComplete;
+};
+
+// Batched asynchronous file reads. The io_uring backend keeps many reads in flight from a single
+// submitter; elsewhere, or when the kernel refuses a ring, a thread pool issues blocking reads in
+// parallel.
+class AsyncIO
+{
+public:
+    virtual ~AsyncIO() = default;
+
+    // io_uring when compiled in (REACTOR_HAS_IO_URING) and available, thread pool otherwise.
+    static std::unique_ptr<AsyncIO> create(size_t workerCount = 4);
+
+    // Process-wide instance used by the mesh and shader loaders.
+    static AsyncIO& shared();
+
+    virtual void submit(std::vector<ReadRequest> batch) = 0;
+    [[nodiscard]] virtual const char* backendName() const = 0;
+
+    std::future<ReadResult> read(const std::string& path, uint64_t offset = 0, uint64_t size = 0);
+
+    // Submits all paths as one batch and blocks until every read has completed.
+    std::vector<ReadResult> readAll(const std::vector<std::string>& paths);
+
+    // co_await io.readAsync(request, workers) yields the ReadResult. The coroutine continues on a
+    // worker rather than the I/O thread, so it is free to block. request.onComplete is ignored.
+    auto readAsync(ReadRequest request, ThreadPool& resumeOn)
+    {
+        struct Awaiter
+        {
+            AsyncIO& io;
+            ThreadPool& pool;
+            ReadRequest request;
+            ReadResult result;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                request.onComplete = [this, handle](ReadResult&& completed) {
+                    result = std::move(completed);
+                    pool.enqueue([handle] { handle.resume(); });
+                };
+                std::vector<ReadRequest> batch;
+                batch.push_back(std::move(request));
+                io.submit(std::move(batch));
+            }
+            ReadResult await_resume()
+            {
+                return std::move(result);
+            }
+        };
+        return Awaiter{*this, resumeOn, std::move(request), {}};
+    }
+
+    // co_await io.readAllAsync(requests, workers) submits every request as one batch, so they are
+    // all in flight together, and yields the results in request order once the last one finished.
+    auto readAllAsync(std::vector<ReadRequest> requests, ThreadPool& resumeOn)
+    {
+        struct Awaiter
+        {
+            AsyncIO& io;
+            ThreadPool& pool;
+            std::vector<ReadRequest> requests;
+            std::vector<ReadResult> results;
+            std::atomic<size_t> remaining{0};
+
+            bool await_ready() const noexcept
+            {
+                return requests.empty();
+            }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                results.resize(requests.size());
+                remaining.store(requests.size());
+                for (size_t i = 0; i < requests.size(); ++i)
+                {
+                    requests[i].onComplete = [this, handle, i](ReadResult&& completed) {
+                        results[i] = std::move(completed);
+                        if (remaining.fetch_sub(1) == 1)
+                        {
+                            pool.enqueue([handle] { handle.resume(); });
+                        }
+                    };
+                }
+                io.submit(std::move(requests));
+            }
+            std::vector<ReadResult> await_resume()
+            {
+                return std::move(results);
+            }
+        };
+        return Awaiter{*this, resumeOn, std::move(requests), {}};
+    }
+};
+
+} // namespace reactor
@@ -0,0 +1,681 @@
+#include "Bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr int kBinCount = 16;
+constexpr float kRebuildCostRatio = 1.5f;
+constexpr size_t kMinChangesBeforeCheck = 64;
+
+// Leaves are enlarged by a tenth of their size plus a small constant, so jittering objects rarely
+// touch the tree
+Aabb fatten(const Aabb& bounds)
+{
+    const glm::vec3 margin = (bounds.max - bounds.min) * 0.1f + glm::vec3(0.05f);
+    return {bounds.min - margin, bounds.max + margin};
+}
+
+Aabb merge(const Aabb& a, const Aabb& b)
+{
+    Aabb result = a;
+    result.grow(b);
+    return result;
+}
+
+// Distance along the ray to where it enters bounds, clamped to zero when the origin is inside,
+// or infinity on a miss
+float rayEntry(const Aabb& bounds, const glm::vec3& origin, const glm::vec3& invDirection)
+{
+    const glm::vec3 t0 = (bounds.min - origin) * invDirection;
+    const glm::vec3 t1 = (bounds.max - origin) * invDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float enter = std::max({tNear.x, tNear.y, tNear.z, 0.0f});
+    const float exit = std::min({tFar.x, tFar.y, tFar.z});
+    return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+float distanceSquared(const Aabb& bounds, const glm::vec3& point)
+{
+    const glm::vec3 d = glm::max(glm::max(bounds.min - point, point - bounds.max), glm::vec3(0.0f));
+    return glm::dot(d, d);
+}
+
+enum class Containment
+{
+    Outside,
+    Intersecting,
+    Inside,
+};
+
+Containment classify(const Frustum& frustum, const Aabb& bounds)
+{
+    Containment result = Containment::Inside;
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        const glm::vec3 normal(plane);
+        // Corners furthest along and against the plane normal
+        const glm::vec3 positive = glm::mix(bounds.min, bounds.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+        const glm::vec3 negative = glm::mix(bounds.max, bounds.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+        if (glm::dot(normal, positive) + plane.w < 0.0f)
+        {
+            return Containment::Outside;
+        }
+        if (glm::dot(normal, negative) + plane.w < 0.0f)
+        {
+            result = Containment::Intersecting;
+        }
+    }
+    return result;
+}
+} // namespace
+
+uint32_t DynamicBvh::allocateNode()
+{
+    if (!m_freeNodes.empty())
+    {
+        const uint32_t node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        m_nodes[node] = Node{};
+        return node;
+    }
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void DynamicBvh::freeNode(uint32_t node)
+{
+    m_nodes[node] = Node{};
+    m_freeNodes.push_back(node);
+}
+
+void DynamicBvh::insert(uint32_t slot, const Aabb& bounds)
+{
+    if (slot >= m_leafOf.size())
+    {
+        m_leafOf.resize(slot + 1, kNone);
+        m_exact.resize(slot + 1);
+    }
+
+    const uint32_t leaf = allocateNode();
+    m_nodes[leaf].bounds = fatten(bounds);
+    m_nodes[leaf].slot = slot;
+    m_exact[slot] = bounds;
+    m_leafOf[slot] = leaf;
+    m_pendingInserts.push_back(slot);
+
+    m_leafCount++;
+    m_changesSinceBuild++;
+}
+
+bool DynamicBvh::isLinked(uint32_t leaf) const
+{
+    return leaf == m_root || m_nodes[leaf].parent != kNone;
+}
+
+void DynamicBvh::remove(uint32_t slot)
+{
+    const uint32_t leaf = m_leafOf[slot];
+    if (isLinked(leaf))
+    {
+        removeLeaf(leaf);
+    }
+    freeNode(leaf);
+    m_leafOf[slot] = kNone;
+
+    m_leafCount--;
+    m_changesSinceBuild++;
+}
+
+void DynamicBvh::update(uint32_t slot, const Aabb& bounds)
+{
+    if (!contains(slot))
+    {
+        insert(slot, bounds);
+        return;
+    }
+
+    m_exact[slot] = bounds;
+    if (!m_nodes[m_leafOf[slot]].bounds.contains(bounds))
+    {
+        m_pending.push_back(slot);
+    }
+}
+
+void DynamicBvh::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_root = kNone;
+    m_leafOf.clear();
+    m_exact.clear();
+    m_leafCount = 0;
+    m_pending.clear();
+    m_pendingInserts.clear();
+    m_changesSinceBuild = 0;
+    m_builtCost = 0.0f;
+}
+
+void DynamicBvh::refit()
+{
+    // A large batch of new leaves, such as a scene load, builds better and faster from scratch
+    if (m_pendingInserts.size() > std::max(kMinChangesBeforeCheck, m_leafCount / 4))
+    {
+        rebuild();
+        return;
+    }
+    for (uint32_t slot : m_pendingInserts)
+    {
+        if (contains(slot) && !isLinked(m_leafOf[slot]))
+        {
+            m_nodes[m_leafOf[slot]].bounds = fatten(m_exact[slot]);
+            insertLeaf(m_leafOf[slot]);
+        }
+    }
+    m_pendingInserts.clear();
+
+    for (uint32_t slot : m_pending)
+    {
+        if (!contains(slot) || !isLinked(m_leafOf[slot]))
+        {
+            continue;
+        }
+        const uint32_t leaf = m_leafOf[slot];
+        if (m_nodes[leaf].bounds.contains(m_exact[slot]))
+        {
+            continue; // queued twice
+        }
+
+        // Growing in place keeps the structure; a leaf that jumped away is reinserted instead, or
+        // its old ancestors would stretch across both places
+        const Aabb bounds = fatten(m_exact[slot]);
+        if (m_nodes[leaf].bounds.overlaps(bounds))
+        {
+            m_nodes[leaf].bounds = bounds;
+            refitUpwards(m_nodes[leaf].parent);
+        }
+        else
+        {
+            removeLeaf(leaf);
+            m_nodes[leaf].bounds = bounds;
+            insertLeaf(leaf);
+        }
+        m_changesSinceBuild++;
+    }
+    m_pending.clear();
+
+    if (m_changesSinceBuild > std::max(kMinChangesBeforeCheck, m_leafCount / 4))
+    {
+        if (m_builtCost == 0.0f || cost() > m_builtCost * kRebuildCostRatio)
+        {
+            rebuild();
+        }
+        else
+        {
+            m_changesSinceBuild = 0;
+        }
+    }
+}
+
+void DynamicBvh::rebuild()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_pending.clear();
+    m_pendingInserts.clear();
+    m_nodes.reserve(m_leafCount * 2);
+
+    std::vector<uint32_t> leaves;
+    leaves.reserve(m_leafCount);
+    for (uint32_t slot = 0; slot < m_leafOf.size(); ++slot)
+    {
+        if (m_leafOf[slot] == kNone)
+        {
+            continue;
+        }
+        const uint32_t leaf = allocateNode();
+        m_nodes[leaf].bounds = fatten(m_exact[slot]);
+        m_nodes[leaf].slot = slot;
+        m_leafOf[slot] = leaf;
+        leaves.push_back(leaf);
+    }
+
+    m_root = leaves.empty() ? kNone : buildRange(leaves, 0, leaves.size());
+    if (m_root != kNone)
+    {
+        m_nodes[m_root].parent = kNone;
+    }
+    m_builtCost = cost();
+    m_changesSinceBuild = 0;
+}
+
+uint32_t DynamicBvh::buildRange(std::vector<uint32_t>& leaves, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+    {
+        return leaves[begin];
+    }
+
+    Aabb centroids;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const glm::vec3 c = m_nodes[leaves[i]].bounds.center();
+        centroids.grow({c, c});
+    }
+    const glm::vec3 extent = centroids.max - centroids.min;
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    size_t middle = begin + (end - begin) / 2;
+    if (extent[axis] > 0.0f)
+    {
+        // Binned SAH: place centroids into buckets along the widest axis and split between the
+        // buckets that minimise count-weighted child area
+        const float scale = kBinCount / extent[axis];
+        auto binOf = [&](uint32_t leaf) {
+            const float c = m_nodes[leaf].bounds.center()[axis];
+            return std::min(kBinCount - 1, static_cast<int>((c - centroids.min[axis]) * scale));
+        };
+
+        std::array<Aabb, kBinCount> binBounds{};
+        std::array<size_t, kBinCount> binCounts{};
+        for (size_t i = begin; i < end; ++i)
+        {
+            const int bin = binOf(leaves[i]);
+            binBounds[bin].grow(m_nodes[leaves[i]].bounds);
+            binCounts[bin]++;
+        }
+
+        std::array<float, kBinCount> rightCost{};
+        Aabb accumulated;
+        size_t count = 0;
+        for (int bin = kBinCount - 1; bin > 0; --bin)
+        {
+            accumulated.grow(binBounds[bin]);
+            count += binCounts[bin];
+            rightCost[bin] = count > 0 ? accumulated.surfaceArea() * static_cast<float>(count) : 0.0f;
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+        accumulated = Aabb{};
+        count = 0;
+        for (int bin = 0; bin < kBinCount - 1; ++bin)
+        {
+            accumulated.grow(binBounds[bin]);
+            count += binCounts[bin];
+            if (count == 0 || count == end - begin)
+            {
+                continue;
+            }
+            const float splitCost = accumulated.surfaceArea() * static_cast<float>(count) + rightCost[bin + 1];
+            if (splitCost < bestCost)
+            {
+                bestCost = splitCost;
+                bestSplit = bin;
+            }
+        }
+
+        if (bestSplit >= 0)
+        {
+            const auto split = std::partition(leaves.begin() + static_cast<std::ptrdiff_t>(begin),
+                                              leaves.begin() + static_cast<std::ptrdiff_t>(end),
+                                              [&](uint32_t leaf) { return binOf(leaf) <= bestSplit; });
+            middle = static_cast<size_t>(split - leaves.begin());
+        }
+    }
+    if (middle == begin || middle == end)
+    {
+        middle = begin + (end - begin) / 2;
+    }
+
+    const uint32_t node = allocateNode();
+    const uint32_t left = buildRange(leaves, begin, middle);
+    const uint32_t right = buildRange(leaves, middle, end);
+    m_nodes[node].left = left;
+    m_nodes[node].right = right;
+    m_nodes[node].bounds = merge(m_nodes[left].bounds, m_nodes[right].bounds);
+    m_nodes[left].parent = node;
+    m_nodes[right].parent = node;
+    return node;
+}
+
+void DynamicBvh::insertLeaf(uint32_t leaf)
+{
+    if (m_root == kNone)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = kNone;
+        return;
+    }
+
+    // Walk down towards the sibling that adds the least area to the tree, stopping when pairing
+    // with the current node is cheaper than descending further
+    const Aabb leafBounds = m_nodes[leaf].bounds;
+    uint32_t index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = node.bounds.surfaceArea();
+        const float combinedArea = merge(node.bounds, leafBounds).surfaceArea();
+
+        const float pairCost = 2.0f * combinedArea;
+        const float inheritedCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](uint32_t child) {
+            const Aabb& childBounds = m_nodes[child].bounds;
+            const float merged = merge(childBounds, leafBounds).surfaceArea();
+            return (m_nodes[child].isLeaf() ? merged : merged - childBounds.surfaceArea()) + inheritedCost;
+        };
+        const float leftCost = descendCost(node.left);
+        const float rightCost = descendCost(node.right);
+
+        if (pairCost < leftCost && pairCost < rightCost)
+        {
+            break;
+        }
+        index = leftCost < rightCost ? node.left : node.right;
+    }
+
+    const uint32_t sibling = index;
+    const uint32_t oldParent = m_nodes[sibling].parent;
+    const uint32_t newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].left = sibling;
+    m_nodes[newParent].right = leaf;
+    m_nodes[newParent].bounds = merge(m_nodes[sibling].bounds, leafBounds);
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent == kNone)
+    {
+        m_root = newParent;
+    }
+    else
+    {
+        replaceChild(oldParent, sibling, newParent);
+        refitUpwards(oldParent);
+    }
+}
+
+void DynamicBvh::removeLeaf(uint32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = kNone;
+        return;
+    }
+
+    const uint32_t parent = m_nodes[leaf].parent;
+    const uint32_t grandParent = m_nodes[parent].parent;
+    const uint32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+    if (grandParent == kNone)
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = kNone;
+    }
+    else
+    {
+        replaceChild(grandParent, parent, sibling);
+        m_nodes[sibling].parent = grandParent;
+        refitUpwards(grandParent);
+    }
+    freeNode(parent);
+    m_nodes[leaf].parent = kNone;
+}
+
+void DynamicBvh::replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild)
+{
+    if (m_nodes[parent].left == oldChild)
+    {
+        m_nodes[parent].left = newChild;
+    }
+    else
+    {
+        m_nodes[parent].right = newChild;
+    }
+}
+
+void DynamicBvh::refitUpwards(uint32_t node)
+{
+    while (node != kNone)
+    {
+        Node& current = m_nodes[node];
+        current.bounds = merge(m_nodes[current.left].bounds, m_nodes[current.right].bounds);
+        node = current.parent;
+    }
+}
+
+float DynamicBvh::cost() const
+{
+    if (m_root == kNone || m_nodes[m_root].isLeaf())
+    {
+        return 0.0f;
+    }
+
+    float total = 0.0f;
+    std::vector<uint32_t> stack{m_root};
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.isLeaf())
+        {
+            continue;
+        }
+        total += node.bounds.surfaceArea();
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+    const float rootArea = m_nodes[m_root].bounds.surfaceArea();
+    return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+BvhRayHit DynamicBvh::raycast(const glm::vec3& origin,
+                              const glm::vec3& direction,
+                              float maxDistance,
+                              const std::function<bool(uint32_t, float&)>& intersect) const
+{
+    BvhRayHit best;
+    best.distance = maxDistance;
+    if (m_root == kNone)
+    {
+        return best;
+    }
+
+    const glm::vec3 invDirection = 1.0f / direction;
+    std::vector<std::pair<uint32_t, float>> stack;
+    stack.reserve(64);
+    stack.emplace_back(m_root, rayEntry(m_nodes[m_root].bounds, origin, invDirection));
+
+    while (!stack.empty())
+    {
+        const auto [index, entry] = stack.back();
+        stack.pop_back();
+        if (entry > best.distance)
+        {
+            continue;
+        }
+
+        const Node& node = m_nodes[index];
+        if (node.isLeaf())
+        {
+            float distance = rayEntry(m_exact[node.slot], origin, invDirection);
+            if (distance > best.distance || (intersect && !intersect(node.slot, distance)))
+            {
+                continue;
+            }
+            if (distance <= best.distance)
+            {
+                best = {node.slot, distance};
+            }
+            continue;
+        }
+
+        // Nearer child on top so it is visited first and tightens the bound for the other
+        const float leftEntry = rayEntry(m_nodes[node.left].bounds, origin, invDirection);
+        const float rightEntry = rayEntry(m_nodes[node.right].bounds, origin, invDirection);
+        if (leftEntry < rightEntry)
+        {
+            stack.emplace_back(node.right, rightEntry);
+            stack.emplace_back(node.left, leftEntry);
+        }
+        else
+        {
+            stack.emplace_back(node.left, leftEntry);
+            stack.emplace_back(node.right, rightEntry);
+        }
+    }
+    return best;
+}
+
+void DynamicBvh::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& slots) const
+{
+    if (m_root == kNone)
+    {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, bool>> stack; // node, known to be inside
+    stack.reserve(64);
+    stack.emplace_back(m_root, false);
+    while (!stack.empty())
+    {
+        const auto [index, inside] = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[index];
+        Containment containment = Containment::Inside;
+        if (!inside)
+        {
+            containment = classify(frustum, node.isLeaf() ? m_exact[node.slot] : node.bounds);
+            if (containment == Containment::Outside)
+            {
+                continue;
+            }
+        }
+
+        if (node.isLeaf())
+        {
+            slots.push_back(node.slot);
+            continue;
+        }
+        // Subtrees fully inside skip every further plane test
+        const bool childInside = containment == Containment::Inside;
+        stack.emplace_back(node.left, childInside);
+        stack.emplace_back(node.right, childInside);
+    }
+}
+
+void DynamicBvh::queryOverlap(const Aabb& bounds, std::vector<uint32_t>& slots) const
+{
+    if (m_root == kNone)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> stack{m_root};
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.isLeaf())
+        {
+            if (m_exact[node.slot].overlaps(bounds))
+            {
+                slots.push_back(node.slot);
+            }
+        }
+        else if (node.bounds.overlaps(bounds))
+        {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+void DynamicBvh::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& slots) const
+{
+    if (m_root == kNone)
+    {
+        return;
+    }
+
+    const float radiusSquared = radius * radius;
+    std::vector<uint32_t> stack{m_root};
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.isLeaf())
+        {
+            if (distanceSquared(m_exact[node.slot], center) <= radiusSquared)
+            {
+                slots.push_back(node.slot);
+            }
+        }
+        else if (distanceSquared(node.bounds, center) <= radiusSquared)
+        {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+uint32_t DynamicBvh::nearest(const glm::vec3& point, float maxDistance) const
+{
+    uint32_t bestSlot = kNone;
+    float bestSquared = maxDistance < std::numeric_limits<float>::max() ? maxDistance * maxDistance
+                                                                        : std::numeric_limits<float>::max();
+    if (m_root == kNone)
+    {
+        return bestSlot;
+    }
+
+    std::vector<std::pair<uint32_t, float>> stack;
+    stack.reserve(64);
+    stack.emplace_back(m_root, distanceSquared(m_nodes[m_root].bounds, point));
+    while (!stack.empty())
+    {
+        const auto [index, lowerBound] = stack.back();
+        stack.pop_back();
+        if (lowerBound > bestSquared)
+        {
+            continue;
+        }
+
+        const Node& node = m_nodes[index];
+        if (node.isLeaf())
+        {
+            const float d = distanceSquared(m_exact[node.slot], point);
+            if (d <= bestSquared)
+            {
+                bestSquared = d;
+                bestSlot = node.slot;
+            }
+            continue;
+        }
+
+        const float leftDistance = distanceSquared(m_nodes[node.left].bounds, point);
+        const float rightDistance = distanceSquared(m_nodes[node.right].bounds, point);
+        if (leftDistance < rightDistance)
+        {
+            stack.emplace_back(node.right, rightDistance);
+            stack.emplace_back(node.left, leftDistance);
+        }
+        else
+        {
+            stack.emplace_back(node.left, leftDistance);
+            stack.emplace_back(node.right, rightDistance);
+        }
+    }
+    return bestSlot;
+}
+
+} // namespace reactor
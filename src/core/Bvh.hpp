@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Culling.hpp"
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace reactor
+{
+
+struct Aabb
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    static Aabb fromSphere(const BoundingSphere& sphere)
+    {
+        return {sphere.center - glm::vec3(sphere.radius), sphere.center + glm::vec3(sphere.radius)};
+    }
+
+    [[nodiscard]] bool valid() const
+    {
+        return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+    }
+    [[nodiscard]] glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+    [[nodiscard]] float surfaceArea() const
+    {
+        const glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    [[nodiscard]] bool contains(const Aabb& other) const
+    {
+        return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+    }
+    [[nodiscard]] bool overlaps(const Aabb& other) const
+    {
+        return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+    }
+    void grow(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+};
+
+struct BvhRayHit
+{
+    uint32_t slot = std::numeric_limits<uint32_t>::max();
+    float distance = std::numeric_limits<float>::max();
+
+    [[nodiscard]] bool hit() const
+    {
+        return slot != std::numeric_limits<uint32_t>::max();
+    }
+};
+
+// Bounding volume hierarchy over boxes keyed by caller-chosen slots, one box per leaf. The tree is
+// built top-down with a binned surface area heuristic and then kept current incrementally: leaves
+// hold slightly enlarged boxes so small moves cost nothing, larger moves refit the ancestors, and a
+// leaf that leaves its old neighbourhood is reinserted where the heuristic puts it. Once the tree
+// has drifted well past its built cost it is rebuilt. Queries test the exact boxes at the leaves.
+class DynamicBvh
+{
+public:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    // Insertions and moves take effect at the next refit().
+    void insert(uint32_t slot, const Aabb& bounds);
+    void remove(uint32_t slot);
+    // Inserts slot when it is not in the tree yet.
+    void update(uint32_t slot, const Aabb& bounds);
+    void clear();
+
+    [[nodiscard]] bool contains(uint32_t slot) const
+    {
+        return slot < m_leafOf.size() && m_leafOf[slot] != kNone;
+    }
+
+    // Applies pending insertions and moves; queries see them only after this. Rebuilds when the
+    // tree has degraded or when many leaves arrive at once.
+    void refit();
+    void rebuild();
+
+    // Nearest slot whose box the ray enters within maxDistance. When intersect is given it refines
+    // each candidate: it receives the slot and the box entry distance and returns false on a miss
+    // or true with the distance updated to the exact hit.
+    [[nodiscard]] BvhRayHit raycast(const glm::vec3& origin,
+                                    const glm::vec3& direction,
+                                    float maxDistance,
+                                    const std::function<bool(uint32_t, float&)>& intersect = {}) const;
+
+    // Appends slots whose boxes intersect the query volume.
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& slots) const;
+    void queryOverlap(const Aabb& bounds, std::vector<uint32_t>& slots) const;
+    void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& slots) const;
+
+    // Slot whose box is closest to point, or kNone when none is within maxDistance.
+    [[nodiscard]] uint32_t nearest(const glm::vec3& point,
+                                   float maxDistance = std::numeric_limits<float>::max()) const;
+
+    [[nodiscard]] size_t leafCount() const
+    {
+        return m_leafCount;
+    }
+    // Sum of internal node areas relative to the root; the expected traversal cost of a query.
+    [[nodiscard]] float cost() const;
+
+private:
+    struct Node
+    {
+        Aabb bounds; // enlarged at leaves
+        uint32_t parent = kNone;
+        uint32_t left = kNone; // kNone at leaves
+        uint32_t right = kNone;
+        uint32_t slot = kNone;
+
+        [[nodiscard]] bool isLeaf() const
+        {
+            return left == kNone;
+        }
+    };
+
+    [[nodiscard]] bool isLinked(uint32_t leaf) const;
+    uint32_t allocateNode();
+    void freeNode(uint32_t node);
+    void insertLeaf(uint32_t leaf);
+    void removeLeaf(uint32_t leaf);
+    void refitUpwards(uint32_t node);
+    uint32_t buildRange(std::vector<uint32_t>& leaves, size_t begin, size_t end);
+    void replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild);
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_freeNodes;
+    uint32_t m_root = kNone;
+
+    std::vector<uint32_t> m_leafOf; // indexed by slot
+    std::vector<Aabb> m_exact;      // indexed by slot
+    size_t m_leafCount = 0;
+
+    std::vector<uint32_t> m_pendingInserts; // new leaves awaiting refit()
+    std::vector<uint32_t> m_pending;        // moved leaves awaiting refit()
+    size_t m_changesSinceBuild = 0;
+    float m_builtCost = 0.0f;
+};
+
+} // namespace reactor
@@ -32,6 +32,14 @@ void Camera::setPerspective(float fov, float aspect, float near, float far) {
     m_projDirty = true;
 }
 
+void Camera::setFOV(float fov) {
+    if (fov <= 0.0f || fov >= 180.0f) {
+        throw std::invalid_argument("Invalid camera field of view");
+    }
+    m_fov = fov;
+    m_projDirty = true;
+}
+
 void Camera::setPosition(const glm::vec3& position) {
     m_position = position;
     m_viewDirty = true;
@@ -125,6 +133,10 @@ float Camera::getDistanceToTarget() const {
     return 1.0;
 }
 
+Frustum Camera::getFrustum() const {
+    return Frustum::fromMatrix(getProjectionMatrix() * getViewMatrix());
+}
+
 void Camera::updateView() {
     glm::mat4 rotation = glm::toMat4(glm::conjugate(m_orientation));
     glm::mat4 translation = glm::translate(glm::mat4(1.0f), -m_position);
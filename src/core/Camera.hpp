@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Frustum.hpp"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -17,6 +19,7 @@ public:
 
     void setProjectionType(ProjectionType type);
     void setPerspective(float fov, float aspect, float near, float far);
+    void setFOV(float fov);
 
     void setPosition(const glm::vec3& position);
     void setTarget(const glm::vec3& target);
@@ -38,6 +41,7 @@ public:
     glm::vec3 getRight() const;
     glm::vec3 getUp() const;
     float getDistanceToTarget() const;
+    Frustum getFrustum() const;
 
 private:
     void updateView();
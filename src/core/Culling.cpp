@@ -0,0 +1,112 @@
+#include "Culling.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define REACTOR_CULL_AVX2 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define REACTOR_CULL_SSE 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace reactor
+{
+
+namespace
+{
+// Spheres from first to last one at a time; handles the tail the vector loops leave.
+void cullScalar(const Frustum& frustum, const BoundsArrays& bounds, size_t first, size_t last,
+                std::vector<uint32_t>& visible)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        if (frustum.intersectsSphere(glm::vec3(bounds.x[i], bounds.y[i], bounds.z[i]), bounds.radius[i]))
+        {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Pushes base + i for every set bit i of mask
+inline void appendMask(uint32_t mask, size_t base, std::vector<uint32_t>& visible)
+{
+    while (mask != 0)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+#else
+        const int bit = __builtin_ctz(mask);
+#endif
+        visible.push_back(static_cast<uint32_t>(base + bit));
+        mask &= mask - 1;
+    }
+}
+} // namespace
+
+void cullSpheres(const Frustum& frustum, const BoundsArrays& bounds, std::vector<uint32_t>& visible)
+{
+    const size_t count = bounds.size();
+    size_t i = 0;
+
+    // A sphere is outside once its centre lies further than its radius behind any plane. Each lane
+    // tests one sphere against all six planes.
+#if defined(REACTOR_CULL_AVX2)
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        px[p] = _mm256_set1_ps(frustum.planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(bounds.x.data() + i);
+        const __m256 y = _mm256_loadu_ps(bounds.y.data() + i);
+        const __m256 z = _mm256_loadu_ps(bounds.z.data() + i);
+        const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(bounds.radius.data() + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)),
+                                                  _mm256_add_ps(_mm256_mul_ps(pz[p], z), pw[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+        appendMask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, visible);
+    }
+#elif defined(REACTOR_CULL_SSE)
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(bounds.x.data() + i);
+        const __m128 y = _mm_loadu_ps(bounds.y.data() + i);
+        const __m128 z = _mm_loadu_ps(bounds.z.data() + i);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(bounds.radius.data() + i));
+
+        __m128 inside = _mm_cmpeq_ps(x, x); // all ones, unless x is NaN
+        for (int p = 0; p < 6; ++p)
+        {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)), _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+        appendMask(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, visible);
+    }
+#endif
+
+    cullScalar(frustum, bounds, i, count, visible);
+}
+
+} // namespace reactor
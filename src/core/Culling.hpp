@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace reactor
+{
+
+struct BoundingSphere
+{
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+};
+
+// Bounding spheres split into one array per component, the layout the culling kernel loads several
+// lanes at a time from.
+struct BoundsArrays
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    [[nodiscard]] size_t size() const
+    {
+        return x.size();
+    }
+    [[nodiscard]] BoundingSphere get(size_t i) const
+    {
+        return {glm::vec3(x[i], y[i], z[i]), radius[i]};
+    }
+    void set(size_t i, const BoundingSphere& sphere)
+    {
+        x[i] = sphere.center.x;
+        y[i] = sphere.center.y;
+        z[i] = sphere.center.z;
+        radius[i] = sphere.radius;
+    }
+    void push_back(const BoundingSphere& sphere)
+    {
+        x.push_back(sphere.center.x);
+        y.push_back(sphere.center.y);
+        z.push_back(sphere.center.z);
+        radius.push_back(sphere.radius);
+    }
+    void pop_back()
+    {
+        x.pop_back();
+        y.pop_back();
+        z.pop_back();
+        radius.pop_back();
+    }
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+        radius.clear();
+    }
+};
+
+// Appends the indices of spheres that intersect frustum to visible, in ascending order. Uses AVX2
+// when built with REACTOR_ENABLE_AVX2, SSE on other x86 builds, and scalar code otherwise.
+void cullSpheres(const Frustum& frustum, const BoundsArrays& bounds, std::vector<uint32_t>& visible);
+
+} // namespace reactor
@@ -0,0 +1,59 @@
+#include "Frustum.hpp"
+
+namespace reactor
+{
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+{
+    // Rows of the column-major matrix; clip space is inside when -w <= x, y <= w and 0 <= z <= w
+    auto row = [&](int r) {
+        return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    };
+    const glm::vec4 x = row(0);
+    const glm::vec4 y = row(1);
+    const glm::vec4 z = row(2);
+    const glm::vec4 w = row(3);
+
+    Frustum frustum;
+    frustum.planes[Left] = w + x;
+    frustum.planes[Right] = w - x;
+    frustum.planes[Bottom] = w + y;
+    frustum.planes[Top] = w - y;
+    frustum.planes[Near] = z;
+    frustum.planes[Far] = w - z;
+
+    for (glm::vec4& plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& lo, const glm::vec3& hi) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        // The corner furthest along the plane's normal
+        const glm::vec3 corner(
+            plane.x >= 0.0f ? hi.x : lo.x, plane.y >= 0.0f ? hi.y : lo.y, plane.z >= 0.0f ? hi.z : lo.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace reactor
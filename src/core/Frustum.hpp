@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace reactor
+{
+
+// Six planes facing inwards, each normalised so dot(xyz, p) + w is the signed distance of point p.
+struct Frustum
+{
+    enum Plane
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+    };
+
+    std::array<glm::vec4, 6> planes{};
+
+    // Extracts the planes of a view-projection matrix with a [0, 1] clip depth range.
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    [[nodiscard]] bool intersectsSphere(const glm::vec3& center, float radius) const;
+
+    // Conservative: boxes near a corner of the frustum may pass while outside it.
+    [[nodiscard]] bool intersectsBox(const glm::vec3& lo, const glm::vec3& hi) const;
+};
+
+} // namespace reactor
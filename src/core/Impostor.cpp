@@ -0,0 +1,414 @@
+#include "Impostor.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kImpostorVersion = 1;
+constexpr uint32_t kMaxGridSize = 64;
+constexpr uint32_t kMaxAtlasSize = 8192;
+constexpr int kDilationPasses = 2;
+
+uint32_t pack(const glm::vec4& value)
+{
+    const glm::vec4 scaled = glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return static_cast<uint32_t>(scaled.r) | static_cast<uint32_t>(scaled.g) << 8
+           | static_cast<uint32_t>(scaled.b) << 16 | static_cast<uint32_t>(scaled.a) << 24;
+}
+
+glm::vec4 unpack(uint32_t texel)
+{
+    return glm::vec4(texel & 0xFF, (texel >> 8) & 0xFF, (texel >> 16) & 0xFF, texel >> 24) / 255.0f;
+}
+
+// Twice the signed area of (a, b, p); positive when p lies to the left of a->b
+float edge(const glm::vec3& a, const glm::vec3& b, float px, float py)
+{
+    return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+// Fills uncovered texels next to covered ones with their neighbours' average, staying inside the
+// frame so nothing bleeds between views. Coverage stays zero.
+void dilate(ImpostorAtlas& atlas)
+{
+    const uint32_t size = atlas.size();
+    const auto frame = static_cast<int>(atlas.frameSize);
+    std::vector<uint8_t> filled(atlas.albedo.size());
+    for (size_t i = 0; i < filled.size(); ++i)
+    {
+        filled[i] = (atlas.albedo[i] >> 24) != 0 ? 1 : 0;
+    }
+
+    std::vector<uint8_t> next;
+    for (int pass = 0; pass < kDilationPasses; ++pass)
+    {
+        next = filled;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const size_t texel = static_cast<size_t>(y) * size + x;
+                if (filled[texel])
+                {
+                    continue;
+                }
+
+                const int frameX = static_cast<int>(x) / frame * frame;
+                const int frameY = static_cast<int>(y) / frame * frame;
+                glm::vec3 colour(0.0f);
+                glm::vec4 normalDepth(0.0f);
+                int count = 0;
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        const int nx = static_cast<int>(x) + dx;
+                        const int ny = static_cast<int>(y) + dy;
+                        if (nx < frameX || ny < frameY || nx >= frameX + frame || ny >= frameY + frame)
+                        {
+                            continue;
+                        }
+                        const size_t neighbour = static_cast<size_t>(ny) * size + static_cast<size_t>(nx);
+                        if (filled[neighbour])
+                        {
+                            colour += glm::vec3(unpack(atlas.albedo[neighbour]));
+                            normalDepth += unpack(atlas.normalDepth[neighbour]);
+                            ++count;
+                        }
+                    }
+                }
+                if (count > 0)
+                {
+                    atlas.albedo[texel] = pack(glm::vec4(colour / static_cast<float>(count), 0.0f));
+                    atlas.normalDepth[texel] = pack(normalDepth / static_cast<float>(count));
+                    next[texel] = 1;
+                }
+            }
+        }
+        filled.swap(next);
+    }
+}
+} // namespace
+
+glm::vec2 impostorGridCoord(const glm::vec3& direction)
+{
+    const glm::vec3 d(direction.x, std::max(direction.y, 0.0f), direction.z);
+    const float sum = std::abs(d.x) + d.y + std::abs(d.z);
+    if (sum <= 0.0f)
+    {
+        return glm::vec2(0.5f);
+    }
+    // Octahedral projection of the hemisphere, turned 45 degrees so the diamond fills the square
+    const glm::vec2 q(d.x / sum, d.z / sum);
+    return glm::vec2(q.x + q.y, q.x - q.y) * 0.5f + 0.5f;
+}
+
+glm::vec3 impostorDirection(const glm::vec2& gridCoord)
+{
+    const glm::vec2 p = gridCoord * 2.0f - 1.0f;
+    const glm::vec2 q((p.x + p.y) * 0.5f, (p.x - p.y) * 0.5f);
+    return glm::normalize(glm::vec3(q.x, 1.0f - std::abs(q.x) - std::abs(q.y), q.y));
+}
+
+void impostorFrameBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up)
+{
+    const glm::vec3 side = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), direction);
+    const float length = glm::length(side);
+    right = length > 1e-4f ? side / length : glm::vec3(1.0f, 0.0f, 0.0f);
+    up = glm::cross(direction, right);
+}
+
+ImpostorAtlas bakeImpostor(const MeshData& mesh, uint32_t gridSize, uint32_t frameSize)
+{
+    ImpostorAtlas atlas;
+    atlas.gridSize = gridSize;
+    atlas.frameSize = frameSize;
+    const uint32_t size = atlas.size();
+    atlas.albedo.assign(static_cast<size_t>(size) * size, 0);
+    atlas.normalDepth.assign(static_cast<size_t>(size) * size, 0);
+    if (mesh.vertices.empty() || mesh.indices.size() < 3)
+    {
+        return atlas;
+    }
+
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        lo = glm::min(lo, vertex.pos);
+        hi = glm::max(hi, vertex.pos);
+    }
+    atlas.center = (lo + hi) * 0.5f;
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        atlas.radius = std::max(atlas.radius, glm::length(vertex.pos - atlas.center));
+    }
+    atlas.radius = std::max(atlas.radius, 1e-6f);
+
+    // Per view: x and y in frame pixels, z toward the viewer in radii
+    std::vector<glm::vec3> projected(mesh.vertices.size());
+    std::vector<float> depth(static_cast<size_t>(frameSize) * frameSize);
+    const float half = static_cast<float>(frameSize) * 0.5f;
+    const float scale = half / atlas.radius;
+
+    for (uint32_t frameY = 0; frameY < gridSize; ++frameY)
+    {
+        for (uint32_t frameX = 0; frameX < gridSize; ++frameX)
+        {
+            const glm::vec3 direction = impostorDirection(
+                (glm::vec2(frameX, frameY) + 0.5f) / static_cast<float>(gridSize));
+            glm::vec3 right;
+            glm::vec3 up;
+            impostorFrameBasis(direction, right, up);
+
+            for (size_t v = 0; v < mesh.vertices.size(); ++v)
+            {
+                const glm::vec3 offset = mesh.vertices[v].pos - atlas.center;
+                projected[v] = glm::vec3(half + glm::dot(offset, right) * scale,
+                                         half - glm::dot(offset, up) * scale,
+                                         glm::dot(offset, direction) / atlas.radius);
+            }
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::lowest());
+
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+            {
+                const uint32_t i0 = mesh.indices[t];
+                const uint32_t i1 = mesh.indices[t + 1];
+                const uint32_t i2 = mesh.indices[t + 2];
+                if (i0 >= projected.size() || i1 >= projected.size() || i2 >= projected.size())
+                {
+                    continue;
+                }
+                const glm::vec3& a = projected[i0];
+                const glm::vec3& b = projected[i1];
+                const glm::vec3& c = projected[i2];
+
+                // Dividing by the signed area makes the weights positive inside for either winding
+                const float area = edge(a, b, c.x, c.y);
+                if (std::abs(area) < 1e-12f)
+                {
+                    continue;
+                }
+
+                const auto clampPixel = [&](float value) {
+                    return std::clamp(static_cast<int>(std::floor(value)), 0, static_cast<int>(frameSize) - 1);
+                };
+                const int x0 = clampPixel(std::min({a.x, b.x, c.x}));
+                const int x1 = clampPixel(std::max({a.x, b.x, c.x}));
+                const int y0 = clampPixel(std::min({a.y, b.y, c.y}));
+                const int y1 = clampPixel(std::max({a.y, b.y, c.y}));
+
+                for (int y = y0; y <= y1; ++y)
+                {
+                    for (int x = x0; x <= x1; ++x)
+                    {
+                        const float px = static_cast<float>(x) + 0.5f;
+                        const float py = static_cast<float>(y) + 0.5f;
+                        const float w0 = edge(b, c, px, py) / area;
+                        const float w1 = edge(c, a, px, py) / area;
+                        const float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        {
+                            continue;
+                        }
+
+                        const float z = w0 * a.z + w1 * b.z + w2 * c.z;
+                        float& nearest = depth[static_cast<size_t>(y) * frameSize + static_cast<size_t>(x)];
+                        if (z <= nearest)
+                        {
+                            continue;
+                        }
+                        nearest = z;
+
+                        const Vertex& v0 = mesh.vertices[i0];
+                        const Vertex& v1 = mesh.vertices[i1];
+                        const Vertex& v2 = mesh.vertices[i2];
+                        const glm::vec3 colour = w0 * v0.color + w1 * v1.color + w2 * v2.color;
+                        glm::vec3 normal = w0 * v0.normal + w1 * v1.normal + w2 * v2.normal;
+                        const float length = glm::length(normal);
+                        normal = length > 0.0f ? normal / length : direction;
+                        // Two-sided geometry such as foliage cards shows its back to some views
+                        if (glm::dot(normal, direction) < 0.0f)
+                        {
+                            normal = -normal;
+                        }
+
+                        const size_t texel = (static_cast<size_t>(frameY) * frameSize + static_cast<size_t>(y)) * size
+                                             + static_cast<size_t>(frameX) * frameSize + static_cast<size_t>(x);
+                        atlas.albedo[texel] = pack(glm::vec4(colour, 1.0f));
+                        atlas.normalDepth[texel] = pack(glm::vec4(normal * 0.5f + 0.5f, z * 0.5f + 0.5f));
+                    }
+                }
+            }
+        }
+    }
+
+    dilate(atlas);
+    return atlas;
+}
+
+void generateImpostorMips(ImpostorAtlas& atlas)
+{
+    atlas.levelCount = 1;
+    while ((atlas.frameSize >> atlas.levelCount) >= 4)
+    {
+        ++atlas.levelCount;
+    }
+    atlas.albedo.resize(atlas.levelOffset(atlas.levelCount));
+    atlas.normalDepth.resize(atlas.levelOffset(atlas.levelCount));
+
+    for (uint32_t level = 1; level < atlas.levelCount; ++level)
+    {
+        const uint32_t sourceSize = atlas.size() >> (level - 1);
+        const uint32_t size = atlas.size() >> level;
+        const size_t source = atlas.levelOffset(level - 1);
+        const size_t destination = atlas.levelOffset(level);
+
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                // Colours and normals are averaged over covered texels only, so edges keep their colour
+                glm::vec3 colour(0.0f);
+                glm::vec3 fallbackColour(0.0f);
+                glm::vec4 normalDepth(0.0f);
+                glm::vec4 fallbackNormalDepth(0.0f);
+                float coverage = 0.0f;
+                for (uint32_t s = 0; s < 4; ++s)
+                {
+                    const size_t texel = source + static_cast<size_t>(y * 2 + s / 2) * sourceSize + x * 2 + s % 2;
+                    const glm::vec4 albedo = unpack(atlas.albedo[texel]);
+                    const glm::vec4 nd = unpack(atlas.normalDepth[texel]);
+                    colour += glm::vec3(albedo) * albedo.a;
+                    normalDepth += nd * albedo.a;
+                    fallbackColour += glm::vec3(albedo);
+                    fallbackNormalDepth += nd;
+                    coverage += albedo.a;
+                }
+                if (coverage > 0.0f)
+                {
+                    colour /= coverage;
+                    normalDepth /= coverage;
+                }
+                else
+                {
+                    colour = fallbackColour * 0.25f;
+                    normalDepth = fallbackNormalDepth * 0.25f;
+                }
+                const size_t texel = destination + static_cast<size_t>(y) * size + x;
+                atlas.albedo[texel] = pack(glm::vec4(colour, coverage * 0.25f));
+                atlas.normalDepth[texel] = pack(normalDepth);
+            }
+        }
+    }
+}
+
+bool writeImpostor(const std::string& path, const ImpostorAtlas& atlas)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open())
+    {
+        spdlog::error("Failed to open impostor for writing: {}", path);
+        return false;
+    }
+
+    const char magic[8] = "R_IMPST";
+    const size_t texels = static_cast<size_t>(atlas.size()) * atlas.size();
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char*>(&kImpostorVersion), sizeof(kImpostorVersion));
+    out.write(reinterpret_cast<const char*>(&atlas.gridSize), sizeof(atlas.gridSize));
+    out.write(reinterpret_cast<const char*>(&atlas.frameSize), sizeof(atlas.frameSize));
+    out.write(reinterpret_cast<const char*>(&atlas.center[0]), sizeof(glm::vec3));
+    out.write(reinterpret_cast<const char*>(&atlas.radius), sizeof(atlas.radius));
+    out.write(reinterpret_cast<const char*>(atlas.albedo.data()), static_cast<std::streamsize>(texels * sizeof(uint32_t)));
+    out.write(reinterpret_cast<const char*>(atlas.normalDepth.data()),
+              static_cast<std::streamsize>(texels * sizeof(uint32_t)));
+    return out.good();
+}
+
+bool parseImpostor(const char* data, size_t size, const std::string& name, ImpostorAtlas& atlas)
+{
+    constexpr size_t kHeaderSize = 8 + 3 * sizeof(uint32_t) + sizeof(glm::vec3) + sizeof(float);
+    if (size < kHeaderSize)
+    {
+        spdlog::error("Truncated impostor: {}", name);
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version;
+    memcpy(magic, data, sizeof(magic));
+    memcpy(&version, data + 8, sizeof(version));
+    memcpy(&atlas.gridSize, data + 12, sizeof(atlas.gridSize));
+    memcpy(&atlas.frameSize, data + 16, sizeof(atlas.frameSize));
+    memcpy(&atlas.center[0], data + 20, sizeof(glm::vec3));
+    memcpy(&atlas.radius, data + 32, sizeof(atlas.radius));
+
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_IMPST" || version != kImpostorVersion)
+    {
+        spdlog::error("Invalid impostor or version mismatch: {}", name);
+        return false;
+    }
+
+    // Frames must halve cleanly down the mip chain
+    const bool powerOfTwo = atlas.frameSize != 0 && (atlas.frameSize & (atlas.frameSize - 1)) == 0;
+    if (atlas.gridSize == 0 || atlas.gridSize > kMaxGridSize || !powerOfTwo || atlas.frameSize < 4
+        || atlas.size() > kMaxAtlasSize || !(atlas.radius > 0.0f))
+    {
+        spdlog::error("Impostor {} has an invalid layout", name);
+        return false;
+    }
+
+    const size_t texels = static_cast<size_t>(atlas.size()) * atlas.size();
+    if (size - kHeaderSize < 2 * texels * sizeof(uint32_t))
+    {
+        spdlog::error("Truncated impostor: {}", name);
+        return false;
+    }
+    atlas.levelCount = 1;
+    atlas.albedo.resize(texels);
+    atlas.normalDepth.resize(texels);
+    memcpy(atlas.albedo.data(), data + kHeaderSize, texels * sizeof(uint32_t));
+    memcpy(atlas.normalDepth.data(), data + kHeaderSize + texels * sizeof(uint32_t), texels * sizeof(uint32_t));
+    return true;
+}
+
+std::string impostorPath(const std::string& meshPath, uint32_t meshIndex)
+{
+    std::filesystem::path path(meshPath);
+    path.replace_extension();
+    return path.string() + "." + std::to_string(meshIndex) + ".impostor";
+}
+
+bool cookImpostors(const std::string& meshPath)
+{
+    const std::vector<MeshData> meshes = loadModelFromBinary(meshPath);
+    if (meshes.empty())
+    {
+        spdlog::error("No meshes to bake impostors from in {}", meshPath);
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < meshes.size(); ++i)
+    {
+        const std::string path = impostorPath(meshPath, i);
+        const ImpostorAtlas atlas = bakeImpostor(meshes[i]);
+        ok = writeImpostor(path, atlas) && ok;
+        spdlog::info("Baked {}: {}x{} views of {} pixels", path, atlas.gridSize, atlas.gridSize, atlas.frameSize);
+    }
+    return ok;
+}
+
+} // namespace reactor
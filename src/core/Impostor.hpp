@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ModelIO.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+// Octahedral impostor of one mesh: gridSize x gridSize orthographic views of the object taken from
+// the upper hemisphere, packed into one atlas of frameSize-pixel frames. Frame (x, y) looks at the
+// object from impostorDirection() of its centre. Two RGBA8 layers are kept per texel: albedo with
+// coverage in alpha, and the object-space normal with the depth toward the viewer in alpha, 0.5
+// at the bounding sphere's centre plane and 0 and 1 at its back and front.
+struct ImpostorAtlas
+{
+    uint32_t gridSize = 0;
+    uint32_t frameSize = 0;
+    uint32_t levelCount = 1; // mip levels held below, mip 0 first
+    glm::vec3 center{0.0f};  // object-space bounding sphere the frames are fitted to
+    float radius = 0.0f;
+    std::vector<uint32_t> albedo;
+    std::vector<uint32_t> normalDepth;
+
+    [[nodiscard]] uint32_t size() const
+    {
+        return gridSize * frameSize;
+    }
+    // Texel offset of a mip level within either layer
+    [[nodiscard]] size_t levelOffset(uint32_t level) const
+    {
+        size_t offset = 0;
+        for (uint32_t l = 0; l < level; ++l)
+        {
+            offset += static_cast<size_t>(size() >> l) * (size() >> l);
+        }
+        return offset;
+    }
+};
+
+// Maps a direction on the upper hemisphere (y up) to [0, 1]^2 and back. Directions below the
+// horizon map to the rim.
+glm::vec2 impostorGridCoord(const glm::vec3& direction);
+glm::vec3 impostorDirection(const glm::vec2& gridCoord);
+
+// Right and up axes of the frame looking from direction; impostor.vert builds the same basis.
+void impostorFrameBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up);
+
+// Renders the mesh from every frame direction on the CPU. Empty texels take the colour of their
+// covered neighbours so bilinear filtering along silhouettes does not fade to black.
+ImpostorAtlas bakeImpostor(const MeshData& mesh, uint32_t gridSize = 8, uint32_t frameSize = 64);
+
+// Box-filters mip 0 down while a frame still spans at least four texels, weighting by coverage.
+void generateImpostorMips(ImpostorAtlas& atlas);
+
+// Impostor layout: char magic[8] = "R_IMPST", uint32 version, uint32 gridSize, uint32 frameSize,
+// float3 center, float radius, then mip 0 of the albedo layer and of the normal-depth layer.
+bool writeImpostor(const std::string& path, const ImpostorAtlas& atlas);
+
+// Decodes an in-memory impostor file into mip 0. Returns false when the data is malformed.
+bool parseImpostor(const char* data, size_t size, const std::string& name, ImpostorAtlas& atlas);
+
+// Impostor of mesh meshIndex of a cooked .mesh file, written beside it as <name>.<index>.impostor.
+std::string impostorPath(const std::string& meshPath, uint32_t meshIndex);
+
+// Bakes the finest level of every mesh of a cooked .mesh file into its impostor file.
+bool cookImpostors(const std::string& meshPath);
+
+} // namespace reactor
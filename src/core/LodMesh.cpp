@@ -0,0 +1,241 @@
+#include "LodMesh.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace reactor
+{
+
+LodMesh::LodMesh(AssetLoader& loader, FrameManager& frameManager, std::string path, uint32_t meshIndex, const glm::vec3& position)
+    : m_loader(loader), m_frameManager(frameManager), m_path(std::move(path)), m_meshIndex(meshIndex), m_position(position)
+{}
+
+void LodMesh::load()
+{
+    spawn(m_loader.readTocAsync(m_path), [self = shared_from_this()](std::vector<MeshToc> toc) {
+        if (self->m_meshIndex >= toc.size())
+        {
+            spdlog::error("{} has no mesh {}", self->m_path, self->m_meshIndex);
+            self->m_state.store(State::Failed, std::memory_order_release);
+            return;
+        }
+
+        self->m_toc = std::move(toc[self->m_meshIndex]);
+        self->m_levels.resize(self->m_toc.lods.size());
+        for (size_t i = 0; i < self->m_levels.size(); ++i)
+        {
+            self->m_levels[i].chunk = self->m_toc.lods[i];
+        }
+        self->m_state.store(State::Ready, std::memory_order_release);
+    });
+}
+
+Mesh* LodMesh::select(float pixelsPerUnit, float maxPixelError)
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return nullptr;
+    }
+    return want(wantedLevel(pixelsPerUnit, maxPixelError));
+}
+
+uint32_t LodMesh::wantedLevel(float pixelsPerUnit, float maxPixelError) const
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return 0;
+    }
+
+    // Errors grow with the level index, so walk from the coarsest towards finer levels
+    const size_t coarsest = m_levels.size() - 1;
+    for (size_t i = coarsest; i > 0; --i)
+    {
+        if (m_levels[i].chunk.error * pixelsPerUnit <= maxPixelError)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return 0;
+}
+
+Mesh* LodMesh::want(uint32_t level)
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return nullptr;
+    }
+
+    const uint64_t frame = m_frameManager.getFrameNumber();
+    m_lastUsedFrame = frame;
+
+    const size_t coarsest = m_levels.size() - 1;
+    const size_t wanted = std::min<size_t>(level, coarsest);
+    request(m_levels[coarsest]);
+    request(m_levels[wanted]);
+    m_levels[wanted].lastWantedFrame = frame;
+
+    // Until the wanted level lands, a finer level still resident beats a coarser one
+    auto use = [&](size_t i) -> Mesh* {
+        Mesh* mesh = m_levels[i].handle.get();
+        if (mesh)
+        {
+            m_levels[i].lastWantedFrame = frame;
+        }
+        return mesh;
+    };
+    if (Mesh* mesh = use(wanted))
+    {
+        return mesh;
+    }
+    for (size_t i = wanted; i-- > 0;)
+    {
+        if (Mesh* mesh = use(i))
+        {
+            return mesh;
+        }
+    }
+    for (size_t i = wanted + 1; i <= coarsest; ++i)
+    {
+        if (Mesh* mesh = use(i))
+        {
+            return mesh;
+        }
+    }
+    return nullptr;
+}
+
+float LodMesh::levelError(uint32_t level) const
+{
+    return m_levels[level].chunk.error;
+}
+
+Mesh* LodMesh::levelMesh(uint32_t level) const
+{
+    return m_levels[level].handle.get();
+}
+
+const OccluderMesh* LodMesh::occluder()
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return nullptr;
+    }
+
+    if (!m_occluderRequested)
+    {
+        m_occluderRequested = true;
+        spawn(m_loader.readOccluderAsync(m_path, m_levels.back().chunk),
+              [self = shared_from_this()](std::shared_ptr<const OccluderMesh> occluder) {
+                  self->m_occluder = std::move(occluder);
+                  self->m_occluderLoaded.store(true, std::memory_order_release);
+              });
+    }
+    return m_occluderLoaded.load(std::memory_order_acquire) ? m_occluder.get() : nullptr;
+}
+
+void LodMesh::trim(uint64_t graceFrames)
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return;
+    }
+
+    const uint64_t frame = m_frameManager.getFrameNumber();
+    for (size_t i = 0; i + 1 < m_levels.size(); ++i)
+    {
+        Level& level = m_levels[i];
+        if (level.requested && frame - level.lastWantedFrame > graceFrames)
+        {
+            release(level);
+        }
+    }
+}
+
+void LodMesh::evict()
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return;
+    }
+    for (auto& level : m_levels)
+    {
+        release(level);
+    }
+}
+
+void LodMesh::request(Level& level)
+{
+    if (!level.requested)
+    {
+        level.handle = m_loader.requestMeshLevel(m_path, level.chunk, m_position);
+        level.requested = true;
+    }
+}
+
+void LodMesh::release(Level& level)
+{
+    // A level still loading cannot be cancelled; it is released once it has landed
+    if (!level.requested || level.handle.isLoading())
+    {
+        return;
+    }
+
+    // Frames in flight may still draw this level
+    if (auto mesh = level.handle.shared())
+    {
+        m_frameManager.retire(std::move(mesh));
+    }
+    level.handle = MeshHandle();
+    level.requested = false;
+}
+
+vk::DeviceSize LodMesh::residentBytes() const
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return 0;
+    }
+
+    vk::DeviceSize bytes = 0;
+    for (const auto& level : m_levels)
+    {
+        if (const auto mesh = level.handle.shared())
+        {
+            bytes += mesh->getMemorySize();
+        }
+    }
+    return bytes;
+}
+
+uint32_t LodMesh::levelCount() const
+{
+    return m_state.load(std::memory_order_acquire) == State::Ready ? static_cast<uint32_t>(m_levels.size()) : 0;
+}
+
+uint32_t LodMesh::residentLevelCount() const
+{
+    if (m_state.load(std::memory_order_acquire) != State::Ready)
+    {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    for (const auto& level : m_levels)
+    {
+        count += level.handle.shared() ? 1 : 0;
+    }
+    return count;
+}
+
+glm::vec3 LodMesh::boundsCenter() const
+{
+    return m_state.load(std::memory_order_acquire) == State::Ready ? m_toc.boundsCenter : glm::vec3(0.0f);
+}
+
+float LodMesh::boundsRadius() const
+{
+    return m_state.load(std::memory_order_acquire) == State::Ready ? m_toc.boundsRadius : 0.0f;
+}
+
+} // namespace reactor
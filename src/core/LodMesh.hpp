@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../vulkan/FrameManager.hpp"
+#include "../vulkan/Mesh.hpp"
+#include "AssetLoader.hpp"
+#include "ModelIO.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+// One mesh of a cooked .mesh file with per-level residency. Only the table of contents and the
+// coarsest level are loaded up front; finer levels stream in when the projected error asks for
+// them and are retired again once nothing has wanted them for a while. Render thread only, apart
+// from the table of contents which a loader worker publishes.
+class LodMesh : public std::enable_shared_from_this<LodMesh>
+{
+public:
+    LodMesh(AssetLoader& loader, FrameManager& frameManager, std::string path, uint32_t meshIndex, const glm::vec3& position);
+
+    LodMesh(const LodMesh&) = delete;
+    LodMesh& operator=(const LodMesh&) = delete;
+
+    // Starts reading the table of contents.
+    void load();
+
+    bool isLoading() const
+    {
+        return m_state.load(std::memory_order_acquire) == State::Loading;
+    }
+    bool hasFailed() const
+    {
+        return m_state.load(std::memory_order_acquire) == State::Failed;
+    }
+
+    // Picks the coarsest level whose error projects to at most maxPixelError, given how many pixels
+    // one object-space unit covers at the mesh's distance. Requests it if missing and returns the
+    // closest level that is ready, or null when none is.
+    Mesh* select(float pixelsPerUnit, float maxPixelError);
+
+    // The two halves of select(), for callers that pick levels elsewhere (the GPU culling pass):
+    // the level select() would want, and marking a level wanted, requesting it if missing and
+    // returning the closest ready level.
+    [[nodiscard]] uint32_t wantedLevel(float pixelsPerUnit, float maxPixelError) const;
+    Mesh* want(uint32_t level);
+
+    // Object-space error of a level, and its mesh when resident and ready.
+    [[nodiscard]] float levelError(uint32_t level) const;
+    [[nodiscard]] Mesh* levelMesh(uint32_t level) const;
+
+    // The coarsest level as CPU-side occluder geometry. The first call starts reading it; null
+    // until it has loaded, or when it cannot be read.
+    const OccluderMesh* occluder();
+
+    // Retires finer levels that no select() wanted during the last graceFrames frames. The coarsest
+    // level stays resident while the mesh lives.
+    void trim(uint64_t graceFrames);
+
+    // Retires every level; the next select() streams the coarsest one in again.
+    void evict();
+
+    [[nodiscard]] const std::string& path() const
+    {
+        return m_path;
+    }
+    [[nodiscard]] uint32_t meshIndex() const
+    {
+        return m_meshIndex;
+    }
+
+    [[nodiscard]] vk::DeviceSize residentBytes() const;
+    [[nodiscard]] uint32_t levelCount() const;
+    [[nodiscard]] uint32_t residentLevelCount() const;
+    [[nodiscard]] uint64_t lastUsedFrame() const
+    {
+        return m_lastUsedFrame;
+    }
+
+    // Object-space bounds; zero radius until the table of contents has loaded.
+    [[nodiscard]] glm::vec3 boundsCenter() const;
+    [[nodiscard]] float boundsRadius() const;
+
+private:
+    enum class State
+    {
+        Loading,
+        Ready,
+        Failed,
+    };
+
+    struct Level
+    {
+        MeshChunk chunk;
+        MeshHandle handle;
+        bool requested = false;
+        uint64_t lastWantedFrame = 0;
+    };
+
+    void request(Level& level);
+    void release(Level& level);
+
+    AssetLoader& m_loader;
+    FrameManager& m_frameManager;
+    std::string m_path;
+    uint32_t m_meshIndex;
+    glm::vec3 m_position;
+
+    std::atomic<State> m_state{State::Loading};
+    MeshToc m_toc;              // written once before m_state becomes Ready
+    std::vector<Level> m_levels; // finest first
+    uint64_t m_lastUsedFrame = 0;
+
+    bool m_occluderRequested = false;
+    std::atomic<bool> m_occluderLoaded{false};
+    std::shared_ptr<const OccluderMesh> m_occluder; // written once before m_occluderLoaded
+};
+
+} // namespace reactor
@@ -0,0 +1,432 @@
+#include "MaskedOcclusion.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define REACTOR_OCCLUSION_AVX2 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define REACTOR_OCCLUSION_SSE 1
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint64_t kFullTile = ~0ull;
+constexpr float kEmptyDepth = std::numeric_limits<float>::max(); // nothing drawn, hides nothing
+constexpr size_t kOccludersPerTask = 4;
+
+// Coverage of the 8x8 pixels starting at (x0, y0); bit row * 8 + column is set when that pixel's
+// centre lies inside all three edges.
+uint64_t coverTile(const float (&a)[3], const float (&b)[3], const float (&c)[3], float x0, float y0)
+{
+    uint64_t mask = 0;
+#if defined(REACTOR_OCCLUSION_AVX2)
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 e[3], stepY[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        const float start = a[k] * (x0 + 0.5f) + b[k] * (y0 + 0.5f) + c[k];
+        e[k] = _mm256_add_ps(_mm256_set1_ps(start), _mm256_mul_ps(_mm256_set1_ps(a[k]), lane));
+        stepY[k] = _mm256_set1_ps(b[k]);
+    }
+    for (int row = 0; row < 8; ++row)
+    {
+        const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e[0], zero, _CMP_GE_OQ),
+                                                          _mm256_cmp_ps(e[1], zero, _CMP_GE_OQ)),
+                                            _mm256_cmp_ps(e[2], zero, _CMP_GE_OQ));
+        mask |= static_cast<uint64_t>(_mm256_movemask_ps(inside)) << (row * 8);
+        for (int k = 0; k < 3; ++k)
+        {
+            e[k] = _mm256_add_ps(e[k], stepY[k]);
+        }
+    }
+#elif defined(REACTOR_OCCLUSION_SSE)
+    // Each row as two halves of four pixels
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 lo[3], hi[3], stepY[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        const float start = a[k] * (x0 + 0.5f) + b[k] * (y0 + 0.5f) + c[k];
+        lo[k] = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set1_ps(a[k]), lane));
+        hi[k] = _mm_add_ps(lo[k], _mm_set1_ps(4.0f * a[k]));
+        stepY[k] = _mm_set1_ps(b[k]);
+    }
+    for (int row = 0; row < 8; ++row)
+    {
+        const __m128 insideLo = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(lo[0], zero), _mm_cmpge_ps(lo[1], zero)),
+                                           _mm_cmpge_ps(lo[2], zero));
+        const __m128 insideHi = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(hi[0], zero), _mm_cmpge_ps(hi[1], zero)),
+                                           _mm_cmpge_ps(hi[2], zero));
+        const auto bits = static_cast<uint64_t>(_mm_movemask_ps(insideLo) | (_mm_movemask_ps(insideHi) << 4));
+        mask |= bits << (row * 8);
+        for (int k = 0; k < 3; ++k)
+        {
+            lo[k] = _mm_add_ps(lo[k], stepY[k]);
+            hi[k] = _mm_add_ps(hi[k], stepY[k]);
+        }
+    }
+#else
+    for (int row = 0; row < 8; ++row)
+    {
+        const float y = y0 + static_cast<float>(row) + 0.5f;
+        for (int column = 0; column < 8; ++column)
+        {
+            const float x = x0 + static_cast<float>(column) + 0.5f;
+            bool inside = true;
+            for (int k = 0; k < 3; ++k)
+            {
+                inside = inside && a[k] * x + b[k] * y + c[k] >= 0.0f;
+            }
+            if (inside)
+            {
+                mask |= 1ull << (row * 8 + column);
+            }
+        }
+    }
+#endif
+    return mask;
+}
+
+// True when any of count tile depths is at or nearer than depth
+bool anyNearer(const float* zMax0, size_t count, float depth)
+{
+    size_t i = 0;
+#if defined(REACTOR_OCCLUSION_AVX2)
+    const __m256 limit = _mm256_set1_ps(depth);
+    for (; i + 8 <= count; i += 8)
+    {
+        if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(zMax0 + i), limit, _CMP_GE_OQ)) != 0)
+        {
+            return true;
+        }
+    }
+#elif defined(REACTOR_OCCLUSION_SSE)
+    const __m128 limit = _mm_set1_ps(depth);
+    for (; i + 4 <= count; i += 4)
+    {
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(zMax0 + i), limit)) != 0)
+        {
+            return true;
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        if (zMax0[i] >= depth)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+MaskedOcclusion::MaskedOcclusion(uint32_t width, uint32_t height)
+{
+    resize(width, height);
+}
+
+void MaskedOcclusion::resize(uint32_t width, uint32_t height)
+{
+    const uint32_t tilesX = std::max((width + kTileSize - 1) / kTileSize, 1u);
+    const uint32_t tilesY = std::max((height + kTileSize - 1) / kTileSize, 1u);
+    if (tilesX == m_tilesX && tilesY == m_tilesY)
+    {
+        return;
+    }
+
+    m_tilesX = tilesX;
+    m_tilesY = tilesY;
+    const size_t tiles = static_cast<size_t>(m_tilesX) * m_tilesY;
+    m_masks.resize(tiles);
+    m_zMax0.resize(tiles);
+    m_zMax1.resize(tiles);
+    clear();
+}
+
+void MaskedOcclusion::clear()
+{
+    std::fill(m_masks.begin(), m_masks.end(), 0);
+    std::fill(m_zMax0.begin(), m_zMax0.end(), kEmptyDepth);
+    std::fill(m_zMax1.begin(), m_zMax1.end(), 0.0f);
+}
+
+void MaskedOcclusion::render(const glm::mat4& viewProjection, std::span<const Occluder> occluders, ThreadPool* pool)
+{
+    m_viewProjection = viewProjection;
+    clear();
+    setupTriangles(occluders, pool);
+    if (m_triangleCount == 0)
+    {
+        return;
+    }
+
+    // Each task owns whole tile rows, so tiles are updated without synchronization and in
+    // triangle order
+    auto rasterizeRows = [this](size_t begin, size_t end) {
+        for (size_t tileY = begin; tileY < end; ++tileY)
+        {
+            rasterizeTileRow(static_cast<uint32_t>(tileY));
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(m_tilesY, 1, rasterizeRows);
+    }
+    else
+    {
+        rasterizeRows(0, m_tilesY);
+    }
+}
+
+void MaskedOcclusion::setupTriangles(std::span<const Occluder> occluders, ThreadPool* pool)
+{
+    m_firstTriangle.resize(occluders.size());
+    size_t total = 0;
+    for (size_t i = 0; i < occluders.size(); ++i)
+    {
+        m_firstTriangle[i] = total;
+        total += occluders[i].mesh ? occluders[i].mesh->indices.size() / 3 : 0;
+    }
+    m_triangles.resize(total);
+
+    const float width = static_cast<float>(this->width());
+    const float height = static_cast<float>(this->height());
+
+    auto setup = [&](size_t begin, size_t end) {
+        std::vector<glm::vec4> clip;
+        for (size_t o = begin; o < end; ++o)
+        {
+            const OccluderMesh* mesh = occluders[o].mesh;
+            if (!mesh)
+            {
+                continue;
+            }
+
+            const glm::mat4 transform = m_viewProjection * occluders[o].transform;
+            clip.resize(mesh->positions.size());
+            for (size_t v = 0; v < clip.size(); ++v)
+            {
+                clip[v] = transform * glm::vec4(mesh->positions[v], 1.0f);
+            }
+
+            Triangle* out = m_triangles.data() + m_firstTriangle[o];
+            for (size_t t = 0; t + 2 < mesh->indices.size(); t += 3, ++out)
+            {
+                Triangle& triangle = *out;
+                triangle.tileY0 = 1; // empty until set up
+                triangle.tileY1 = 0;
+
+                // Parts in front of the near plane are clipped when drawn, so they hide nothing
+                glm::vec3 s[3];
+                bool clipped = false;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const glm::vec4& p = clip[mesh->indices[t + k]];
+                    clipped = clipped || p.z < 0.0f || p.w <= 0.0f;
+                    s[k] = glm::vec3((p.x / p.w * 0.5f + 0.5f) * width, (p.y / p.w * 0.5f + 0.5f) * height, p.z / p.w);
+                }
+                if (clipped)
+                {
+                    continue;
+                }
+
+                const float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[2].x - s[0].x) * (s[1].y - s[0].y);
+                if (!(std::abs(area) > 1e-6f))
+                {
+                    continue;
+                }
+
+                const float minX = std::min({s[0].x, s[1].x, s[2].x});
+                const float maxX = std::max({s[0].x, s[1].x, s[2].x});
+                const float minY = std::min({s[0].y, s[1].y, s[2].y});
+                const float maxY = std::max({s[0].y, s[1].y, s[2].y});
+                if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+                {
+                    continue;
+                }
+
+                // Both windings rasterize; edges are flipped so the inside is always positive
+                const float sign = area > 0.0f ? 1.0f : -1.0f;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const glm::vec3& from = s[k];
+                    const glm::vec3& to = s[(k + 1) % 3];
+                    triangle.edgeA[k] = (from.y - to.y) * sign;
+                    triangle.edgeB[k] = (to.x - from.x) * sign;
+                    triangle.edgeC[k] = (from.x * to.y - to.x * from.y) * sign;
+                }
+
+                // z/w is linear in screen space
+                const glm::vec3 d1 = s[1] - s[0];
+                const glm::vec3 d2 = s[2] - s[0];
+                triangle.depthX = (d1.z * d2.y - d2.z * d1.y) / area;
+                triangle.depthY = (d1.x * d2.z - d2.x * d1.z) / area;
+                triangle.depthC = s[0].z - triangle.depthX * s[0].x - triangle.depthY * s[0].y;
+                triangle.maxDepth = std::max({s[0].z, s[1].z, s[2].z});
+
+                triangle.tileX0 = static_cast<int32_t>(std::max(minX, 0.0f)) / static_cast<int32_t>(kTileSize);
+                triangle.tileX1 = static_cast<int32_t>(std::min(maxX, width - 1.0f)) / static_cast<int32_t>(kTileSize);
+                triangle.tileY0 = static_cast<int32_t>(std::max(minY, 0.0f)) / static_cast<int32_t>(kTileSize);
+                triangle.tileY1 = static_cast<int32_t>(std::min(maxY, height - 1.0f)) / static_cast<int32_t>(kTileSize);
+            }
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(occluders.size(), kOccludersPerTask, setup);
+    }
+    else
+    {
+        setup(0, occluders.size());
+    }
+
+    m_triangleCount = static_cast<size_t>(std::count_if(
+        m_triangles.begin(), m_triangles.end(), [](const Triangle& triangle) { return triangle.tileY0 <= triangle.tileY1; }));
+}
+
+void MaskedOcclusion::rasterizeTileRow(uint32_t tileY)
+{
+    const auto row = static_cast<int32_t>(tileY);
+    const float y0 = static_cast<float>(tileY * kTileSize);
+    constexpr float span = static_cast<float>(kTileSize - 1); // first to last pixel centre
+
+    for (const Triangle& triangle : m_triangles)
+    {
+        if (row < triangle.tileY0 || row > triangle.tileY1)
+        {
+            continue;
+        }
+
+        for (int32_t tileX = triangle.tileX0; tileX <= triangle.tileX1; ++tileX)
+        {
+            const float x0 = static_cast<float>(static_cast<uint32_t>(tileX) * kTileSize);
+
+            // The extreme pixel centres of each edge decide whole tiles without per-pixel work
+            bool outside = false;
+            bool inside = true;
+            for (int k = 0; k < 3 && !outside; ++k)
+            {
+                const float a = triangle.edgeA[k];
+                const float b = triangle.edgeB[k];
+                const float first = a * (x0 + 0.5f) + b * (y0 + 0.5f) + triangle.edgeC[k];
+                const float most = first + std::max(a, 0.0f) * span + std::max(b, 0.0f) * span;
+                const float least = first + std::min(a, 0.0f) * span + std::min(b, 0.0f) * span;
+                outside = most < 0.0f;
+                inside = inside && least >= 0.0f;
+            }
+            if (outside)
+            {
+                continue;
+            }
+
+            const uint64_t coverage =
+                inside ? kFullTile : coverTile(triangle.edgeA, triangle.edgeB, triangle.edgeC, x0, y0);
+            if (coverage == 0)
+            {
+                continue;
+            }
+
+            // Farthest depth of the triangle's plane over the tile, no farther than its vertices
+            const float size = static_cast<float>(kTileSize);
+            const float planeMax = triangle.depthX * (triangle.depthX > 0.0f ? x0 + size : x0)
+                                 + triangle.depthY * (triangle.depthY > 0.0f ? y0 + size : y0) + triangle.depthC;
+            updateTile(static_cast<size_t>(tileY) * m_tilesX + static_cast<size_t>(tileX),
+                       coverage,
+                       std::min(planeMax, triangle.maxDepth));
+        }
+    }
+}
+
+void MaskedOcclusion::updateTile(size_t tile, uint64_t coverage, float depth)
+{
+    // Nothing nearer than the whole tile already guarantees
+    if (depth >= m_zMax0[tile])
+    {
+        return;
+    }
+
+    if (coverage == kFullTile)
+    {
+        m_zMax0[tile] = depth;
+        if (m_zMax1[tile] >= depth)
+        {
+            // The working layer lies entirely behind the new reference and bounds nothing more
+            m_masks[tile] = 0;
+            m_zMax1[tile] = 0.0f;
+        }
+        return;
+    }
+
+    m_masks[tile] |= coverage;
+    m_zMax1[tile] = std::max(m_zMax1[tile], depth);
+    if (m_masks[tile] == kFullTile)
+    {
+        m_zMax0[tile] = std::min(m_zMax0[tile], m_zMax1[tile]);
+        m_masks[tile] = 0;
+        m_zMax1[tile] = 0.0f;
+    }
+}
+
+bool MaskedOcclusion::isOccluded(const BoundingSphere& sphere) const
+{
+    // Screen rectangle and nearest depth of the sphere's bounding box
+    const float width = static_cast<float>(this->width());
+    const float height = static_cast<float>(this->height());
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    float nearest = std::numeric_limits<float>::max();
+    for (int c = 0; c < 8; ++c)
+    {
+        const glm::vec3 corner = sphere.center
+                               + sphere.radius
+                                     * glm::vec3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+        const glm::vec4 clip = m_viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.z < 0.0f || clip.w <= 0.0f)
+        {
+            return false; // reaches in front of the near plane
+        }
+        const float x = (clip.x / clip.w * 0.5f + 0.5f) * width;
+        const float y = (clip.y / clip.w * 0.5f + 0.5f) * height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip.z / clip.w);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+    {
+        return false; // off screen is the frustum test's call
+    }
+
+    const auto tileX0 = static_cast<uint32_t>(std::max(minX, 0.0f)) / kTileSize;
+    const auto tileX1 = static_cast<uint32_t>(std::min(maxX, width - 1.0f)) / kTileSize;
+    const auto tileY0 = static_cast<uint32_t>(std::max(minY, 0.0f)) / kTileSize;
+    const auto tileY1 = static_cast<uint32_t>(std::min(maxY, height - 1.0f)) / kTileSize;
+    for (uint32_t tileY = tileY0; tileY <= tileY1; ++tileY)
+    {
+        const float* row = m_zMax0.data() + static_cast<size_t>(tileY) * m_tilesX;
+        if (anyNearer(row + tileX0, tileX1 - tileX0 + 1, nearest))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MaskedOcclusion::cull(const BoundsArrays& bounds, std::vector<uint32_t>& visible) const
+{
+    std::erase_if(visible, [&](uint32_t i) { return isOccluded(bounds.get(i)); });
+}
+
+} // namespace reactor
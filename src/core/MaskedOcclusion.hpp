@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Culling.hpp"
+#include "ModelIO.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace reactor
+{
+
+// An occluder mesh placed in the world.
+struct Occluder
+{
+    const OccluderMesh* mesh = nullptr;
+    glm::mat4 transform{1.0f};
+};
+
+// Software occlusion culling on a small masked depth buffer. The screen is split into 8x8 pixel
+// tiles; each tile keeps a coverage mask and two depths instead of per-pixel depth: zMax0, the
+// farthest depth of everything drawn over the whole tile, and zMax1, the farthest depth of the
+// triangles covering the bits set in the mask. Once the mask fills up, the two layers merge into
+// zMax0. Coverage is computed eight pixels at a time, with AVX2 when built with REACTOR_ENABLE_AVX2
+// and SSE on other x86 builds.
+//
+// Occluders should be proxies that sit inside the meshes they stand for, or objects behind their
+// silhouette may be culled while still visible. Triangles crossing the near plane are skipped,
+// which only loses occlusion.
+class MaskedOcclusion
+{
+public:
+    static constexpr uint32_t kTileSize = 8;
+
+    explicit MaskedOcclusion(uint32_t width = 320, uint32_t height = 192);
+
+    // Resolution in pixels, rounded up to whole tiles. Clears the buffer when it changes.
+    void resize(uint32_t width, uint32_t height);
+
+    // Clears the buffer and rasterizes occluders as seen through viewProjection, spreading the
+    // work over pool when given. Depth follows the [0, 1] clip range, nearer is smaller.
+    void render(const glm::mat4& viewProjection, std::span<const Occluder> occluders, ThreadPool* pool = nullptr);
+
+    // True when everything inside the sphere lies behind the occluders of the last render().
+    [[nodiscard]] bool isOccluded(const BoundingSphere& sphere) const;
+
+    // Removes the indices of occluded spheres from visible, keeping the order of the rest.
+    void cull(const BoundsArrays& bounds, std::vector<uint32_t>& visible) const;
+
+    [[nodiscard]] uint32_t width() const
+    {
+        return m_tilesX * kTileSize;
+    }
+    [[nodiscard]] uint32_t height() const
+    {
+        return m_tilesY * kTileSize;
+    }
+    // Triangles rasterized by the last render(), after near-plane and screen rejection.
+    [[nodiscard]] size_t triangleCount() const
+    {
+        return m_triangleCount;
+    }
+
+private:
+    // Screen-space triangle with its edge functions and depth plane set up once for every tile
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3]; // a*x + b*y + c >= 0 inside
+        float depthX, depthY, depthC;       // depth = depthX*x + depthY*y + depthC
+        float maxDepth;
+        int32_t tileX0, tileY0, tileX1, tileY1; // inclusive tile range
+    };
+
+    void clear();
+    void setupTriangles(std::span<const Occluder> occluders, ThreadPool* pool);
+    void rasterizeTileRow(uint32_t tileY);
+    void updateTile(size_t tile, uint64_t coverage, float depth);
+
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
+    glm::mat4 m_viewProjection{1.0f};
+
+    // Per tile, row-major
+    std::vector<uint64_t> m_masks;
+    std::vector<float> m_zMax0;
+    std::vector<float> m_zMax1;
+
+    std::vector<size_t> m_firstTriangle; // per occluder, into m_triangles
+    std::vector<Triangle> m_triangles;
+    size_t m_triangleCount = 0;
+};
+
+} // namespace reactor
@@ -3,8 +3,18 @@
 //
 #include "ModelIO.hpp"
 
+#include "AsyncIO.hpp"
+
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
@@ -13,37 +23,172 @@ namespace reactor
 {
 bool processAndExportScene(const aiScene*, const std::string&);
 
+namespace
+{
+// File layout, version 2:
+//   header    char magic[8], uint32 version, uint32 meshCount, uint32 tocSize
+//   toc       per mesh: uint32 lodCount, float center[3], float radius,
+//             then per level: uint64 vertexCount, indexCount, vertexOffset, indexOffset,
+//             float error, uint32 reserved
+//   payload   vertices and indices of every level at the offsets in the toc
+// Version 1 has no toc; each mesh is uint64 vertexCount, uint64 indexCount, then its data.
+constexpr uint32_t kModelVersion = 2;
+constexpr uint64_t kHeaderSizeV1 = 8 + sizeof(uint32_t) * 2;
+constexpr uint64_t kHeaderSizeV2 = kHeaderSizeV1 + sizeof(uint32_t);
+constexpr uint32_t kMaxLods = 5;
+// lodCount, bounds centre and radius, then at least one level of four uint64 and two 32-bit fields
+constexpr uint64_t kMinTocEntrySize = sizeof(uint32_t) + sizeof(float) * 4 + sizeof(uint64_t) * 4 + sizeof(uint32_t) * 2;
+constexpr uint64_t kMinLodIndices = 3 * 64;
+
+// Bounds-checked cursor over a loaded file.
+struct BinaryReader
+{
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+
+    bool read(void* out, size_t bytes)
+    {
+        if (bytes > size - offset)
+            return false;
+        memcpy(out, data + offset, bytes);
+        offset += bytes;
+        return true;
+    }
+};
 
-// Processes the assimp scene and writes it to our custom binary format.
-bool processAndExportScene(const aiScene* scene, const std::string& outputPath)
+template <typename T>
+void append(std::vector<char>& out, const T& value)
 {
-    // Open the output file in binary mode.
-    std::ofstream outFile(outputPath, std::ios::binary);
-    if (!outFile.is_open()) {
-        spdlog::error("Failed to open output file for writing: {}", outputPath);
-        return false;
+    const auto* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool parseToc(BinaryReader& reader, uint32_t meshCount, std::vector<MeshToc>& toc)
+{
+    toc.resize(meshCount);
+    for (auto& mesh : toc) {
+        uint32_t lodCount;
+        if (!reader.read(&lodCount, sizeof(lodCount)) || !reader.read(&mesh.boundsCenter, sizeof(glm::vec3))
+            || !reader.read(&mesh.boundsRadius, sizeof(float)) || lodCount == 0 || lodCount > kMaxLods) {
+            return false;
+        }
+        mesh.lods.resize(lodCount);
+        for (auto& lod : mesh.lods) {
+            uint32_t reserved;
+            if (!reader.read(&lod.vertexCount, sizeof(uint64_t)) || !reader.read(&lod.indexCount, sizeof(uint64_t))
+                || !reader.read(&lod.vertexOffset, sizeof(uint64_t)) || !reader.read(&lod.indexOffset, sizeof(uint64_t))
+                || !reader.read(&lod.error, sizeof(float)) || !reader.read(&reserved, sizeof(reserved))) {
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    // --- Write File Header ---
-    const char magic[8] = "R_MESH";
-    uint32_t version = 1;
-    uint32_t meshCount = scene->mNumMeshes;
+} // namespace
 
-    outFile.write(magic, sizeof(magic));
-    outFile.write(reinterpret_cast<const char*>(&version), sizeof(version));
-    outFile.write(reinterpret_cast<const char*>(&meshCount), sizeof(meshCount));
+MeshData clusterSimplify(const MeshData& mesh, const glm::vec3& origin, float cellSize)
+{
+    std::unordered_map<uint64_t, uint32_t> cells;
+    std::vector<uint32_t> remap(mesh.vertices.size());
+    std::vector<uint32_t> counts;
+    MeshData out;
+
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const Vertex& v = mesh.vertices[i];
+        const glm::uvec3 cell = glm::uvec3((v.pos - origin) / cellSize);
+        const uint64_t key = uint64_t(cell.x & 0x1fffff) | (uint64_t(cell.y & 0x1fffff) << 21)
+                             | (uint64_t(cell.z & 0x1fffff) << 42);
+
+        auto [it, inserted] = cells.try_emplace(key, static_cast<uint32_t>(out.vertices.size()));
+        if (inserted) {
+            out.vertices.push_back(v);
+            counts.push_back(1);
+        } else {
+            Vertex& merged = out.vertices[it->second];
+            merged.pos += v.pos;
+            merged.normal += v.normal;
+            merged.color += v.color;
+            counts[it->second]++;
+        }
+        remap[i] = it->second;
+    }
 
-    spdlog::info("Exporting {} meshes to {}", meshCount, outputPath);
+    for (size_t i = 0; i < out.vertices.size(); ++i) {
+        Vertex& v = out.vertices[i];
+        v.pos /= static_cast<float>(counts[i]);
+        v.color /= static_cast<float>(counts[i]);
+        const float length = glm::length(v.normal);
+        v.normal = length > 0.0f ? v.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
 
-    // --- Write Each Mesh's Data ---
+    out.indices.reserve(mesh.indices.size());
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const uint32_t a = remap[mesh.indices[i]];
+        const uint32_t b = remap[mesh.indices[i + 1]];
+        const uint32_t c = remap[mesh.indices[i + 2]];
+        if (a != b && b != c && a != c) {
+            out.indices.insert(out.indices.end(), {a, b, c});
+        }
+    }
+    return out;
+}
+
+namespace
+{
+// Finest level first. Each further level doubles the cell size until the triangle count stops
+// dropping meaningfully or the mesh is already tiny.
+std::vector<std::pair<MeshData, float>> buildLodChain(MeshData mesh, glm::vec3& center, float& radius)
+{
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(std::numeric_limits<float>::lowest());
+    for (const auto& v : mesh.vertices) {
+        lo = glm::min(lo, v.pos);
+        hi = glm::max(hi, v.pos);
+    }
+    center = mesh.vertices.empty() ? glm::vec3(0.0f) : (lo + hi) * 0.5f;
+    radius = 0.0f;
+    for (const auto& v : mesh.vertices) {
+        radius = std::max(radius, glm::length(v.pos - center));
+    }
+
+    std::vector<std::pair<MeshData, float>> lods;
+    lods.emplace_back(std::move(mesh), 0.0f);
+    if (radius == 0.0f) {
+        return lods;
+    }
+
+    float cellSize = radius / 64.0f;
+    for (int attempt = 0; attempt < 8 && lods.size() < kMaxLods; ++attempt, cellSize *= 2.0f) {
+        const MeshData& previous = lods.back().first;
+        if (previous.indices.size() <= kMinLodIndices) {
+            break;
+        }
+        MeshData coarser = clusterSimplify(lods.front().first, lo, cellSize);
+        if (coarser.indices.empty()) {
+            break;
+        }
+        if (coarser.indices.size() * 10 > previous.indices.size() * 7) {
+            continue;
+        }
+        lods.emplace_back(std::move(coarser), cellSize * std::sqrt(3.0f));
+    }
+    return lods;
+}
+} // namespace
+
+
+// Processes the assimp scene, builds the level-of-detail chain and writes it to our binary format.
+bool processAndExportScene(const aiScene* scene, const std::string& outputPath)
+{
+    std::vector<MeshData> meshes(scene->mNumMeshes);
     for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
         aiMesh* pMesh = scene->mMeshes[i];
-
-        std::vector<reactor::Vertex> vertices;
-        std::vector<uint32_t> indices;
+        MeshData& data = meshes[i];
 
         // Extract vertex data
-        vertices.reserve(pMesh->mNumVertices);
+        data.vertices.reserve(pMesh->mNumVertices);
         for (unsigned int v = 0; v < pMesh->mNumVertices; ++v) {
             reactor::Vertex vertex{};
             vertex.pos = {pMesh->mVertices[v].x, pMesh->mVertices[v].y, pMesh->mVertices[v].z};
@@ -61,29 +206,92 @@ bool processAndExportScene(const aiScene* scene, const std::string& outputPath)
             if (pMesh->HasTextureCoords(0)) {
                 vertex.texCoord = {pMesh->mTextureCoords[0][v].x, pMesh->mTextureCoords[0][v].y};
             }
-            vertices.push_back(vertex);
+            data.vertices.push_back(vertex);
         }
 
         // Extract index data
-        indices.reserve(pMesh->mNumFaces * 3);
+        data.indices.reserve(pMesh->mNumFaces * 3);
         for (unsigned int f = 0; f < pMesh->mNumFaces; ++f) {
             aiFace face = pMesh->mFaces[f];
             // We assume the mesh is triangulated (aiProcess_Triangulate)
             for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-                indices.push_back(face.mIndices[j]);
+                data.indices.push_back(face.mIndices[j]);
             }
         }
+    }
 
-        // --- Write Mesh Chunk to File ---
-        uint64_t vertexCount = vertices.size();
-        uint64_t indexCount = indices.size();
+    return writeModelBinary(outputPath, std::move(meshes));
+}
 
-        outFile.write(reinterpret_cast<const char*>(&vertexCount), sizeof(vertexCount));
-        outFile.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
-        outFile.write(reinterpret_cast<const char*>(vertices.data()), vertexCount * sizeof(reactor::Vertex));
-        outFile.write(reinterpret_cast<const char*>(indices.data()), indexCount * sizeof(uint32_t));
+bool writeModelBinary(const std::string& outputPath, std::vector<MeshData> meshData, float baseError)
+{
+    // Open the output file in binary mode.
+    std::ofstream outFile(outputPath, std::ios::binary);
+    if (!outFile.is_open()) {
+        spdlog::error("Failed to open output file for writing: {}", outputPath);
+        return false;
+    }
 
-        spdlog::info("  - Mesh {}: {} vertices, {} indices", i, vertexCount, indexCount);
+    const auto meshCount = static_cast<uint32_t>(meshData.size());
+    spdlog::info("Exporting {} meshes to {}", meshCount, outputPath);
+
+    struct ExportMesh
+    {
+        glm::vec3 center;
+        float radius;
+        std::vector<std::pair<MeshData, float>> lods;
+    };
+    std::vector<ExportMesh> meshes(meshCount);
+    for (uint32_t i = 0; i < meshCount; ++i) {
+        meshes[i].lods = buildLodChain(std::move(meshData[i]), meshes[i].center, meshes[i].radius);
+    }
+
+    // --- Build the table of contents; payload offsets follow it ---
+    uint32_t tocSize = 0;
+    for (const auto& mesh : meshes) {
+        tocSize += sizeof(uint32_t) + sizeof(float) * 4;
+        tocSize += static_cast<uint32_t>(mesh.lods.size()) * (sizeof(uint64_t) * 4 + sizeof(float) + sizeof(uint32_t));
+    }
+
+    std::vector<char> toc;
+    toc.reserve(tocSize);
+    uint64_t offset = kHeaderSizeV2 + tocSize;
+    for (uint32_t i = 0; i < meshCount; ++i) {
+        const ExportMesh& mesh = meshes[i];
+        append(toc, static_cast<uint32_t>(mesh.lods.size()));
+        append(toc, mesh.center);
+        append(toc, mesh.radius);
+        for (size_t l = 0; l < mesh.lods.size(); ++l) {
+            const auto& [data, error] = mesh.lods[l];
+            const uint64_t vertexCount = data.vertices.size();
+            const uint64_t indexCount = data.indices.size();
+            const uint64_t indexOffset = offset + vertexCount * sizeof(reactor::Vertex);
+            append(toc, vertexCount);
+            append(toc, indexCount);
+            append(toc, offset);
+            append(toc, indexOffset);
+            append(toc, baseError + error);
+            append(toc, uint32_t{0});
+            offset = indexOffset + indexCount * sizeof(uint32_t);
+
+            spdlog::info("  - Mesh {} LOD {}: {} vertices, {} indices, error {:.4f}", i, l, vertexCount, indexCount, baseError + error);
+        }
+    }
+
+    // --- Write File Header ---
+    const char magic[8] = "R_MESH";
+    outFile.write(magic, sizeof(magic));
+    outFile.write(reinterpret_cast<const char*>(&kModelVersion), sizeof(kModelVersion));
+    outFile.write(reinterpret_cast<const char*>(&meshCount), sizeof(meshCount));
+    outFile.write(reinterpret_cast<const char*>(&tocSize), sizeof(tocSize));
+    outFile.write(toc.data(), static_cast<std::streamsize>(toc.size()));
+
+    // --- Write Each Level's Data ---
+    for (const auto& mesh : meshes) {
+        for (const auto& [data, error] : mesh.lods) {
+            outFile.write(reinterpret_cast<const char*>(data.vertices.data()), data.vertices.size() * sizeof(reactor::Vertex));
+            outFile.write(reinterpret_cast<const char*>(data.indices.data()), data.indices.size() * sizeof(uint32_t));
+        }
     }
 
     outFile.close();
@@ -91,54 +299,184 @@ bool processAndExportScene(const aiScene* scene, const std::string& outputPath)
     return true;
 }
 
-// Example of how you would load the data back in your engine.
-std::vector<MeshData> loadModelFromBinary(const std::string& path) {
+std::vector<MeshData> parseModelBinary(const char* data, size_t size, const std::string& name) {
     std::vector<MeshData> allMeshes;
-
-    std::ifstream inFile(path, std::ios::binary);
-    if (!inFile.is_open()) {
-        spdlog::error("Failed to open model file for reading: {}", path);
-        return allMeshes;
-    }
+    BinaryReader reader{data, size};
 
     // --- Read and Validate Header ---
     char magic[8];
     uint32_t version;
     uint32_t meshCount;
 
-    inFile.read(magic, sizeof(magic));
-    inFile.read(reinterpret_cast<char*>(&version), sizeof(version));
-    inFile.read(reinterpret_cast<char*>(&meshCount), sizeof(meshCount));
+    if (!reader.read(magic, sizeof(magic)) || !reader.read(&version, sizeof(version))
+        || !reader.read(&meshCount, sizeof(meshCount))) {
+        spdlog::error("Truncated model file: {}", name);
+        return allMeshes;
+    }
 
-    if (std::string(magic) != "R_MESH" || version != 1) {
-        spdlog::error("Invalid model file or version mismatch: {}", path);
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_MESH" || (version != 1 && version != kModelVersion)) {
+        spdlog::error("Invalid model file or version mismatch: {}", name);
         return allMeshes;
     }
 
     allMeshes.resize(meshCount);
-    spdlog::info("Loading {} meshes from {}", meshCount, path);
+    spdlog::info("Loading {} meshes from {}", meshCount, name);
+
+    if (version == kModelVersion) {
+        // Only the finest level of each mesh is decoded
+        uint32_t tocSize;
+        std::vector<MeshToc> toc;
+        if (!reader.read(&tocSize, sizeof(tocSize)) || !parseToc(reader, meshCount, toc)) {
+            spdlog::error("Truncated model file: {}", name);
+            return {};
+        }
+        for (uint32_t i = 0; i < meshCount; ++i) {
+            const MeshChunk& lod = toc[i].lods.front();
+            if (lod.vertexOffset > size || lod.vertexCount > (size - lod.vertexOffset) / sizeof(reactor::Vertex)
+                || lod.indexOffset > size || lod.indexCount > (size - lod.indexOffset) / sizeof(uint32_t)) {
+                spdlog::error("Truncated model file: {}", name);
+                return {};
+            }
+            allMeshes[i].vertices.resize(lod.vertexCount);
+            allMeshes[i].indices.resize(lod.indexCount);
+            memcpy(allMeshes[i].vertices.data(), data + lod.vertexOffset, lod.vertexCount * sizeof(reactor::Vertex));
+            memcpy(allMeshes[i].indices.data(), data + lod.indexOffset, lod.indexCount * sizeof(uint32_t));
+
+            spdlog::info("  - Mesh {}: {} vertices, {} indices, {} LODs",
+                         i, lod.vertexCount, lod.indexCount, toc[i].lods.size());
+        }
+        return allMeshes;
+    }
 
     // --- Read Each Mesh's Data ---
     for (uint32_t i = 0; i < meshCount; ++i) {
         uint64_t vertexCount;
         uint64_t indexCount;
 
-        inFile.read(reinterpret_cast<char*>(&vertexCount), sizeof(vertexCount));
-        inFile.read(reinterpret_cast<char*>(&indexCount), sizeof(indexCount));
+        if (!reader.read(&vertexCount, sizeof(vertexCount)) || !reader.read(&indexCount, sizeof(indexCount))
+            || vertexCount > (size - reader.offset) / sizeof(reactor::Vertex)
+            || indexCount > (size - reader.offset) / sizeof(uint32_t)) {
+            spdlog::error("Truncated model file: {}", name);
+            return {};
+        }
 
         allMeshes[i].vertices.resize(vertexCount);
         allMeshes[i].indices.resize(indexCount);
 
-        inFile.read(reinterpret_cast<char*>(allMeshes[i].vertices.data()), vertexCount * sizeof(reactor::Vertex));
-        inFile.read(reinterpret_cast<char*>(allMeshes[i].indices.data()), indexCount * sizeof(uint32_t));
+        if (!reader.read(allMeshes[i].vertices.data(), vertexCount * sizeof(reactor::Vertex))
+            || !reader.read(allMeshes[i].indices.data(), indexCount * sizeof(uint32_t))) {
+            spdlog::error("Truncated model file: {}", name);
+            return {};
+        }
 
         spdlog::info("  - Mesh {}: {} vertices, {} indices", i, vertexCount, indexCount);
     }
 
-    inFile.close();
     return allMeshes;
 }
 
+std::vector<MeshToc> readModelToc(const std::string& path) {
+    AsyncIO& io = AsyncIO::shared();
+    ReadResult header = io.read(path, 0, kHeaderSizeV2).get();
+    if (!header.ok || header.data.size() < kHeaderSizeV1) {
+        spdlog::error("Failed to open model file for reading: {}", path);
+        return {};
+    }
+
+    char magic[8];
+    uint32_t version;
+    uint32_t meshCount;
+    memcpy(magic, header.data.data(), sizeof(magic));
+    memcpy(&version, header.data.data() + 8, sizeof(version));
+    memcpy(&meshCount, header.data.data() + 12, sizeof(meshCount));
+
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_MESH" || (version != 1 && version != kModelVersion)) {
+        spdlog::error("Invalid model file or version mismatch: {}", path);
+        return {};
+    }
+
+    // Counts in the header are bounded by the file size before anything is sized from them
+    std::error_code error;
+    const uint64_t fileSize = std::filesystem::file_size(path, error);
+    if (error) {
+        spdlog::error("Failed to open model file for reading: {}", path);
+        return {};
+    }
+    auto chunkInFile = [fileSize](const MeshChunk& chunk) {
+        return chunk.vertexOffset <= fileSize && chunk.vertexCount <= (fileSize - chunk.vertexOffset) / sizeof(reactor::Vertex)
+               && chunk.indexOffset <= fileSize && chunk.indexCount <= (fileSize - chunk.indexOffset) / sizeof(uint32_t);
+    };
+
+    std::vector<MeshToc> toc;
+    if (version == kModelVersion) {
+        uint32_t tocSize = 0;
+        if (header.data.size() >= kHeaderSizeV2) {
+            memcpy(&tocSize, header.data.data() + kHeaderSizeV1, sizeof(tocSize));
+        }
+        if (header.data.size() < kHeaderSizeV2 || tocSize > fileSize - kHeaderSizeV2
+            || meshCount > tocSize / kMinTocEntrySize) {
+            spdlog::error("Truncated model file: {}", path);
+            return {};
+        }
+        ReadResult tocData = io.read(path, kHeaderSizeV2, tocSize).get();
+        BinaryReader reader{tocData.data.data(), tocData.data.size()};
+        if (!tocData.ok || !parseToc(reader, meshCount, toc)) {
+            spdlog::error("Truncated model file: {}", path);
+            return {};
+        }
+        for (const MeshToc& mesh : toc) {
+            if (!std::all_of(mesh.lods.begin(), mesh.lods.end(), chunkInFile)) {
+                spdlog::error("Truncated model file: {}", path);
+                return {};
+            }
+        }
+        return toc;
+    }
+
+    // Version 1 mesh headers are interleaved with their payload, so each one is a small dependent read.
+    constexpr uint64_t meshHeaderSize = sizeof(uint64_t) * 2;
+    if (meshCount > (fileSize - kHeaderSizeV1) / meshHeaderSize) {
+        spdlog::error("Truncated model file: {}", path);
+        return {};
+    }
+    toc.resize(meshCount);
+    uint64_t offset = kHeaderSizeV1;
+    for (auto& mesh : toc) {
+        ReadResult counts = io.read(path, offset, meshHeaderSize).get();
+        if (!counts.ok) {
+            spdlog::error("Truncated model file: {}", path);
+            return {};
+        }
+        MeshChunk& chunk = mesh.lods.emplace_back();
+        memcpy(&chunk.vertexCount, counts.data.data(), sizeof(uint64_t));
+        memcpy(&chunk.indexCount, counts.data.data() + sizeof(uint64_t), sizeof(uint64_t));
+
+        chunk.vertexOffset = offset + meshHeaderSize;
+        if (chunk.vertexOffset > fileSize || chunk.vertexCount > (fileSize - chunk.vertexOffset) / sizeof(reactor::Vertex)) {
+            spdlog::error("Truncated model file: {}", path);
+            return {};
+        }
+        chunk.indexOffset = chunk.vertexOffset + chunk.vertexCount * sizeof(reactor::Vertex);
+        if (!chunkInFile(chunk)) {
+            spdlog::error("Truncated model file: {}", path);
+            return {};
+        }
+        offset = chunk.indexOffset + chunk.indexCount * sizeof(uint32_t);
+    }
+
+    return toc;
+}
+
+std::vector<MeshData> loadModelFromBinary(const std::string& path) {
+    ReadResult file = AsyncIO::shared().read(path).get();
+    if (!file.ok) {
+        spdlog::error("Failed to open model file for reading: {}", path);
+        return {};
+    }
+    return parseModelBinary(file.data.data(), file.data.size(), path);
+}
 
 bool importAndExport(const std::string& importPath, const std::string& exportPath) {
     Assimp::Importer importer;
@@ -2,6 +2,9 @@
 
 #include "../vulkan/Vertex.hpp"
 
+#include <string>
+#include <vector>
+
 namespace reactor
 {
 
@@ -12,7 +15,51 @@ struct MeshData
     std::vector<uint32_t> indices;
 };
 
+// Positions and indices only, for rasterizing a mesh on the CPU as an occluder.
+struct OccluderMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+// Byte ranges of one mesh level of detail inside a .mesh file.
+struct MeshChunk
+{
+    uint64_t vertexCount = 0;
+    uint64_t indexCount = 0;
+    uint64_t vertexOffset = 0;
+    uint64_t indexOffset = 0;
+    float error = 0.0f; // object-space distance from the full-detail surface
+};
+
+// Table of contents entry for one mesh: every level, finest first, with bounds for projecting
+// the level errors to the screen. Version 1 files have a single level and no bounds.
+struct MeshToc
+{
+    glm::vec3 boundsCenter{0.0f};
+    float boundsRadius = 0.0f;
+    std::vector<MeshChunk> lods;
+};
+
 std::vector<MeshData> loadModelFromBinary(const std::string&);
+
+// Reads only the table of contents so each level can be read straight into its final destination.
+// Returns an empty vector when the file is missing or malformed.
+std::vector<MeshToc> readModelToc(const std::string& path);
+
+// Decodes an in-memory .mesh file, keeping the finest level of each mesh. Returns an empty vector
+// when the data is malformed.
+std::vector<MeshData> parseModelBinary(const char* data, size_t size, const std::string& name);
+
 bool importAndExport(const std::string&, const std::string&);
 
+// Writes meshes as a .mesh file, building each one's level-of-detail chain. baseError is added to
+// every level's error, for geometry that was already simplified before it got here.
+bool writeModelBinary(const std::string& path, std::vector<MeshData> meshes, float baseError = 0.0f);
+
+// Vertex clustering: vertices that fall into the same grid cell merge into their average and
+// triangles that collapse are dropped. Coarser than edge collapse, but the error bound is simply
+// the cell diagonal.
+MeshData clusterSimplify(const MeshData& mesh, const glm::vec3& origin, float cellSize);
+
 } // namespace reactor
\ No newline at end of file
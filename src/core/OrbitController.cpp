@@ -16,6 +16,18 @@ void OrbitController::setSimCityView(float initialDistance, float initialElevati
      updateCamera();
  }
 
+void OrbitController::setView(const glm::vec3& position, const glm::vec3& target) {
+     const glm::vec3 offset = position - target;
+     const float distance = glm::length(offset);
+     m_target = target;
+     m_distance = glm::clamp(distance, MIN_DISTANCE, MAX_DISTANCE);
+     if (distance > 0.0f) {
+         m_elevation = glm::clamp(asinf(offset.y / distance), MIN_ELEVATION, MAX_ELEVATION);
+         m_azimuth = atan2f(offset.x, offset.z);
+     }
+     updateCamera();
+ }
+
 
 void OrbitController::onEvent(const Event &event) {
      switch (event.type) {
@@ -47,6 +59,10 @@ void OrbitController::onEvent(const Event &event) {
              m_panning = true;
              m_lastPanX = event.mouseButton.x;
              m_lastPanY = event.mouseButton.y;
+         } else if (event.mouseButton.button == 2 && m_picker) {
+             if (const auto hit = m_picker(event.mouseButton.x, event.mouseButton.y)) {
+                 setView(m_camera.getPosition(), *hit);
+             }
          }
          break;
      case EventType::MouseButtonReleased:
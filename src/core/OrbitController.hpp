@@ -3,6 +3,9 @@
 #include "EventManager.hpp"
 #include "Camera.hpp"
 
+#include <functional>
+#include <optional>
+
 namespace reactor {
 
 class OrbitController final : public IEventListener {
@@ -13,8 +16,20 @@ public:
 
     void setSimCityView(float initialDistance = 20.f, float initialElevationDegrees = 45.0f);
 
+    // Orbits target from position, e.g. a camera restored from a scene file. Distance and
+    // elevation are clamped to the controller's limits.
+    void setView(const glm::vec3& position, const glm::vec3& target);
+
+    const glm::vec3& getTarget() const { return m_target; }
+
+    // Maps a cursor position to the world point under it, if any. A middle click on something
+    // makes it the orbit target.
+    using Picker = std::function<std::optional<glm::vec3>(double x, double y)>;
+    void setPicker(Picker picker) { m_picker = std::move(picker); }
+
 private:
     Camera& m_camera;
+    Picker m_picker;
     glm::vec3 m_target{0.0f};
     float m_distance = 5.0f;
     float m_azimuth = 0.0f;
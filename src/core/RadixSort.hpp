@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace reactor
+{
+
+// Stable LSD radix sort of items by a 64-bit key, one byte per pass. Passes where every key has
+// the same byte are skipped, so keys whose high fields rarely vary cost little more than their
+// varying bytes. scratch is resized as needed and can be kept between calls to avoid allocating.
+template <typename T, typename KeyFn>
+void radixSort(std::vector<T>& items, std::vector<T>& scratch, KeyFn key)
+{
+    const size_t count = items.size();
+    if (count < 2)
+    {
+        return;
+    }
+    scratch.resize(count);
+
+    // One counting pass builds all eight histograms
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    for (const T& item : items)
+    {
+        const uint64_t k = key(item);
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            histograms[pass][(k >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    std::vector<T>* source = &items;
+    std::vector<T>* destination = &scratch;
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        auto& histogram = histograms[pass];
+        const uint64_t firstByte = (key((*source)[0]) >> (pass * 8)) & 0xFF;
+        if (histogram[firstByte] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram)
+        {
+            offset += std::exchange(bucket, offset);
+        }
+        for (T& item : *source)
+        {
+            (*destination)[histogram[(key(item) >> (pass * 8)) & 0xFF]++] = std::move(item);
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != &items)
+    {
+        items.swap(scratch);
+    }
+}
+
+} // namespace reactor
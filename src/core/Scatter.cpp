@@ -0,0 +1,189 @@
+#include "Scatter.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kScatterVersion = 1;
+constexpr uint32_t kMaxPathLength = 4096;
+constexpr uint32_t kMaxResolution = 8192;
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return in.good();
+}
+} // namespace
+
+bool writeScatterLayer(const std::string& path, const ScatterLayer& layer)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open())
+    {
+        spdlog::error("Failed to open scatter layer for writing: {}", path);
+        return false;
+    }
+
+    const char magic[8] = "R_SCATR";
+    out.write(magic, sizeof(magic));
+    writeValue(out, kScatterVersion);
+    writeValue(out, static_cast<uint32_t>(layer.meshPath.size()));
+    out.write(layer.meshPath.data(), static_cast<std::streamsize>(layer.meshPath.size()));
+    writeValue(out, layer.meshIndex);
+    writeValue(out, layer.origin.x);
+    writeValue(out, layer.origin.y);
+    writeValue(out, layer.size);
+    writeValue(out, layer.spacing);
+    writeValue(out, layer.seed);
+    writeValue(out, layer.minScale);
+    writeValue(out, layer.maxScale);
+    writeValue(out, layer.maxDistance);
+    writeValue(out, layer.densityResolution);
+    out.write(reinterpret_cast<const char*>(layer.density.data()), static_cast<std::streamsize>(layer.density.size()));
+    return out.good();
+}
+
+bool readScatterLayer(const std::string& path, ScatterLayer& layer)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        spdlog::error("Failed to open scatter layer: {}", path);
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t pathLength = 0;
+    in.read(magic, sizeof(magic));
+    if (!readValue(in, version) || !readValue(in, pathLength))
+    {
+        spdlog::error("Truncated scatter layer: {}", path);
+        return false;
+    }
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_SCATR" || version != kScatterVersion || pathLength > kMaxPathLength)
+    {
+        spdlog::error("Invalid scatter layer or version mismatch: {}", path);
+        return false;
+    }
+
+    layer.meshPath.resize(pathLength);
+    in.read(layer.meshPath.data(), pathLength);
+    if (!readValue(in, layer.meshIndex) || !readValue(in, layer.origin.x) || !readValue(in, layer.origin.y)
+        || !readValue(in, layer.size) || !readValue(in, layer.spacing) || !readValue(in, layer.seed)
+        || !readValue(in, layer.minScale) || !readValue(in, layer.maxScale) || !readValue(in, layer.maxDistance)
+        || !readValue(in, layer.densityResolution))
+    {
+        spdlog::error("Truncated scatter layer: {}", path);
+        return false;
+    }
+    if (layer.densityResolution == 0 || layer.densityResolution > kMaxResolution || !(layer.size > 0.0f)
+        || !(layer.spacing > 0.0f) || layer.minScale > layer.maxScale)
+    {
+        spdlog::error("Scatter layer {} has an invalid layout", path);
+        return false;
+    }
+
+    layer.density.resize(static_cast<size_t>(layer.densityResolution) * layer.densityResolution);
+    in.read(reinterpret_cast<char*>(layer.density.data()), static_cast<std::streamsize>(layer.density.size()));
+    if (!in.good())
+    {
+        spdlog::error("Truncated scatter layer: {}", path);
+        return false;
+    }
+    return true;
+}
+
+std::vector<ScatterLayer> loadScatterLayers(const std::string& directory)
+{
+    std::vector<ScatterLayer> layers;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".scatter")
+        {
+            continue;
+        }
+        ScatterLayer layer;
+        if (readScatterLayer(entry.path().string(), layer))
+        {
+            layers.push_back(std::move(layer));
+        }
+    }
+    if (error)
+    {
+        spdlog::warn("Scatter directory {} not readable: {}", directory, error.message());
+    }
+    return layers;
+}
+
+bool cookScatterLayer(const std::string& rawPath,
+                      const std::string& meshPath,
+                      const std::string& outPath,
+                      float size,
+                      float spacing,
+                      uint32_t seed)
+{
+    std::ifstream in(rawPath, std::ios::binary);
+    if (!in.is_open())
+    {
+        spdlog::error("Failed to open density map: {}", rawPath);
+        return false;
+    }
+
+    ScatterLayer layer;
+    layer.density.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    const auto width = static_cast<uint32_t>(std::lround(std::sqrt(static_cast<double>(layer.density.size()))));
+    if (width == 0 || width > kMaxResolution || static_cast<size_t>(width) * width != layer.density.size())
+    {
+        spdlog::error("{} is not a square 8-bit density map", rawPath);
+        return false;
+    }
+    if (!(size > 0.0f) || !(spacing > 0.0f))
+    {
+        spdlog::error("Invalid scatter size {} or spacing {}", size, spacing);
+        return false;
+    }
+
+    layer.meshPath = meshPath;
+    layer.origin = glm::vec2(-0.5f * size);
+    layer.size = size;
+    layer.spacing = spacing;
+    layer.seed = seed;
+    layer.minScale = 0.8f;
+    layer.maxScale = 1.2f;
+    layer.densityResolution = width;
+
+    std::error_code error;
+    const std::filesystem::path parent = std::filesystem::path(outPath).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent, error);
+    }
+    if (!writeScatterLayer(outPath, layer))
+    {
+        return false;
+    }
+
+    const float cells = size / spacing;
+    spdlog::info("Cooked scatter layer {} of {} with up to {:.0f} instances", outPath, meshPath, cells * cells);
+    return true;
+}
+
+} // namespace reactor
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+// One kind of prop (a tree, a rock, clutter) scattered procedurally over a square of the world.
+// The square is split into cells of spacing units; each cell holds at most one candidate, jittered
+// within it and kept with the probability the density map gives at its position. Every decision
+// is a hash of the cell and the seed, so the same instances appear wherever and whenever the cell
+// is evaluated and nothing per instance needs storing.
+struct ScatterLayer
+{
+    std::string meshPath;      // cooked .mesh drawn for every instance
+    uint32_t meshIndex = 0;
+    glm::vec2 origin{0.0f};    // world XZ of the density map's minimum corner
+    float size = 0.0f;         // world units per side of the density map
+    float spacing = 1.0f;      // world units per cell side
+    uint32_t seed = 0;
+    float minScale = 1.0f;
+    float maxScale = 1.0f;
+    float maxDistance = 200.0f; // instances farther from the camera are not drawn
+    uint32_t densityResolution = 0;
+    std::vector<uint8_t> density; // rows along +Z, 0 empty to 255 one instance per cell
+};
+
+// Scatter layer layout: char magic[8] = "R_SCATR", uint32 version, uint32 mesh path length, the
+// path, uint32 meshIndex, float originX, originZ, size, spacing, uint32 seed, float minScale,
+// maxScale, maxDistance, uint32 densityResolution, then the density samples.
+bool writeScatterLayer(const std::string& path, const ScatterLayer& layer);
+bool readScatterLayer(const std::string& path, ScatterLayer& layer);
+
+// Reads every .scatter file in directory. Unreadable files are logged and skipped.
+std::vector<ScatterLayer> loadScatterLayers(const std::string& directory);
+
+// Cooks a square 8-bit raw density map covering size world units around the origin into a layer
+// drawing meshPath. The side length is taken from the file size.
+bool cookScatterLayer(const std::string& rawPath,
+                      const std::string& meshPath,
+                      const std::string& outPath,
+                      float size,
+                      float spacing,
+                      uint32_t seed);
+
+} // namespace reactor
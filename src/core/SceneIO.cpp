@@ -0,0 +1,245 @@
+#include "SceneIO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kSceneVersion = 1;
+constexpr uint64_t kSectionAlignment = 16;
+
+struct SceneSection
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct SceneHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;
+    SceneSection objects;
+    SceneSection meshRefs;
+    SceneSection lights;
+    SceneSection strings;
+    SceneCamera camera;
+};
+static_assert(std::is_trivially_copyable_v<SceneHeader>);
+
+constexpr char kSceneMagic[8] = "R_SCENE";
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+bool sectionFits(const SceneSection& section, size_t elementSize, uint64_t fileSize)
+{
+    return section.offset % kSectionAlignment == 0 && section.offset <= fileSize
+           && section.count <= (fileSize - section.offset) / elementSize;
+}
+} // namespace
+
+bool saveScene(const std::string& path, const SceneData& scene)
+{
+    // String table and mesh references first, so the header can carry final sizes
+    std::string strings;
+    std::vector<SceneMeshRef> meshRefs(scene.meshes.size());
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        meshRefs[i].pathOffset = strings.size();
+        meshRefs[i].pathLength = static_cast<uint32_t>(scene.meshes[i].first.size());
+        meshRefs[i].meshIndex = scene.meshes[i].second;
+        strings += scene.meshes[i].first;
+    }
+
+    SceneHeader header{};
+    memcpy(header.magic, kSceneMagic, sizeof(header.magic));
+    header.version = kSceneVersion;
+    header.camera = scene.camera;
+
+    uint64_t offset = alignUp(sizeof(SceneHeader));
+    auto place = [&](SceneSection& section, uint64_t count, size_t elementSize) {
+        section = {offset, count};
+        offset = alignUp(offset + count * elementSize);
+    };
+    place(header.objects, scene.objects.size(), sizeof(SceneObject));
+    place(header.meshRefs, meshRefs.size(), sizeof(SceneMeshRef));
+    place(header.lights, scene.lights.size(), sizeof(SceneLight));
+    place(header.strings, strings.size(), 1);
+    header.fileSize = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        spdlog::error("Failed to open scene file for writing: {}", path);
+        return false;
+    }
+
+    const char padding[kSectionAlignment] = {};
+    auto write = [&](const SceneSection& section, const void* data, size_t bytes) {
+        out.seekp(static_cast<std::streamoff>(section.offset));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(header.objects, scene.objects.data(), scene.objects.size() * sizeof(SceneObject));
+    write(header.meshRefs, meshRefs.data(), meshRefs.size() * sizeof(SceneMeshRef));
+    write(header.lights, scene.lights.data(), scene.lights.size() * sizeof(SceneLight));
+    write(header.strings, strings.data(), strings.size());
+
+    // Pad the tail so the file size matches the header
+    const auto end = static_cast<uint64_t>(out.tellp());
+    out.write(padding, static_cast<std::streamsize>(header.fileSize - end));
+
+    if (!out.good())
+    {
+        spdlog::error("Failed to write scene file: {}", path);
+        return false;
+    }
+    spdlog::info("Saved scene {}: {} objects, {} meshes, {} lights",
+                 path, scene.objects.size(), meshRefs.size(), scene.lights.size());
+    return true;
+}
+
+std::unique_ptr<SceneFile> SceneFile::open(const std::string& path)
+{
+    std::unique_ptr<SceneFile> file(new SceneFile());
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        spdlog::error("Failed to open scene file: {}", path);
+        return nullptr;
+    }
+    file->m_file = handle;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(SceneHeader)))
+    {
+        spdlog::error("Scene file too small: {}", path);
+        return nullptr;
+    }
+    file->m_size = static_cast<size_t>(size.QuadPart);
+
+    // Copy-on-write so the relocation pass can patch pointers without touching the file
+    file->m_mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    file->m_base = file->m_mapping ? MapViewOfFile(file->m_mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+    if (!file->m_base)
+    {
+        spdlog::error("Failed to map scene file: {}", path);
+        return nullptr;
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::error("Failed to open scene file: {}", path);
+        return nullptr;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SceneHeader)))
+    {
+        ::close(fd);
+        spdlog::error("Scene file too small: {}", path);
+        return nullptr;
+    }
+    file->m_size = static_cast<size_t>(info.st_size);
+
+    // Copy-on-write so the relocation pass can patch pointers without touching the file
+    void* base = mmap(nullptr, file->m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        spdlog::error("Failed to map scene file: {}", path);
+        return nullptr;
+    }
+    file->m_base = base;
+    madvise(base, file->m_size, MADV_WILLNEED);
+#endif
+
+    auto* bytes = static_cast<char*>(file->m_base);
+    const auto* header = reinterpret_cast<const SceneHeader*>(bytes);
+    if (memcmp(header->magic, kSceneMagic, sizeof(kSceneMagic)) != 0 || header->version != kSceneVersion
+        || header->fileSize != file->m_size)
+    {
+        spdlog::error("Invalid scene file or version mismatch: {}", path);
+        return nullptr;
+    }
+    if (!sectionFits(header->objects, sizeof(SceneObject), file->m_size)
+        || !sectionFits(header->meshRefs, sizeof(SceneMeshRef), file->m_size)
+        || !sectionFits(header->lights, sizeof(SceneLight), file->m_size)
+        || !sectionFits(header->strings, 1, file->m_size))
+    {
+        spdlog::error("Truncated scene file: {}", path);
+        return nullptr;
+    }
+
+    // Relocation: string table offsets become pointers into the mapping
+    auto* meshRefs = reinterpret_cast<SceneMeshRef*>(bytes + header->meshRefs.offset);
+    const char* strings = bytes + header->strings.offset;
+    for (uint64_t i = 0; i < header->meshRefs.count; ++i)
+    {
+        SceneMeshRef& ref = meshRefs[i];
+        if (ref.pathOffset > header->strings.count || ref.pathLength > header->strings.count - ref.pathOffset)
+        {
+            spdlog::error("Scene file {} has a corrupt mesh reference", path);
+            return nullptr;
+        }
+        ref.path = strings + ref.pathOffset;
+    }
+
+    const auto* objects = reinterpret_cast<const SceneObject*>(bytes + header->objects.offset);
+    for (uint64_t i = 0; i < header->objects.count; ++i)
+    {
+        if (objects[i].meshRef >= header->meshRefs.count)
+        {
+            spdlog::error("Scene file {} has an object with an invalid mesh reference", path);
+            return nullptr;
+        }
+    }
+
+    file->m_objects = {objects, static_cast<size_t>(header->objects.count)};
+    file->m_meshRefs = {meshRefs, static_cast<size_t>(header->meshRefs.count)};
+    file->m_lights = {reinterpret_cast<const SceneLight*>(bytes + header->lights.offset),
+                      static_cast<size_t>(header->lights.count)};
+    file->m_camera = &header->camera;
+    return file;
+}
+
+SceneFile::~SceneFile()
+{
+#ifdef _WIN32
+    if (m_base)
+        UnmapViewOfFile(m_base);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+#else
+    if (m_base)
+        munmap(m_base, m_size);
+#endif
+}
+
+} // namespace reactor
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace reactor
+{
+
+// Scene records are plain data: each array is written as-is and used in place after mapping.
+
+struct SceneCamera
+{
+    glm::vec3 position{0.0f, 0.0f, 5.0f};
+    float fov = 45.0f;
+    glm::vec3 target{0.0f};
+    float reserved0 = 0.0f;
+    glm::vec3 up{0.0f, 1.0f, 0.0f};
+    float reserved1 = 0.0f;
+};
+
+// Mirrors DirectionalLightUBO.
+struct SceneLight
+{
+    glm::vec4 direction{-0.5f, 1.0f, -0.5f, 0.0f};
+    glm::vec4 color{1.0f};
+    float intensity = 1.0f;
+    float reserved[3] = {};
+};
+
+struct SceneMeshRef
+{
+    // On disk a byte offset into the string table; the relocation pass after mapping turns it
+    // into a pointer to the (not null-terminated) path.
+    union
+    {
+        uint64_t pathOffset;
+        const char* path;
+    };
+    uint32_t pathLength;
+    uint32_t meshIndex;
+};
+
+struct SceneObject
+{
+    glm::mat4 transform{1.0f};
+    uint32_t meshRef = 0; // index into the mesh reference array
+    uint32_t flags = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<SceneCamera> && sizeof(SceneCamera) == 48);
+static_assert(std::is_trivially_copyable_v<SceneLight> && sizeof(SceneLight) == 48);
+static_assert(std::is_trivially_copyable_v<SceneMeshRef> && sizeof(SceneMeshRef) == 16);
+static_assert(std::is_trivially_copyable_v<SceneObject> && sizeof(SceneObject) == 72);
+
+// Everything needed to write a scene. Mesh references are (path, mesh index) pairs that objects
+// point into by index.
+struct SceneData
+{
+    SceneCamera camera;
+    std::vector<SceneLight> lights;
+    std::vector<std::pair<std::string, uint32_t>> meshes;
+    std::vector<SceneObject> objects;
+};
+
+// Writes a .rscene file: a fixed header followed by the object, mesh reference, light and string
+// arrays. Returns false and logs when the file cannot be written.
+bool saveScene(const std::string& path, const SceneData& scene);
+
+// A .rscene file mapped copy-on-write. Opening validates the header and every index, then
+// relocates mesh reference paths; no other bytes are touched, so load time is dominated by the
+// kernel faulting pages in as they are read.
+class SceneFile
+{
+public:
+    // Null, with the reason logged, when the file is missing or malformed.
+    static std::unique_ptr<SceneFile> open(const std::string& path);
+    ~SceneFile();
+
+    SceneFile(const SceneFile&) = delete;
+    SceneFile& operator=(const SceneFile&) = delete;
+
+    [[nodiscard]] std::span<const SceneObject> objects() const
+    {
+        return m_objects;
+    }
+    [[nodiscard]] std::span<const SceneMeshRef> meshRefs() const
+    {
+        return m_meshRefs;
+    }
+    [[nodiscard]] std::span<const SceneLight> lights() const
+    {
+        return m_lights;
+    }
+    [[nodiscard]] const SceneCamera& camera() const
+    {
+        return *m_camera;
+    }
+
+    static std::string_view meshPath(const SceneMeshRef& ref)
+    {
+        return {ref.path, ref.pathLength};
+    }
+
+private:
+    SceneFile() = default;
+
+    void* m_base = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+
+    std::span<const SceneObject> m_objects;
+    std::span<const SceneMeshRef> m_meshRefs;
+    std::span<const SceneLight> m_lights;
+    const SceneCamera* m_camera = nullptr;
+};
+
+} // namespace reactor
@@ -0,0 +1,333 @@
+#include "SceneStore.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace reactor
+{
+
+BoundingSphere computeBounds(std::span<const Vertex> vertices)
+{
+    if (vertices.empty())
+    {
+        return {};
+    }
+
+    glm::vec3 lo = vertices.front().pos;
+    glm::vec3 hi = lo;
+    for (const Vertex& v : vertices)
+    {
+        lo = glm::min(lo, v.pos);
+        hi = glm::max(hi, v.pos);
+    }
+
+    BoundingSphere sphere;
+    sphere.center = (lo + hi) * 0.5f;
+    for (const Vertex& v : vertices)
+    {
+        sphere.radius = std::max(sphere.radius, glm::length(v.pos - sphere.center));
+    }
+    return sphere;
+}
+
+MeshId SceneStore::allocateMesh()
+{
+    if (!m_freeMeshes.empty())
+    {
+        const MeshId mesh = m_freeMeshes.back();
+        m_freeMeshes.pop_back();
+        return mesh;
+    }
+    m_meshSources.emplace_back();
+    return static_cast<MeshId>(m_meshSources.size() - 1);
+}
+
+MeshId SceneStore::addMesh(MeshHandle handle, const BoundingSphere& localBounds)
+{
+    const MeshId mesh = allocateMesh();
+    m_meshSources[mesh] = MeshSource{std::move(handle), nullptr, localBounds, 0};
+    return mesh;
+}
+
+MeshId SceneStore::addMesh(const std::shared_ptr<LodMesh>& lod)
+{
+    if (auto it = m_lodMeshIds.find(lod.get()); it != m_lodMeshIds.end())
+    {
+        return it->second;
+    }
+
+    const MeshId mesh = allocateMesh();
+    m_meshSources[mesh] = MeshSource{MeshHandle(), lod, {}, 0, true};
+    m_lodMeshIds.emplace(lod.get(), mesh);
+    return mesh;
+}
+
+void SceneStore::releaseMesh(MeshId mesh)
+{
+    MeshSource& source = m_meshSources[mesh];
+    if (--source.users > 0)
+    {
+        return;
+    }
+    if (source.lod)
+    {
+        m_lodMeshIds.erase(source.lod.get());
+    }
+    source = MeshSource{};
+    m_freeMeshes.push_back(mesh);
+}
+
+EntityId SceneStore::create(MeshId mesh, const glm::mat4& transform, uint32_t flags)
+{
+    EntityId entity;
+    if (!m_freeEntities.empty())
+    {
+        entity.index = m_freeEntities.back();
+        m_freeEntities.pop_back();
+    }
+    else
+    {
+        entity.index = static_cast<uint32_t>(m_denseIndex.size());
+        m_denseIndex.push_back(0);
+        m_generations.push_back(0);
+    }
+    entity.generation = m_generations[entity.index];
+    m_denseIndex[entity.index] = static_cast<uint32_t>(m_transforms.size());
+
+    m_transforms.push_back(transform);
+    m_bounds.push_back({});
+    m_meshes.push_back(mesh);
+    m_flags.push_back(flags | EntityBoundsDirty);
+    m_entities.push_back(entity);
+
+    m_hierarchy.add(entity.index, transform);
+    m_meshSources[mesh].users++;
+    return entity;
+}
+
+void SceneStore::destroy(EntityId entity)
+{
+    if (!contains(entity))
+    {
+        return;
+    }
+
+    const uint32_t dense = m_denseIndex[entity.index];
+    const uint32_t last = static_cast<uint32_t>(m_transforms.size() - 1);
+    releaseMesh(m_meshes[dense]);
+    m_hierarchy.remove(entity.index);
+    if (m_bvh.contains(entity.index))
+    {
+        m_bvh.remove(entity.index);
+    }
+
+    if (dense != last)
+    {
+        m_transforms[dense] = m_transforms[last];
+        m_bounds.set(dense, m_bounds.get(last));
+        m_meshes[dense] = m_meshes[last];
+        m_flags[dense] = m_flags[last];
+        m_entities[dense] = m_entities[last];
+        m_denseIndex[m_entities[dense].index] = dense;
+    }
+    m_transforms.pop_back();
+    m_bounds.pop_back();
+    m_meshes.pop_back();
+    m_flags.pop_back();
+    m_entities.pop_back();
+
+    m_generations[entity.index]++;
+    m_freeEntities.push_back(entity.index);
+}
+
+void SceneStore::clear()
+{
+    for (EntityId entity : m_entities)
+    {
+        m_generations[entity.index]++;
+        m_freeEntities.push_back(entity.index);
+    }
+    m_transforms.clear();
+    m_bounds.clear();
+    m_meshes.clear();
+    m_flags.clear();
+    m_entities.clear();
+    m_hierarchy.clear();
+    m_bvh.clear();
+    m_indexPending.clear();
+    m_indexQueued.clear();
+
+    m_meshSources.clear();
+    m_freeMeshes.clear();
+    m_lodMeshIds.clear();
+}
+
+bool SceneStore::contains(EntityId entity) const
+{
+    return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation
+           && m_denseIndex[entity.index] < m_entities.size() && m_entities[m_denseIndex[entity.index]] == entity;
+}
+
+void SceneStore::setTransform(EntityId entity, const glm::mat4& transform)
+{
+    assert(contains(entity));
+    m_hierarchy.setLocal(entity.index, transform);
+}
+
+void SceneStore::setVisible(EntityId entity, bool visible)
+{
+    assert(contains(entity));
+    uint32_t& flags = m_flags[m_denseIndex[entity.index]];
+    flags = visible ? flags | EntityVisible : flags & ~EntityVisible;
+}
+
+const glm::mat4& SceneStore::localTransform(EntityId entity) const
+{
+    assert(contains(entity));
+    return m_hierarchy.local(entity.index);
+}
+
+bool SceneStore::setParent(EntityId entity, EntityId parent)
+{
+    assert(contains(entity) && (!parent.valid() || contains(parent)));
+    return m_hierarchy.setParent(entity.index, parent.valid() ? parent.index : TransformHierarchy::kNone);
+}
+
+EntityId SceneStore::parent(EntityId entity) const
+{
+    assert(contains(entity));
+    const uint32_t index = m_hierarchy.parent(entity.index);
+    if (index == TransformHierarchy::kNone)
+    {
+        return {};
+    }
+    return {index, m_generations[index]};
+}
+
+void SceneStore::updateTransforms(ThreadPool* pool)
+{
+    m_hierarchy.update(pool);
+    for (const auto& [begin, end] : m_hierarchy.updatedRanges())
+    {
+        for (uint32_t node = begin; node < end; ++node)
+        {
+            const uint32_t dense = m_denseIndex[m_hierarchy.slotAt(node)];
+            m_transforms[dense] = m_hierarchy.worldAt(node);
+            m_flags[dense] |= EntityBoundsDirty;
+        }
+    }
+}
+
+void SceneStore::updateBounds()
+{
+    // LOD meshes learn their bounds asynchronously. The state is read first, so bounds read after
+    // it stopped loading are final; a mesh without bounds, or that failed, keeps a zero radius.
+    for (MeshSource& source : m_meshSources)
+    {
+        if (source.lod && source.boundsPending)
+        {
+            const bool loading = source.lod->isLoading();
+            source.localBounds = {source.lod->boundsCenter(), source.lod->boundsRadius()};
+            source.boundsPending = loading;
+        }
+    }
+
+    for (size_t i = 0; i < m_flags.size(); ++i)
+    {
+        if ((m_flags[i] & EntityBoundsDirty) == 0)
+        {
+            continue;
+        }
+
+        const MeshSource& source = m_meshSources[m_meshes[i]];
+        const BoundingSphere& local = source.localBounds;
+        const glm::mat4& transform = m_transforms[i];
+        const float scale = std::max({glm::length(glm::vec3(transform[0])),
+                                      glm::length(glm::vec3(transform[1])),
+                                      glm::length(glm::vec3(transform[2]))});
+        const BoundingSphere world{glm::vec3(transform * glm::vec4(local.center, 1.0f)), local.radius * scale};
+        m_bounds.set(i, world);
+
+        const uint32_t slot = m_entities[i].index;
+        if (slot >= m_indexQueued.size())
+        {
+            m_indexQueued.resize(m_generations.size(), 0);
+        }
+        if (!m_indexQueued[slot])
+        {
+            m_indexQueued[slot] = 1;
+            m_indexPending.push_back(slot);
+        }
+
+        // Entities stay dirty only until their mesh's bounds are known, even when they are empty
+        if (!source.boundsPending)
+        {
+            m_flags[i] &= ~EntityBoundsDirty;
+        }
+    }
+}
+
+void SceneStore::refreshIndex() const
+{
+    if (m_indexPending.empty())
+    {
+        return;
+    }
+    for (const uint32_t slot : m_indexPending)
+    {
+        m_indexQueued[slot] = 0;
+        // Destroyed since it was queued; destroy() already took it out of the tree
+        if (!contains(entityAt(slot)))
+        {
+            continue;
+        }
+        m_bvh.update(slot, Aabb::fromSphere(m_bounds.get(m_denseIndex[slot])));
+    }
+    m_indexPending.clear();
+    m_bvh.refit();
+}
+
+EntityId SceneStore::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* distance) const
+{
+    refreshIndex();
+
+    const glm::vec3 dir = glm::normalize(direction);
+    const BvhRayHit hit = m_bvh.raycast(origin, dir, maxDistance, [&](uint32_t slot, float& t) {
+        const uint32_t dense = m_denseIndex[slot];
+        if ((m_flags[dense] & EntityVisible) == 0)
+        {
+            return false;
+        }
+
+        // Ray against the sphere inside the box
+        const BoundingSphere sphere = m_bounds.get(dense);
+        const glm::vec3 offset = origin - sphere.center;
+        const float b = glm::dot(offset, dir);
+        const float c = glm::dot(offset, offset) - sphere.radius * sphere.radius;
+        const float discriminant = b * b - c;
+        if (discriminant < 0.0f)
+        {
+            return false;
+        }
+        const float root = std::sqrt(discriminant);
+        if (-b + root < 0.0f)
+        {
+            return false; // behind the origin
+        }
+        t = std::max(-b - root, 0.0f);
+        return true;
+    });
+
+    if (!hit.hit())
+    {
+        return {};
+    }
+    if (distance)
+    {
+        *distance = hit.distance;
+    }
+    return entityAt(hit.slot);
+}
+
+} // namespace reactor
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "../vulkan/Mesh.hpp"
+#include "Bvh.hpp"
+#include "Culling.hpp"
+#include "LodMesh.hpp"
+#include "ThreadPool.hpp"
+#include "TransformHierarchy.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace reactor
+{
+
+// Stable reference to an entity. The generation detects use after the entity was destroyed and
+// its slot reused.
+struct EntityId
+{
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool valid() const
+    {
+        return index != std::numeric_limits<uint32_t>::max();
+    }
+    bool operator==(const EntityId&) const = default;
+};
+
+enum EntityFlags : uint32_t
+{
+    EntityVisible = 1u << 0,
+    EntityBoundsDirty = 1u << 1, // world bounds need recomputing
+    EntityStreamed = 1u << 2,    // owned by the world partition, not saved with the scene
+    EntityOccluder = 1u << 3,    // its mesh's coarsest level hides others in software occlusion
+};
+
+// Sphere centred on the vertices' axis-aligned box; loose, but good enough for culling and LOD.
+BoundingSphere computeBounds(std::span<const Vertex> vertices);
+
+using MeshId = uint32_t;
+
+// Where an entity's geometry comes from: a plain mesh, or a LOD mesh when lod is set.
+struct MeshSource
+{
+    MeshHandle handle;
+    std::shared_ptr<LodMesh> lod;
+    BoundingSphere localBounds;
+    uint32_t users = 0;
+    bool boundsPending = false; // an LOD mesh whose table of contents is still loading
+};
+
+// Scene entities as parallel dense arrays: world transforms, world bounds, mesh ids and flags,
+// plus the entity id at each position. Per-object loops walk exactly the arrays they need; mesh
+// sources live in a separate table that entities index, so iterating never touches a reference
+// count. Destroying swaps the last entity into the hole, keeping the arrays dense; EntityId stays
+// valid across such moves. Entities may be parented; local transforms live in a TransformHierarchy
+// and world transforms follow at updateTransforms(). Render thread only.
+class SceneStore
+{
+public:
+    // Registers a mesh source for entities to reference; it is released with its last entity.
+    MeshId addMesh(MeshHandle handle, const BoundingSphere& localBounds = {});
+    // LOD meshes are deduplicated; their bounds come from the table of contents once it is loaded.
+    MeshId addMesh(const std::shared_ptr<LodMesh>& lod);
+
+    EntityId create(MeshId mesh, const glm::mat4& transform, uint32_t flags = EntityVisible);
+    void destroy(EntityId entity);
+    void clear();
+
+    [[nodiscard]] bool contains(EntityId entity) const;
+
+    // Transform relative to the parent, or to the world for roots.
+    void setTransform(EntityId entity, const glm::mat4& transform);
+    [[nodiscard]] const glm::mat4& localTransform(EntityId entity) const;
+
+    // Sets or clears EntityVisible; hidden entities are skipped by culling and picking.
+    void setVisible(EntityId entity, bool visible);
+
+    // Attaches entity below parent, or detaches it when parent is invalid, keeping it where it is
+    // in the world. Returns false when that would create a cycle. Children of a destroyed entity
+    // attach to its parent.
+    bool setParent(EntityId entity, EntityId parent);
+    [[nodiscard]] EntityId parent(EntityId entity) const;
+
+    // Recomputes world transforms below entities moved since the last call, spreading large
+    // batches over pool when given. Call once per frame before anything reads transforms().
+    void updateTransforms(ThreadPool* pool = nullptr);
+
+    // Recomputes world bounds of entities flagged dirty. An entity stays dirty until its mesh's
+    // local bounds are known. Call after updateTransforms() and before anything reads bounds().
+    // Moved entities are only queued for the spatial index; it catches up at its next query.
+    void updateBounds();
+
+    // Nearest visible entity whose bounding sphere the ray hits within maxDistance, or an invalid
+    // id. distance receives the hit distance when given.
+    [[nodiscard]] EntityId raycast(const glm::vec3& origin,
+                                   const glm::vec3& direction,
+                                   float maxDistance,
+                                   float* distance = nullptr) const;
+
+    // Spatial index over world bounds, keyed by EntityId::index; entityAt() turns its slots back
+    // into ids.
+    [[nodiscard]] const DynamicBvh& spatialIndex() const
+    {
+        refreshIndex();
+        return m_bvh;
+    }
+    [[nodiscard]] EntityId entityAt(uint32_t slot) const
+    {
+        return {slot, m_generations[slot]};
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_transforms.size();
+    }
+    [[nodiscard]] std::span<const glm::mat4> transforms() const
+    {
+        return m_transforms;
+    }
+    [[nodiscard]] const BoundsArrays& bounds() const
+    {
+        return m_bounds;
+    }
+    [[nodiscard]] std::span<const MeshId> meshes() const
+    {
+        return m_meshes;
+    }
+    [[nodiscard]] std::span<const uint32_t> flags() const
+    {
+        return m_flags;
+    }
+    [[nodiscard]] std::span<const EntityId> entities() const
+    {
+        return m_entities;
+    }
+
+    [[nodiscard]] const MeshSource& meshSource(MeshId mesh) const
+    {
+        return m_meshSources[mesh];
+    }
+    // One past the highest MeshId in use; released ids in between have no users.
+    [[nodiscard]] size_t meshSourceCount() const
+    {
+        return m_meshSources.size();
+    }
+
+private:
+    MeshId allocateMesh();
+    void releaseMesh(MeshId mesh);
+    // Applies the bounds queued by updateBounds() to the spatial index and refits it.
+    void refreshIndex() const;
+
+    // Dense, indexed by position
+    std::vector<glm::mat4> m_transforms;
+    BoundsArrays m_bounds;
+    std::vector<MeshId> m_meshes;
+    std::vector<uint32_t> m_flags;
+    std::vector<EntityId> m_entities;
+
+    // Sparse, indexed by EntityId::index
+    std::vector<uint32_t> m_denseIndex;
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_freeEntities;
+    TransformHierarchy m_hierarchy; // keyed by EntityId::index
+
+    // Keyed by EntityId::index. Maintained lazily: scenes nobody queries pay nothing per frame,
+    // hence mutable so const queries can bring it up to date.
+    mutable DynamicBvh m_bvh;
+    mutable std::vector<uint32_t> m_indexPending; // slots whose bounds changed since the last query
+    mutable std::vector<uint8_t> m_indexQueued;   // by EntityId::index, whether in m_indexPending
+
+    std::vector<MeshSource> m_meshSources;
+    std::vector<MeshId> m_freeMeshes;
+    std::unordered_map<const LodMesh*, MeshId> m_lodMeshIds;
+};
+
+} // namespace reactor
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace reactor
+{
+
+template <typename T>
+class Task;
+
+namespace detail
+{
+
+struct TaskPromiseBase
+{
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+
+    // Hands control back to whoever awaited the task, on whatever thread finished it.
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+    void unhandled_exception()
+    {
+        exception = std::current_exception();
+    }
+};
+
+// Fire-and-forget coroutine used by spawn(); its frame frees itself on completion.
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() const noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. Nothing runs until the task is awaited (or spawned);
+// the awaiting coroutine is resumed on the thread that completes the task.
+template <typename T>
+class Task
+{
+public:
+    struct promise_type : detail::TaskPromiseBase
+    {
+        std::optional<T> value;
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        template <typename U>
+        void return_value(U&& result)
+        {
+            value.emplace(std::forward<U>(result));
+        }
+    };
+
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, {}))
+    {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        auto& promise = m_handle.promise();
+        if (promise.exception)
+            std::rethrow_exception(promise.exception);
+        return std::move(*promise.value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template <>
+class Task<void>
+{
+public:
+    struct promise_type : detail::TaskPromiseBase
+    {
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_void() const noexcept {}
+    };
+
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, {}))
+    {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    void await_resume()
+    {
+        if (m_handle.promise().exception)
+            std::rethrow_exception(m_handle.promise().exception);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Starts a task nobody awaits. onDone receives the result; exceptions are logged.
+template <typename T, typename OnDone>
+detail::DetachedTask spawn(Task<T> task, OnDone onDone)
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            co_await task;
+            onDone();
+        }
+        else
+        {
+            onDone(co_await task);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Detached task failed: {}", e.what());
+    }
+}
+
+} // namespace reactor
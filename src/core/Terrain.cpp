@@ -0,0 +1,580 @@
+#include "Terrain.hpp"
+
+#include "AsyncIO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kHeightTileVersion = 1;
+constexpr uint32_t kMaxResolution = 8193;
+constexpr float kNoMorph = 1e30f; // morph range of the coarsest level, which has nothing to blend into
+
+// Bounds-checked cursor over a loaded tile.
+struct TileReader
+{
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+
+    bool read(void* out, size_t bytes)
+    {
+        if (bytes > size - offset)
+            return false;
+        memcpy(out, data + offset, bytes);
+        offset += bytes;
+        return true;
+    }
+};
+
+bool readHeader(TileReader& reader, const std::string& name, HeightTile& tile)
+{
+    char magic[8];
+    uint32_t version;
+    if (!reader.read(magic, sizeof(magic)) || !reader.read(&version, sizeof(version))
+        || !reader.read(&tile.resolution, sizeof(tile.resolution)) || !reader.read(&tile.tileSize, sizeof(float))
+        || !reader.read(&tile.minHeight, sizeof(float)) || !reader.read(&tile.maxHeight, sizeof(float)))
+    {
+        spdlog::error("Truncated height tile: {}", name);
+        return false;
+    }
+
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_HTILE" || version != kHeightTileVersion)
+    {
+        spdlog::error("Invalid height tile or version mismatch: {}", name);
+        return false;
+    }
+    if (tile.resolution < 2 || tile.resolution > kMaxResolution || !(tile.tileSize > 0.0f))
+    {
+        spdlog::error("Height tile {} has an invalid layout", name);
+        return false;
+    }
+    return true;
+}
+
+// Nodes are stored finest level first, each level in rows along +Z
+uint32_t nodeIndex(uint32_t levelCount, uint32_t level, uint32_t x, uint32_t z)
+{
+    uint32_t offset = 0;
+    for (uint32_t l = 0; l < level; ++l)
+    {
+        const uint32_t side = 1u << (levelCount - 1 - l);
+        offset += side * side;
+    }
+    return offset + z * (1u << (levelCount - 1 - level)) + x;
+}
+
+std::vector<glm::vec2> buildHeightRanges(const HeightTile& tile, uint32_t gridSize, uint32_t levelCount)
+{
+    const float scale = (tile.maxHeight - tile.minHeight) / 65535.0f;
+    std::vector<glm::vec2> ranges(nodeIndex(levelCount, levelCount - 1, 0, 0) + 1);
+
+    // Leaves include their far row and column, which they share with the next leaf
+    const uint32_t leaves = 1u << (levelCount - 1);
+    for (uint32_t z = 0; z < leaves; ++z)
+    {
+        for (uint32_t x = 0; x < leaves; ++x)
+        {
+            uint16_t lo = 0xffff;
+            uint16_t hi = 0;
+            for (uint32_t sz = z * gridSize; sz <= (z + 1) * gridSize; ++sz)
+            {
+                const uint16_t* row = tile.samples.data() + sz * tile.resolution;
+                const auto [rowLo, rowHi] = std::minmax_element(row + x * gridSize, row + (x + 1) * gridSize + 1);
+                lo = std::min(lo, *rowLo);
+                hi = std::max(hi, *rowHi);
+            }
+            ranges[nodeIndex(levelCount, 0, x, z)] =
+                glm::vec2(tile.minHeight + lo * scale, tile.minHeight + hi * scale);
+        }
+    }
+
+    for (uint32_t level = 1; level < levelCount; ++level)
+    {
+        const uint32_t side = 1u << (levelCount - 1 - level);
+        for (uint32_t z = 0; z < side; ++z)
+        {
+            for (uint32_t x = 0; x < side; ++x)
+            {
+                glm::vec2 range = ranges[nodeIndex(levelCount, level - 1, 2 * x, 2 * z)];
+                for (uint32_t q = 1; q < 4; ++q)
+                {
+                    const glm::vec2 child = ranges[nodeIndex(levelCount, level - 1, 2 * x + (q & 1), 2 * z + (q >> 1))];
+                    range = glm::vec2(std::min(range.x, child.x), std::max(range.y, child.y));
+                }
+                ranges[nodeIndex(levelCount, level, x, z)] = range;
+            }
+        }
+    }
+    return ranges;
+}
+
+// Whether any point of the box lies within radius of center
+bool withinReach(const glm::vec3& center, float radius, const glm::vec3& lo, const glm::vec3& hi)
+{
+    const glm::vec3 nearest = glm::clamp(center, lo, hi);
+    const glm::vec3 offset = center - nearest;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+} // namespace
+
+bool writeHeightTile(const std::string& path, const HeightTile& tile)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open())
+    {
+        spdlog::error("Failed to open height tile for writing: {}", path);
+        return false;
+    }
+
+    const char magic[8] = "R_HTILE";
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char*>(&kHeightTileVersion), sizeof(kHeightTileVersion));
+    out.write(reinterpret_cast<const char*>(&tile.resolution), sizeof(tile.resolution));
+    out.write(reinterpret_cast<const char*>(&tile.tileSize), sizeof(float));
+    out.write(reinterpret_cast<const char*>(&tile.minHeight), sizeof(float));
+    out.write(reinterpret_cast<const char*>(&tile.maxHeight), sizeof(float));
+    out.write(reinterpret_cast<const char*>(tile.samples.data()), tile.samples.size() * sizeof(uint16_t));
+    return out.good();
+}
+
+bool parseHeightTile(const char* data, size_t size, const std::string& name, HeightTile& tile)
+{
+    TileReader reader{data, size};
+    if (!readHeader(reader, name, tile))
+    {
+        return false;
+    }
+
+    tile.samples.resize(static_cast<size_t>(tile.resolution) * tile.resolution);
+    if (!reader.read(tile.samples.data(), tile.samples.size() * sizeof(uint16_t)))
+    {
+        spdlog::error("Truncated height tile: {}", name);
+        return false;
+    }
+    return true;
+}
+
+bool cookHeightmap(const std::string& rawPath,
+                   const std::string& outDirectory,
+                   uint32_t tileResolution,
+                   float sampleSpacing,
+                   float minHeight,
+                   float maxHeight)
+{
+    std::ifstream in(rawPath, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+    {
+        spdlog::error("Failed to open heightmap: {}", rawPath);
+        return false;
+    }
+    const auto bytes = static_cast<size_t>(in.tellg());
+    const auto width = static_cast<uint32_t>(std::lround(std::sqrt(static_cast<double>(bytes / 2))));
+    if (width < 2 || static_cast<size_t>(width) * width * 2 != bytes)
+    {
+        spdlog::error("{} is not a square 16-bit heightmap", rawPath);
+        return false;
+    }
+    if (tileResolution < 2 || tileResolution > kMaxResolution)
+    {
+        spdlog::error("Invalid tile resolution {}", tileResolution);
+        return false;
+    }
+
+    std::vector<uint16_t> heights(static_cast<size_t>(width) * width);
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(heights.data()), static_cast<std::streamsize>(bytes));
+    if (!in.good())
+    {
+        spdlog::error("Failed to read heightmap: {}", rawPath);
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outDirectory, error);
+
+    // Tiles overlap by one sample, and the grid is centred so the terrain sits around the origin
+    const uint32_t span = tileResolution - 1;
+    const uint32_t tilesPerSide = (width - 1 + span - 1) / span;
+    const int32_t first = -static_cast<int32_t>(tilesPerSide / 2);
+
+    HeightTile tile;
+    tile.resolution = tileResolution;
+    tile.tileSize = static_cast<float>(span) * sampleSpacing;
+    tile.minHeight = minHeight;
+    tile.maxHeight = maxHeight;
+    tile.samples.resize(static_cast<size_t>(tileResolution) * tileResolution);
+
+    for (uint32_t tz = 0; tz < tilesPerSide; ++tz)
+    {
+        for (uint32_t tx = 0; tx < tilesPerSide; ++tx)
+        {
+            for (uint32_t z = 0; z < tileResolution; ++z)
+            {
+                const uint32_t sz = std::min(tz * span + z, width - 1);
+                for (uint32_t x = 0; x < tileResolution; ++x)
+                {
+                    const uint32_t sx = std::min(tx * span + x, width - 1);
+                    tile.samples[z * tileResolution + x] = heights[static_cast<size_t>(sz) * width + sx];
+                }
+            }
+
+            const std::string name = "tile_" + std::to_string(first + static_cast<int32_t>(tx)) + "_"
+                                     + std::to_string(first + static_cast<int32_t>(tz)) + ".height";
+            if (!writeHeightTile((std::filesystem::path(outDirectory) / name).string(), tile))
+            {
+                return false;
+            }
+        }
+    }
+
+    spdlog::info("Cooked {}x{} height tiles of {} samples from {}", tilesPerSide, tilesPerSide, tileResolution, rawPath);
+    return true;
+}
+
+Terrain::Terrain(std::string directory, const TerrainSettings& settings)
+    : m_directory(std::move(directory)), m_settings(settings)
+{
+    scanDirectory();
+    if (m_tiles.empty())
+    {
+        return;
+    }
+
+    // Every node is drawn with gridSize quads, so leaves span gridSize samples and each level
+    // above doubles them up to the whole tile
+    const uint32_t span = m_layout.resolution - 1;
+    const uint32_t gridSize = m_settings.gridSize;
+    if (gridSize < 2 || gridSize % 2 != 0 || span % gridSize != 0 || ((span / gridSize) & (span / gridSize - 1)) != 0)
+    {
+        spdlog::error("Terrain tiles of {} samples do not fit a grid of {} quads", m_layout.resolution, gridSize);
+        return;
+    }
+    m_levelCount = static_cast<uint32_t>(std::log2(span / gridSize)) + 1;
+
+    for (uint32_t slot = m_settings.maxResidentTiles; slot > 0; --slot)
+    {
+        m_freeSlots.push_back(slot - 1);
+    }
+
+    m_heightExtent.assign(m_levelCount, 0.0f);
+    updateReach({});
+    spdlog::info("Terrain: {} levels of {} quads per chunk", m_levelCount, gridSize);
+}
+
+void Terrain::updateReach(const std::vector<glm::vec2>& heightRanges)
+{
+    for (uint32_t level = 0; level < m_levelCount && !heightRanges.empty(); ++level)
+    {
+        const uint32_t first = nodeIndex(m_levelCount, level, 0, 0);
+        const uint32_t side = 1u << (m_levelCount - 1 - level);
+        for (uint32_t i = first; i < first + side * side; ++i)
+        {
+            m_heightExtent[level] = std::max(m_heightExtent[level], heightRanges[i].y - heightRanges[i].x);
+        }
+    }
+
+    // A level's vertices finish blending at its reach, and a neighbour one level coarser starts
+    // blending morphStart of its own span later. That neighbour can be no further than the finer
+    // node's diagonal, which the reach must leave room for. Reaches only grow, so steeper tiles
+    // arriving shift the levels outwards once rather than back and forth
+    const float leafSize = m_layout.tileSize / static_cast<float>(1u << (m_levelCount - 1));
+    const float morphStart = std::max(m_settings.morphStart, 0.1f);
+    float firstReach = m_reach.empty() ? m_settings.detailDistance : m_reach.front();
+    for (uint32_t level = 0; level < m_levelCount; ++level)
+    {
+        const float size = leafSize * static_cast<float>(1u << level);
+        const float diagonal = std::sqrt(2.0f * size * size + m_heightExtent[level] * m_heightExtent[level]);
+        firstReach = std::max(firstReach, diagonal / (morphStart * static_cast<float>(1u << level)));
+    }
+    if (!m_reach.empty() && firstReach == m_reach.front())
+    {
+        return;
+    }
+
+    m_reach.clear();
+    m_morphRange.clear();
+    float previous = 0.0f;
+    for (uint32_t level = 0; level < m_levelCount; ++level)
+    {
+        const float reach = firstReach * static_cast<float>(1u << level);
+        m_reach.push_back(reach);
+        m_morphRange.emplace_back(previous + m_settings.morphStart * (reach - previous), reach);
+        previous = reach;
+    }
+    m_morphRange.back() = glm::vec2(kNoMorph, 2.0f * kNoMorph);
+}
+
+void Terrain::scanDirectory()
+{
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, error))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".height")
+        {
+            continue;
+        }
+
+        int32_t x;
+        int32_t z;
+        char tail;
+        if (std::sscanf(entry.path().stem().string().c_str(), "tile_%d_%d%c", &x, &z, &tail) != 2)
+        {
+            continue;
+        }
+        m_tiles[{x, z}].path = entry.path().string();
+    }
+
+    m_stats.tileCount = m_tiles.size();
+    if (error)
+    {
+        spdlog::warn("Terrain directory {} not readable: {}", m_directory, error.message());
+        return;
+    }
+    if (m_tiles.empty())
+    {
+        return;
+    }
+
+    // The layout is needed before any tile streams in; the others are checked against it on load
+    const std::string& first = m_tiles.begin()->second.path;
+    char header[28];
+    std::ifstream in(first, std::ios::binary);
+    in.read(header, sizeof(header));
+    TileReader reader{header, in.good() ? sizeof(header) : 0};
+    if (!readHeader(reader, first, m_layout))
+    {
+        m_tiles.clear();
+        return;
+    }
+    spdlog::info("Terrain: {} tiles of {} units in {}", m_tiles.size(), m_layout.tileSize, m_directory);
+}
+
+void Terrain::startLoad(const TileCoord& coord, Tile& tile)
+{
+    tile.state = TileState::Loading;
+    m_loadsInFlight++;
+
+    ReadRequest request;
+    request.path = tile.path;
+    request.onComplete = [inbox = m_inbox, coord, layout = m_layout, gridSize = m_settings.gridSize,
+                          levelCount = m_levelCount](ReadResult&& file) {
+        LoadedTile loaded{coord, {}, {}};
+        bool ok = file.ok && parseHeightTile(file.data.data(), file.data.size(), file.path, loaded.tile);
+        if (ok && (loaded.tile.resolution != layout.resolution || loaded.tile.tileSize != layout.tileSize
+                   || loaded.tile.minHeight != layout.minHeight || loaded.tile.maxHeight != layout.maxHeight))
+        {
+            spdlog::error("Height tile {} does not match the terrain's layout", file.path);
+            ok = false;
+        }
+        if (ok)
+        {
+            loaded.heightRanges = buildHeightRanges(loaded.tile, gridSize, levelCount);
+        }
+        else
+        {
+            spdlog::error("Failed to load height tile {}", file.path);
+        }
+
+        std::lock_guard lock(inbox->mutex);
+        if (ok)
+        {
+            inbox->completed.push_back(std::move(loaded));
+        }
+        else
+        {
+            inbox->failed.push_back(coord);
+        }
+    };
+
+    std::vector<ReadRequest> batch;
+    batch.push_back(std::move(request));
+    AsyncIO::shared().submit(std::move(batch));
+}
+
+float Terrain::distanceTo(const TileCoord& coord, const glm::vec3& focus) const
+{
+    // To the nearest point of the tile, so the ground under the focus always streams first
+    const glm::vec2 lo = glm::vec2(coord.first, coord.second) * m_layout.tileSize;
+    const glm::vec2 point(focus.x, focus.z);
+    return glm::length(point - glm::clamp(point, lo, lo + m_layout.tileSize));
+}
+
+void Terrain::update(const glm::vec3& focus, std::vector<TerrainUpload>& uploads)
+{
+    if (!valid())
+    {
+        return;
+    }
+
+    std::vector<LoadedTile> completed;
+    std::vector<TileCoord> failed;
+    {
+        std::lock_guard lock(m_inbox->mutex);
+        completed.swap(m_inbox->completed);
+        failed.swap(m_inbox->failed);
+    }
+    for (LoadedTile& loaded : completed)
+    {
+        m_loadsInFlight--;
+        Tile& tile = m_tiles[loaded.coord];
+        if (distanceTo(loaded.coord, focus) > m_settings.unloadRadius || m_freeSlots.empty())
+        {
+            tile.state = TileState::Unloaded;
+            continue;
+        }
+        tile.state = TileState::Resident;
+        tile.slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        tile.heightRanges = std::move(loaded.heightRanges);
+        updateReach(tile.heightRanges);
+        uploads.push_back({tile.slot, std::move(loaded.tile)});
+    }
+    // Broken tiles are not retried every frame
+    for (const TileCoord& coord : failed)
+    {
+        m_loadsInFlight--;
+        m_tiles[coord].state = TileState::Failed;
+    }
+
+    // Drop tiles beyond the outer radius; queue loads inside the inner one
+    std::vector<std::pair<float, TileCoord>> wanted;
+    for (auto& [coord, tile] : m_tiles)
+    {
+        const float distance = distanceTo(coord, focus);
+        if (tile.state == TileState::Resident && distance > m_settings.unloadRadius)
+        {
+            // A frame in flight may still sample the layer; its next upload waits for vertex reads
+            m_freeSlots.push_back(tile.slot);
+            tile.heightRanges.clear();
+            tile.state = TileState::Unloaded;
+        }
+        else if (tile.state == TileState::Unloaded && distance <= m_settings.loadRadius)
+        {
+            wanted.emplace_back(distance, coord);
+        }
+    }
+
+    // Every read in flight is promised a layer, so nearer tiles are not starved by farther ones
+    std::sort(wanted.begin(), wanted.end());
+    for (const auto& [distance, coord] : wanted)
+    {
+        if (m_loadsInFlight >= m_settings.maxConcurrentLoads || m_loadsInFlight >= m_freeSlots.size())
+        {
+            break;
+        }
+        startLoad(coord, m_tiles[coord]);
+    }
+
+    m_stats.residentTiles = m_settings.maxResidentTiles - m_freeSlots.size();
+    m_stats.loadingTiles = m_loadsInFlight;
+}
+
+void Terrain::select(const Frustum& frustum, const glm::vec3& eye, std::vector<TerrainChunk>& chunks)
+{
+    const size_t first = chunks.size();
+    for (const auto& [coord, tile] : m_tiles)
+    {
+        if (tile.state == TileState::Resident)
+        {
+            const glm::vec2 origin = glm::vec2(coord.first, coord.second) * m_layout.tileSize;
+            selectNode(tile, origin, m_levelCount - 1, 0, 0, frustum, eye, chunks);
+        }
+    }
+    m_stats.chunkCount = chunks.size() - first;
+}
+
+void Terrain::residentSlots(glm::ivec2& firstTile, glm::uvec2& tileCount, std::vector<uint32_t>& slots) const
+{
+    glm::ivec2 lo(INT32_MAX);
+    glm::ivec2 hi(INT32_MIN);
+    for (const auto& [coord, tile] : m_tiles)
+    {
+        if (tile.state == TileState::Resident)
+        {
+            lo = glm::min(lo, glm::ivec2(coord.first, coord.second));
+            hi = glm::max(hi, glm::ivec2(coord.first, coord.second));
+        }
+    }
+
+    slots.clear();
+    if (lo.x > hi.x)
+    {
+        firstTile = glm::ivec2(0);
+        tileCount = glm::uvec2(0);
+        return;
+    }
+
+    firstTile = lo;
+    tileCount = glm::uvec2(hi - lo + 1);
+    slots.assign(static_cast<size_t>(tileCount.x) * tileCount.y, kNoSlot);
+    for (const auto& [coord, tile] : m_tiles)
+    {
+        if (tile.state == TileState::Resident)
+        {
+            slots[(coord.second - lo.y) * tileCount.x + (coord.first - lo.x)] = tile.slot;
+        }
+    }
+}
+
+void Terrain::selectNode(const Tile& tile,
+                         const glm::vec2& tileOrigin,
+                         uint32_t level,
+                         uint32_t x,
+                         uint32_t z,
+                         const Frustum& frustum,
+                         const glm::vec3& eye,
+                         std::vector<TerrainChunk>& chunks) const
+{
+    auto bounds = [&](uint32_t nodeLevel, uint32_t nodeX, uint32_t nodeZ) {
+        const float size = m_layout.tileSize / static_cast<float>(1u << (m_levelCount - 1 - nodeLevel));
+        const glm::vec2 corner = tileOrigin + glm::vec2(nodeX, nodeZ) * size;
+        const glm::vec2 range = tile.heightRanges[nodeIndex(m_levelCount, nodeLevel, nodeX, nodeZ)];
+        return std::make_pair(glm::vec3(corner.x, range.x, corner.y),
+                              glm::vec3(corner.x + size, range.y, corner.y + size));
+    };
+
+    const auto [lo, hi] = bounds(level, x, z);
+    if (!frustum.intersectsBox(lo, hi))
+    {
+        return;
+    }
+
+    const glm::uvec2 firstSample = glm::uvec2(x, z) * (m_settings.gridSize << level);
+    const TerrainChunk chunk{tileOrigin, firstSample, level, tile.slot, kWholeNode, m_morphRange[level]};
+    if (level == 0 || !withinReach(eye, m_reach[level - 1], lo, hi))
+    {
+        chunks.push_back(chunk);
+        return;
+    }
+
+    // Quarters out of the finer level's reach keep this level's density
+    for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        const uint32_t childX = 2 * x + (quadrant & 1);
+        const uint32_t childZ = 2 * z + (quadrant >> 1);
+        const auto [childLo, childHi] = bounds(level - 1, childX, childZ);
+        if (withinReach(eye, m_reach[level - 1], childLo, childHi))
+        {
+            selectNode(tile, tileOrigin, level - 1, childX, childZ, frustum, eye, chunks);
+        }
+        else if (frustum.intersectsBox(childLo, childHi))
+        {
+            TerrainChunk& quarter = chunks.emplace_back(chunk);
+            quarter.quadrant = quadrant;
+        }
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reactor
+{
+
+// One square tile of a terrain heightmap. Tile (x, z) covers world XZ from (x, z) * tileSize to
+// (x + 1, z + 1) * tileSize, and neighbouring tiles repeat their shared row or column of samples,
+// so seams meet exactly. Every tile of a terrain carries the same header values.
+struct HeightTile
+{
+    uint32_t resolution = 0; // samples per side, gridSize * 2^n + 1 for the renderer's grid
+    float tileSize = 0.0f;   // world units per side
+    float minHeight = 0.0f;  // height of sample value 0
+    float maxHeight = 0.0f;  // height of sample value 65535
+    std::vector<uint16_t> samples; // rows along +Z, resolution * resolution
+};
+
+// Height tile layout: char magic[8] = "R_HTILE", uint32 version, uint32 resolution, float tileSize,
+// float minHeight, float maxHeight, then the samples.
+bool writeHeightTile(const std::string& path, const HeightTile& tile);
+
+// Decodes an in-memory height tile. Returns false when the data is malformed.
+bool parseHeightTile(const char* data, size_t size, const std::string& name, HeightTile& tile);
+
+// Splits a square 16-bit little-endian raw heightmap, the .r16 export of most terrain tools, into
+// tile_<x>_<z>.height files in outDirectory, centred on the origin. sampleSpacing is in world
+// units; the raw range 0-65535 maps to minHeight-maxHeight. The side length is taken from the file
+// size, and the last tiles repeat the heightmap's edge where it does not fill them.
+bool cookHeightmap(const std::string& rawPath,
+                   const std::string& outDirectory,
+                   uint32_t tileResolution,
+                   float sampleSpacing,
+                   float minHeight,
+                   float maxHeight);
+
+struct TerrainSettings
+{
+    uint32_t gridSize = 32;          // quads per chunk side, the same at every level
+    float detailDistance = 64.0f;    // reach of the finest level; each coarser level reaches twice as far
+    float morphStart = 0.7f;         // fraction of a level's reach after which it blends into the next
+    float loadRadius = 1024.0f;
+    float unloadRadius = 1280.0f;    // beyond loadRadius, so tiles on the boundary do not thrash
+    uint32_t maxResidentTiles = 64;  // layers of the renderer's height texture
+    uint32_t maxConcurrentLoads = 4;
+};
+
+struct TerrainStats
+{
+    size_t tileCount = 0;
+    size_t residentTiles = 0;
+    size_t loadingTiles = 0;
+    size_t chunkCount = 0; // selected by the last select()
+};
+
+// A node of a resident tile's quadtree picked for drawing, whole or one quarter of it.
+struct TerrainChunk
+{
+    glm::vec2 tileOrigin;   // world XZ of the tile's minimum corner
+    glm::uvec2 firstSample; // node's minimum corner in tile samples
+    uint32_t level;         // 0 is the finest; quads span 2^level samples
+    uint32_t slot;          // texture layer holding the tile's heights
+    uint32_t quadrant;      // Terrain::kWholeNode, or x + 2z of the quarter drawn
+    glm::vec2 morphRange;   // distances from the eye over which vertices blend into the next level
+};
+
+// A tile that finished loading and now owns a texture layer.
+struct TerrainUpload
+{
+    uint32_t slot;
+    HeightTile tile;
+};
+
+// Streams a heightmap terrain split into tiles named tile_<x>_<z>.height, and picks its chunks
+// with continuous distance-based LOD (CDLOD). Each tile is the root of a quadtree whose leaves span
+// gridSize samples; every selected node is drawn with the same grid of gridSize quads, so a node
+// one level up covers twice the ground at half the density. A node is split while its children
+// fall within the finer level's reach of the eye, and the vertices of each level blend into the
+// next coarser grid over the outer part of its reach. Detail therefore follows the camera and the
+// triangle count depends on the reaches, not on the size of the map.
+//
+// Tiles are read asynchronously, nearest first, once the focus comes within loadRadius of them,
+// and are dropped again beyond unloadRadius. Only resident tiles are selected. Render thread only.
+class Terrain
+{
+public:
+    static constexpr uint32_t kWholeNode = 4;
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    explicit Terrain(std::string directory, const TerrainSettings& settings = {});
+    ~Terrain() = default;
+
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // False when the directory held no usable tiles.
+    [[nodiscard]] bool valid() const
+    {
+        return m_levelCount > 0;
+    }
+
+    // Layout shared by every tile, read from the first tile's header
+    [[nodiscard]] const HeightTile& layout() const
+    {
+        return m_layout;
+    }
+    [[nodiscard]] uint32_t levelCount() const
+    {
+        return m_levelCount;
+    }
+    [[nodiscard]] const TerrainSettings& settings() const
+    {
+        return m_settings;
+    }
+
+    // Starts loads and drops tiles around focus. Tiles that finished loading are appended to
+    // uploads and are selectable from this call on, so their heights must reach the GPU before the
+    // next draw. Call once per frame.
+    void update(const glm::vec3& focus, std::vector<TerrainUpload>& uploads);
+
+    // Appends the chunks that draw the resident terrain as seen from eye, culled against frustum.
+    void select(const Frustum& frustum, const glm::vec3& eye, std::vector<TerrainChunk>& chunks);
+
+    // Texture layer of every tile in the smallest rectangle of tiles holding all resident ones, rows
+    // along +Z, with kNoSlot for tiles that are not resident. firstTile is the rectangle's minimum
+    // corner; tileCount is zero when nothing is resident.
+    void residentSlots(glm::ivec2& firstTile, glm::uvec2& tileCount, std::vector<uint32_t>& slots) const;
+
+    [[nodiscard]] const TerrainStats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    using TileCoord = std::pair<int32_t, int32_t>;
+
+    enum class TileState
+    {
+        Unloaded,
+        Loading,
+        Resident,
+        Failed,
+    };
+
+    struct Tile
+    {
+        std::string path;
+        TileState state = TileState::Unloaded;
+        uint32_t slot = 0;
+        std::vector<glm::vec2> heightRanges; // min and max per node, finest level first
+    };
+
+    struct LoadedTile
+    {
+        TileCoord coord;
+        HeightTile tile;
+        std::vector<glm::vec2> heightRanges;
+    };
+
+    // Parsed tiles handed from I/O threads to the render thread. Shared with in-flight reads so
+    // they can complete safely after the terrain is gone.
+    struct Inbox
+    {
+        std::mutex mutex;
+        std::vector<LoadedTile> completed;
+        std::vector<TileCoord> failed;
+    };
+
+    void scanDirectory();
+    void startLoad(const TileCoord& coord, Tile& tile);
+    void selectNode(const Tile& tile,
+                    const glm::vec2& tileOrigin,
+                    uint32_t level,
+                    uint32_t x,
+                    uint32_t z,
+                    const Frustum& frustum,
+                    const glm::vec3& eye,
+                    std::vector<TerrainChunk>& chunks) const;
+    [[nodiscard]] float distanceTo(const TileCoord& coord, const glm::vec3& focus) const;
+    void updateReach(const std::vector<glm::vec2>& heightRanges);
+
+    std::string m_directory;
+    TerrainSettings m_settings;
+    HeightTile m_layout; // header values only
+    uint32_t m_levelCount = 0;
+    std::vector<float> m_reach;          // per level
+    std::vector<glm::vec2> m_morphRange; // per level
+    std::vector<float> m_heightExtent;   // per level, tallest node of any tile loaded so far
+
+    std::map<TileCoord, Tile> m_tiles;
+    std::vector<uint32_t> m_freeSlots;
+    std::shared_ptr<Inbox> m_inbox = std::make_shared<Inbox>();
+    uint32_t m_loadsInFlight = 0;
+    TerrainStats m_stats;
+};
+
+} // namespace reactor
@@ -0,0 +1,124 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace reactor
+{
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    threadCount = std::max<size_t>(threadCount, 1);
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::defaultThreadCount()
+{
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1)
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    // Shared so helpers that start after the last chunk was claimed never touch a dead frame
+    struct Job
+    {
+        std::function<void(size_t, size_t)> body;
+        size_t count;
+        size_t grain;
+        size_t chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        void run()
+        {
+            for (size_t chunk = next.fetch_add(1); chunk < chunks; chunk = next.fetch_add(1))
+            {
+                const size_t begin = chunk * grain;
+                body(begin, std::min(begin + grain, count));
+                if (done.fetch_add(1) + 1 == chunks)
+                {
+                    std::lock_guard lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+    auto job = std::make_shared<Job>();
+    job->body = body;
+    job->count = count;
+    job->grain = grain;
+    job->chunks = chunks;
+
+    const size_t helpers = std::min(chunks - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        enqueue([job] { job->run(); });
+    }
+    job->run();
+
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load() == chunks; });
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reactor
+{
+
+// Fixed set of worker threads draining a FIFO of tasks. Tasks still queued at destruction are run
+// before the workers exit.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threadCount = defaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task);
+
+    // Splits [0, count) into chunks of at most grain items and runs body(begin, end) on each,
+    // using the workers and the calling thread. Returns once every chunk has finished. Runs inline
+    // when there is only one chunk.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    // co_await pool.schedule() continues the coroutine on a worker thread.
+    auto schedule()
+    {
+        struct Awaiter
+        {
+            ThreadPool& pool;
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                pool.enqueue([handle] { handle.resume(); });
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_workers.size();
+    }
+
+    // One worker per hardware thread, leaving one for the render thread.
+    static size_t defaultThreadCount();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+};
+
+} // namespace reactor
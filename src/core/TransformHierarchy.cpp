@@ -0,0 +1,369 @@
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define REACTOR_TRANSFORM_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define REACTOR_TRANSFORM_NEON 1
+#endif
+
+namespace reactor
+{
+
+namespace
+{
+// Below this many dirty nodes a single thread finishes before the pool would have woken up
+constexpr size_t kParallelThreshold = 8192;
+constexpr size_t kParallelGrain = 2048;
+
+// out = a * b for column-major matrices; each output column is a combination of a's columns.
+// out must not alias a or b.
+inline void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    float* po = &out[0][0];
+#if defined(REACTOR_TRANSFORM_SSE)
+    const __m128 a0 = _mm_loadu_ps(pa);
+    const __m128 a1 = _mm_loadu_ps(pa + 4);
+    const __m128 a2 = _mm_loadu_ps(pa + 8);
+    const __m128 a3 = _mm_loadu_ps(pa + 12);
+    for (int c = 0; c < 4; ++c)
+    {
+        const float* col = pb + 4 * c;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(col[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(col[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(col[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(col[3])));
+        _mm_storeu_ps(po + 4 * c, r);
+    }
+#elif defined(REACTOR_TRANSFORM_NEON)
+    const float32x4_t a0 = vld1q_f32(pa);
+    const float32x4_t a1 = vld1q_f32(pa + 4);
+    const float32x4_t a2 = vld1q_f32(pa + 8);
+    const float32x4_t a3 = vld1q_f32(pa + 12);
+    for (int c = 0; c < 4; ++c)
+    {
+        const float* col = pb + 4 * c;
+        float32x4_t r = vmulq_n_f32(a0, col[0]);
+        r = vmlaq_n_f32(r, a1, col[1]);
+        r = vmlaq_n_f32(r, a2, col[2]);
+        r = vmlaq_n_f32(r, a3, col[3]);
+        vst1q_f32(po + 4 * c, r);
+    }
+#else
+    (void)pa;
+    (void)pb;
+    (void)po;
+    out = a * b;
+#endif
+}
+} // namespace
+
+void TransformHierarchy::add(uint32_t slot, const glm::mat4& local)
+{
+    if (slot >= m_nodeOf.size())
+    {
+        m_nodeOf.resize(slot + 1, kNone);
+    }
+    assert(m_nodeOf[slot] == kNone);
+
+    const auto node = static_cast<uint32_t>(m_slots.size());
+    m_slots.push_back(slot);
+    m_parents.push_back(kNone);
+    m_depths.push_back(0);
+    m_ends.push_back(node + 1);
+    m_locals.push_back(local);
+    m_worlds.push_back(local);
+    m_removed.push_back(0);
+    m_nodeOf[slot] = node;
+}
+
+void TransformHierarchy::remove(uint32_t slot)
+{
+    // The node stays, frozen, so its children keep their world transforms until compaction folds
+    // its local transform into theirs
+    const uint32_t node = m_nodeOf[slot];
+    assert(node != kNone);
+    m_removed[node] = 1;
+    m_slots[node] = kNone;
+    m_nodeOf[slot] = kNone;
+    m_removedCount++;
+}
+
+void TransformHierarchy::clear()
+{
+    m_slots.clear();
+    m_parents.clear();
+    m_depths.clear();
+    m_ends.clear();
+    m_locals.clear();
+    m_worlds.clear();
+    m_removed.clear();
+    m_nodeOf.clear();
+    m_dirty.clear();
+    m_removedCount = 0;
+    m_updatedRanges.clear();
+}
+
+bool TransformHierarchy::setParent(uint32_t slot, uint32_t parent)
+{
+    const uint32_t node = m_nodeOf[slot];
+    const uint32_t parentNode = parent == kNone ? kNone : m_nodeOf[parent];
+    assert(node != kNone && (parent == kNone || parentNode != kNone));
+
+    const uint32_t begin = node;
+    const uint32_t end = m_ends[node];
+    if (parentNode != kNone && parentNode >= begin && parentNode < end)
+    {
+        return false;
+    }
+
+    if (parentNode == kNone)
+    {
+        m_locals[node] = m_worlds[node];
+    }
+    else
+    {
+        m_locals[node] = glm::inverse(m_worlds[parentNode]) * m_worlds[node];
+    }
+    m_parents[node] = parentNode;
+
+    // Move the subtree to the end of the new parent's range, or to the end of the array for roots
+    const auto count = static_cast<uint32_t>(m_slots.size());
+    const uint32_t target = parentNode == kNone ? count : m_ends[parentNode];
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    auto append = [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; ++i)
+        {
+            order.push_back(i);
+        }
+    };
+    if (target >= end)
+    {
+        append(0, begin);
+        append(end, target);
+        append(begin, end);
+        append(target, count);
+    }
+    else
+    {
+        append(0, target);
+        append(begin, end);
+        append(target, begin);
+        append(end, count);
+    }
+    reorder(order);
+    rebuildLinks();
+    return true;
+}
+
+uint32_t TransformHierarchy::parent(uint32_t slot) const
+{
+    uint32_t node = m_parents[m_nodeOf[slot]];
+    while (node != kNone && m_removed[node])
+    {
+        node = m_parents[node];
+    }
+    return node == kNone ? kNone : m_slots[node];
+}
+
+void TransformHierarchy::setLocal(uint32_t slot, const glm::mat4& local)
+{
+    m_locals[m_nodeOf[slot]] = local;
+    m_dirty.push_back(slot);
+}
+
+const glm::mat4& TransformHierarchy::local(uint32_t slot) const
+{
+    return m_locals[m_nodeOf[slot]];
+}
+
+const glm::mat4& TransformHierarchy::world(uint32_t slot) const
+{
+    return m_worlds[m_nodeOf[slot]];
+}
+
+void TransformHierarchy::update(ThreadPool* pool)
+{
+    m_updatedRanges.clear();
+    if (m_removedCount > 0)
+    {
+        compact();
+    }
+    if (m_dirty.empty())
+    {
+        return;
+    }
+
+    // Dirty slots become subtree ranges; a range inside an earlier one is already covered
+    std::vector<uint32_t> roots;
+    roots.reserve(m_dirty.size());
+    for (uint32_t slot : m_dirty)
+    {
+        if (slot < m_nodeOf.size() && m_nodeOf[slot] != kNone)
+        {
+            roots.push_back(m_nodeOf[slot]);
+        }
+    }
+    m_dirty.clear();
+    std::sort(roots.begin(), roots.end());
+
+    size_t total = 0;
+    uint32_t coveredEnd = 0;
+    for (uint32_t root : roots)
+    {
+        if (root < coveredEnd)
+        {
+            continue;
+        }
+        coveredEnd = m_ends[root];
+        m_updatedRanges.emplace_back(root, coveredEnd);
+        total += coveredEnd - root;
+    }
+
+    auto updateNode = [this](uint32_t node) {
+        const uint32_t parentNode = m_parents[node];
+        if (parentNode == kNone)
+        {
+            m_worlds[node] = m_locals[node];
+        }
+        else
+        {
+            multiply(m_worlds[parentNode], m_locals[node], m_worlds[node]);
+        }
+    };
+
+    if (!pool || total < kParallelThreshold)
+    {
+        // Depth-first order already puts every parent before its children
+        for (const auto& [begin, end] : m_updatedRanges)
+        {
+            for (uint32_t node = begin; node < end; ++node)
+            {
+                updateNode(node);
+            }
+        }
+        return;
+    }
+
+    // Nodes on one level only read the level above, so each level is a parallel batch
+    for (auto& level : m_levels)
+    {
+        level.clear();
+    }
+    for (const auto& [begin, end] : m_updatedRanges)
+    {
+        for (uint32_t node = begin; node < end; ++node)
+        {
+            const uint32_t depth = m_depths[node];
+            if (depth >= m_levels.size())
+            {
+                m_levels.resize(depth + 1);
+            }
+            m_levels[depth].push_back(node);
+        }
+    }
+    for (const auto& level : m_levels)
+    {
+        pool->parallelFor(level.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                updateNode(level[i]);
+            }
+        });
+    }
+}
+
+void TransformHierarchy::compact()
+{
+    // Fold removed nodes' local transforms into their children and point those at the nearest
+    // surviving ancestor. Parents precede children, so chains of removed nodes resolve in one pass.
+    const auto count = static_cast<uint32_t>(m_slots.size());
+    std::vector<uint32_t> order;
+    order.reserve(count - m_removedCount);
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        const uint32_t parentNode = m_parents[node];
+        if (parentNode != kNone && m_removed[parentNode])
+        {
+            m_locals[node] = m_locals[parentNode] * m_locals[node];
+            m_parents[node] = m_parents[parentNode];
+        }
+        if (!m_removed[node])
+        {
+            order.push_back(node);
+        }
+    }
+
+    reorder(order);
+    rebuildLinks();
+    m_removedCount = 0;
+}
+
+void TransformHierarchy::reorder(const std::vector<uint32_t>& order)
+{
+    std::vector<uint32_t> newIndex(m_slots.size(), kNone);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        newIndex[order[i]] = static_cast<uint32_t>(i);
+    }
+
+    auto gather = [&](auto& values) {
+        std::remove_reference_t<decltype(values)> sorted;
+        sorted.reserve(order.size());
+        for (uint32_t node : order)
+        {
+            sorted.push_back(values[node]);
+        }
+        values = std::move(sorted);
+    };
+    gather(m_slots);
+    gather(m_parents);
+    gather(m_locals);
+    gather(m_worlds);
+    gather(m_removed);
+
+    for (uint32_t& parentNode : m_parents)
+    {
+        if (parentNode != kNone)
+        {
+            parentNode = newIndex[parentNode];
+        }
+    }
+}
+
+void TransformHierarchy::rebuildLinks()
+{
+    const auto count = static_cast<uint32_t>(m_slots.size());
+    m_depths.resize(count);
+    m_ends.resize(count);
+
+    std::fill(m_nodeOf.begin(), m_nodeOf.end(), kNone);
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        const uint32_t parentNode = m_parents[node];
+        m_depths[node] = parentNode == kNone ? 0 : m_depths[parentNode] + 1;
+        m_ends[node] = node + 1;
+        if (m_slots[node] != kNone)
+        {
+            m_nodeOf[m_slots[node]] = node;
+        }
+    }
+    for (uint32_t node = count; node-- > 0;)
+    {
+        const uint32_t parentNode = m_parents[node];
+        if (parentNode != kNone)
+        {
+            m_ends[parentNode] = std::max(m_ends[parentNode], m_ends[node]);
+        }
+    }
+}
+
+} // namespace reactor
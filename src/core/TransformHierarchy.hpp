@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace reactor
+{
+
+// Parent/child transforms keyed by entity slot. Nodes are kept in depth-first order, so every
+// parent precedes its children and each subtree is one contiguous range. Moving a node marks its
+// subtree dirty; update() recomputes only those ranges, one depth level at a time, and levels
+// large enough are split across a thread pool. Structural edits (reparenting, compaction after
+// removals) reorder the arrays and cost O(n); changing transforms costs O(dirty subtree).
+class TransformHierarchy
+{
+public:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    // Adds a root node for slot. Its world transform is local until it gets a parent.
+    void add(uint32_t slot, const glm::mat4& local);
+
+    // Children of a removed node are kept where they are in the world and attach to its parent.
+    void remove(uint32_t slot);
+    void clear();
+
+    // Attaches slot below parent (kNone detaches), keeping its world transform as of the last
+    // update. Returns false when parent is slot itself or one of its descendants.
+    bool setParent(uint32_t slot, uint32_t parent);
+    [[nodiscard]] uint32_t parent(uint32_t slot) const;
+
+    void setLocal(uint32_t slot, const glm::mat4& local);
+    [[nodiscard]] const glm::mat4& local(uint32_t slot) const;
+    [[nodiscard]] const glm::mat4& world(uint32_t slot) const;
+
+    // Recomputes world transforms of dirty subtrees. pool may be null to stay on this thread.
+    void update(ThreadPool* pool);
+
+    // Node ranges recomputed by the last update(); slotAt() maps a node back to its slot.
+    [[nodiscard]] const std::vector<std::pair<uint32_t, uint32_t>>& updatedRanges() const
+    {
+        return m_updatedRanges;
+    }
+    [[nodiscard]] uint32_t slotAt(uint32_t node) const
+    {
+        return m_slots[node];
+    }
+    [[nodiscard]] const glm::mat4& worldAt(uint32_t node) const
+    {
+        return m_worlds[node];
+    }
+
+private:
+    void compact();
+    void reorder(const std::vector<uint32_t>& order);
+    void rebuildLinks();
+
+    // Per node, in depth-first order
+    std::vector<uint32_t> m_slots;
+    std::vector<uint32_t> m_parents; // node index or kNone
+    std::vector<uint32_t> m_depths;
+    std::vector<uint32_t> m_ends; // one past the last node of the subtree
+    std::vector<glm::mat4> m_locals;
+    std::vector<glm::mat4> m_worlds;
+    std::vector<uint8_t> m_removed;
+
+    std::vector<uint32_t> m_nodeOf; // indexed by slot
+    std::vector<uint32_t> m_dirty;  // slots, resolved to nodes at update time
+    size_t m_removedCount = 0;
+
+    std::vector<std::pair<uint32_t, uint32_t>> m_updatedRanges;
+    std::vector<std::vector<uint32_t>> m_levels; // scratch, reused between updates
+};
+
+} // namespace reactor
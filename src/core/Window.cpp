@@ -46,6 +46,15 @@ m_width(width), m_height(height), m_title(title), m_eventManager(eventManager) {
         };
     }
 
+    vk::Extent2D Window::getWindowSize() const {
+        int width, height;
+        glfwGetWindowSize(m_window, &width, &height);
+        return vk::Extent2D{
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height)
+        };
+    }
+
     // This function handles the creation of the Vulkan surface.
     // It's part of the Window class because the surface is intrinsically linked to the window.
     vk::SurfaceKHR Window::createVulkanSurface(vk::Instance instance) {
@@ -90,6 +99,7 @@ m_width(width), m_height(height), m_title(title), m_eventManager(eventManager) {
         if (!windowInstance) return;
 
         Event event{};
+        glfwGetCursorPos(window, &event.mouseButton.x, &event.mouseButton.y);
         if (action == GLFW_PRESS) {
             event.type = EventType::MouseButtonPressed;
             event.mouseButton.button = button;
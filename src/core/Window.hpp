@@ -40,6 +40,9 @@ namespace reactor {
         // This can be different from the window size on high-DPI displays.
         vk::Extent2D getFramebufferSize() const;
 
+        // Gets the size in screen coordinates, the space cursor positions are reported in.
+        vk::Extent2D getWindowSize() const;
+
         // Creates a Vulkan surface (the connection between Vulkan and the window system).
         vk::SurfaceKHR createVulkanSurface(vk::Instance instance);
 
@@ -0,0 +1,511 @@
+#include "WorldPartition.hpp"
+
+#include "AsyncIO.hpp"
+#include "ModelIO.hpp"
+#include "SceneIO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kCellVersion = 1;
+constexpr uint32_t kMaxPathLength = 4096;
+constexpr float kHlodGridDivisions = 32.0f; // proxy clustering grid cells across the merged radius
+
+// Bounds-checked cursor over a loaded bundle.
+struct BundleReader
+{
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+
+    bool read(void* out, size_t bytes)
+    {
+        if (bytes > size - offset)
+            return false;
+        memcpy(out, data + offset, bytes);
+        offset += bytes;
+        return true;
+    }
+};
+} // namespace
+
+bool writeCellBundle(const std::string& path, const std::vector<CellObject>& objects)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open())
+    {
+        spdlog::error("Failed to open cell bundle for writing: {}", path);
+        return false;
+    }
+
+    const char magic[8] = "R_CELL";
+    const auto objectCount = static_cast<uint32_t>(objects.size());
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char*>(&kCellVersion), sizeof(kCellVersion));
+    out.write(reinterpret_cast<const char*>(&objectCount), sizeof(objectCount));
+
+    for (const CellObject& object : objects)
+    {
+        const auto pathLength = static_cast<uint32_t>(object.meshPath.size());
+        out.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+        out.write(object.meshPath.data(), pathLength);
+        out.write(reinterpret_cast<const char*>(&object.meshIndex), sizeof(object.meshIndex));
+        out.write(reinterpret_cast<const char*>(&object.transform[0][0]), sizeof(glm::mat4));
+    }
+    return out.good();
+}
+
+bool parseCellBundle(const char* data, size_t size, const std::string& name, std::vector<CellObject>& objects)
+{
+    BundleReader reader{data, size};
+
+    char magic[8];
+    uint32_t version;
+    uint32_t objectCount;
+    if (!reader.read(magic, sizeof(magic)) || !reader.read(&version, sizeof(version))
+        || !reader.read(&objectCount, sizeof(objectCount)))
+    {
+        spdlog::error("Truncated cell bundle: {}", name);
+        return false;
+    }
+
+    magic[sizeof(magic) - 1] = '\0';
+    if (std::string(magic) != "R_CELL" || version != kCellVersion)
+    {
+        spdlog::error("Invalid cell bundle or version mismatch: {}", name);
+        return false;
+    }
+
+    objects.clear();
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        CellObject& object = objects.emplace_back();
+        uint32_t pathLength;
+        if (!reader.read(&pathLength, sizeof(pathLength)) || pathLength > kMaxPathLength)
+        {
+            spdlog::error("Truncated cell bundle: {}", name);
+            return false;
+        }
+        object.meshPath.resize(pathLength);
+        if (!reader.read(object.meshPath.data(), pathLength) || !reader.read(&object.meshIndex, sizeof(object.meshIndex))
+            || !reader.read(&object.transform[0][0], sizeof(glm::mat4)))
+        {
+            spdlog::error("Truncated cell bundle: {}", name);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cookWorldCells(const std::string& scenePath, const std::string& directory, float cellSize)
+{
+    if (!(cellSize > 0.0f))
+    {
+        spdlog::error("Invalid cell size {}", cellSize);
+        return false;
+    }
+    const std::unique_ptr<SceneFile> scene = SceneFile::open(scenePath);
+    if (!scene)
+    {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        spdlog::error("Failed to create world directory {}: {}", directory, error.message());
+        return false;
+    }
+
+    // Scene mesh paths are relative to the working directory, bundle paths to the bundle
+    std::vector<std::string> meshPaths;
+    meshPaths.reserve(scene->meshRefs().size());
+    for (const SceneMeshRef& ref : scene->meshRefs())
+    {
+        const std::filesystem::path meshPath(SceneFile::meshPath(ref));
+        meshPaths.push_back(std::filesystem::proximate(meshPath, directory, error).generic_string());
+        if (error)
+        {
+            meshPaths.back() = meshPath.generic_string();
+        }
+    }
+
+    std::map<std::pair<int32_t, int32_t>, std::vector<CellObject>> cells;
+    for (const SceneObject& object : scene->objects())
+    {
+        const glm::vec3 origin(object.transform[3]);
+        const auto x = static_cast<int32_t>(std::floor(origin.x / cellSize));
+        const auto z = static_cast<int32_t>(std::floor(origin.z / cellSize));
+        const SceneMeshRef& ref = scene->meshRefs()[object.meshRef];
+        cells[{x, z}].push_back({meshPaths[object.meshRef], ref.meshIndex, object.transform});
+    }
+
+    int failed = 0;
+    for (const auto& [coord, objects] : cells)
+    {
+        const std::string name = "cell_" + std::to_string(coord.first) + "_" + std::to_string(coord.second) + ".cell";
+        if (!writeCellBundle((std::filesystem::path(directory) / name).string(), objects))
+        {
+            ++failed;
+        }
+    }
+
+    spdlog::info("{}: {} objects split into {} cells of {} units in {}",
+                 scenePath,
+                 scene->objects().size(),
+                 cells.size(),
+                 cellSize,
+                 directory);
+    return failed == 0;
+}
+
+bool cookCellHlod(const std::string& bundlePath)
+{
+    std::ifstream in(bundlePath, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+    {
+        spdlog::error("Failed to open cell bundle: {}", bundlePath);
+        return false;
+    }
+    std::vector<char> data(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+    std::vector<CellObject> objects;
+    if (!in.good() || !parseCellBundle(data.data(), data.size(), bundlePath, objects))
+    {
+        return false;
+    }
+
+    // Objects are baked into world space, so the proxy entity needs no transform
+    const std::filesystem::path directory = std::filesystem::path(bundlePath).parent_path();
+    std::unordered_map<std::string, std::vector<MeshData>> models;
+    MeshData merged;
+    for (const CellObject& object : objects)
+    {
+        const std::string meshPath = (directory / object.meshPath).string();
+        auto [it, inserted] = models.try_emplace(meshPath);
+        if (inserted)
+        {
+            it->second = loadModelFromBinary(meshPath);
+        }
+        if (object.meshIndex >= it->second.size())
+        {
+            spdlog::warn("{}: {} has no mesh {}, left out of the proxy", bundlePath, meshPath, object.meshIndex);
+            continue;
+        }
+
+        const MeshData& mesh = it->second[object.meshIndex];
+        const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(object.transform)));
+        const auto base = static_cast<uint32_t>(merged.vertices.size());
+        for (Vertex vertex : mesh.vertices)
+        {
+            vertex.pos = glm::vec3(object.transform * glm::vec4(vertex.pos, 1.0f));
+            const glm::vec3 normal = normalMatrix * vertex.normal;
+            const float length = glm::length(normal);
+            vertex.normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            merged.vertices.push_back(vertex);
+        }
+        for (uint32_t index : mesh.indices)
+        {
+            merged.indices.push_back(base + index);
+        }
+    }
+    if (merged.indices.empty())
+    {
+        spdlog::warn("{} has no geometry for a proxy", bundlePath);
+        return false;
+    }
+
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : merged.vertices)
+    {
+        lo = glm::min(lo, vertex.pos);
+        hi = glm::max(hi, vertex.pos);
+    }
+    const float gridSize = std::max(glm::length(hi - lo) * 0.5f / kHlodGridDivisions, 1e-4f);
+
+    std::vector<MeshData> proxy;
+    proxy.push_back(clusterSimplify(merged, lo, gridSize));
+    spdlog::info("{}: {} objects, {} triangles merged into {}",
+                 bundlePath,
+                 objects.size(),
+                 merged.indices.size() / 3,
+                 proxy.front().indices.size() / 3);
+
+    const std::string outputPath = std::filesystem::path(bundlePath).replace_extension(".hlod").string();
+    return writeModelBinary(outputPath, std::move(proxy), gridSize * std::sqrt(3.0f));
+}
+
+WorldPartition::WorldPartition(AssetManager& assets,
+                               SceneStore& scene,
+                               std::string directory,
+                               const WorldPartitionSettings& settings)
+    : m_assets(assets), m_scene(scene), m_directory(std::move(directory)), m_settings(settings)
+{
+    scanDirectory();
+}
+
+WorldPartition::~WorldPartition()
+{
+    for (auto& [coord, cell] : m_cells)
+    {
+        unload(cell);
+        releaseProxy(cell);
+    }
+}
+
+void WorldPartition::unload(Cell& cell)
+{
+    for (EntityId entity : cell.entities)
+    {
+        m_scene.destroy(entity);
+    }
+    cell.entities.clear();
+    cell.state = CellState::Unloaded;
+}
+
+void WorldPartition::scanDirectory()
+{
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, error))
+    {
+        const bool bundle = entry.path().extension() == ".cell";
+        if (!entry.is_regular_file() || (!bundle && entry.path().extension() != ".hlod"))
+        {
+            continue;
+        }
+
+        int32_t x;
+        int32_t z;
+        char tail;
+        if (std::sscanf(entry.path().stem().string().c_str(), "cell_%d_%d%c", &x, &z, &tail) != 2)
+        {
+            continue;
+        }
+        (bundle ? m_cells[{x, z}].path : m_cells[{x, z}].hlodPath) = entry.path().string();
+    }
+
+    m_stats.cellCount = m_cells.size();
+    if (error)
+    {
+        spdlog::warn("World directory {} not readable: {}", m_directory, error.message());
+    }
+    else
+    {
+        spdlog::info("World partition: {} cells in {}", m_cells.size(), m_directory);
+    }
+}
+
+float WorldPartition::distanceTo(const CellCoord& coord, const glm::vec3& focus) const
+{
+    const glm::vec2 center = (glm::vec2(coord.first, coord.second) + 0.5f) * m_settings.cellSize;
+    return glm::length(center - glm::vec2(focus.x, focus.z));
+}
+
+void WorldPartition::update(const glm::vec3& focus, const glm::vec3& eye, float pixelsPerUnitAtOne)
+{
+    // Hand over bundles whose reads completed since the last frame
+    std::vector<std::pair<CellCoord, std::vector<CellObject>>> completed;
+    std::vector<CellCoord> failed;
+    {
+        std::lock_guard lock(m_inbox->mutex);
+        completed.swap(m_inbox->completed);
+        failed.swap(m_inbox->failed);
+    }
+    for (auto& [coord, objects] : completed)
+    {
+        m_loadsInFlight--;
+        if (distanceTo(coord, focus) <= m_settings.unloadRadius)
+        {
+            finishLoad(coord, std::move(objects));
+        }
+        else
+        {
+            m_cells[coord].state = CellState::Unloaded;
+        }
+    }
+    // Failed cells stay in the loading state so a broken bundle is not retried every frame
+    m_loadsInFlight -= static_cast<uint32_t>(failed.size());
+
+    // Unload beyond the outer radius; queue loads inside the inner one
+    std::vector<std::pair<float, CellCoord>> wanted;
+    for (auto& [coord, cell] : m_cells)
+    {
+        const float distance = distanceTo(coord, focus);
+        if (cell.state == CellState::Loaded && distance > m_settings.unloadRadius)
+        {
+            // Meshes stay in the asset cache until it needs the memory
+            unload(cell);
+        }
+        else if (cell.state == CellState::Unloaded && !cell.path.empty() && distance <= m_settings.loadRadius)
+        {
+            wanted.emplace_back(distance, coord);
+        }
+    }
+
+    std::sort(wanted.begin(), wanted.end());
+    for (const auto& [distance, coord] : wanted)
+    {
+        if (m_loadsInFlight >= m_settings.maxConcurrentLoads)
+        {
+            break;
+        }
+        startLoad(coord, m_cells[coord]);
+    }
+
+    updateProxies(focus, eye, pixelsPerUnitAtOne);
+
+    m_stats.loadedCells = 0;
+    m_stats.loadingCells = m_loadsInFlight;
+    m_stats.objectCount = 0;
+    m_stats.proxyCells = 0;
+    for (const auto& [coord, cell] : m_cells)
+    {
+        m_stats.loadedCells += cell.state == CellState::Loaded ? 1 : 0;
+        m_stats.objectCount += cell.entities.size();
+        m_stats.proxyCells += cell.showingProxy ? 1 : 0;
+    }
+}
+
+void WorldPartition::updateProxies(const glm::vec3& focus, const glm::vec3& eye, float pixelsPerUnitAtOne)
+{
+    // Proxies drop out as far beyond hlodRadius as cells do beyond loadRadius
+    const float releaseRadius = m_settings.hlodRadius + (m_settings.unloadRadius - m_settings.loadRadius);
+
+    for (auto& [coord, cell] : m_cells)
+    {
+        if (cell.hlodPath.empty())
+        {
+            continue;
+        }
+
+        const float distance = distanceTo(coord, focus);
+        if (!cell.proxy.valid() && distance <= m_settings.hlodRadius)
+        {
+            // Created hidden; shown once its geometry is resident
+            const glm::vec3 center((static_cast<float>(coord.first) + 0.5f) * m_settings.cellSize,
+                                   0.0f,
+                                   (static_cast<float>(coord.second) + 0.5f) * m_settings.cellSize);
+            cell.hlod = m_assets.acquireLodMesh(cell.hlodPath, 0, center);
+            cell.proxy = m_scene.create(m_scene.addMesh(cell.hlod), glm::mat4(1.0f), EntityStreamed);
+        }
+        else if (cell.proxy.valid() && distance > releaseRadius)
+        {
+            releaseProxy(cell);
+            continue;
+        }
+        if (!cell.proxy.valid())
+        {
+            continue;
+        }
+
+        // Keeps the coarsest level resident and the mesh out of the cache's eviction while in range
+        const uint32_t levelCount = cell.hlod->levelCount();
+        const bool ready = levelCount > 0 && cell.hlod->want(levelCount - 1) != nullptr;
+
+        bool useProxy = ready && cell.state != CellState::Loaded;
+        if (ready && !useProxy)
+        {
+            // Finest proxy level against the objects, projected from the nearest point of its bounds
+            const float gap = glm::length(cell.hlod->boundsCenter() - eye) - cell.hlod->boundsRadius();
+            const float pixels = cell.hlod->levelError(0) * pixelsPerUnitAtOne / std::max(gap, 0.1f);
+            useProxy = pixels <= m_settings.hlodPixelError;
+        }
+        showProxy(cell, useProxy);
+    }
+}
+
+void WorldPartition::showProxy(Cell& cell, bool show)
+{
+    if (cell.showingProxy == show)
+    {
+        return;
+    }
+    m_scene.setVisible(cell.proxy, show);
+    for (EntityId entity : cell.entities)
+    {
+        m_scene.setVisible(entity, !show);
+    }
+    cell.showingProxy = show;
+}
+
+void WorldPartition::releaseProxy(Cell& cell)
+{
+    if (!cell.proxy.valid())
+    {
+        return;
+    }
+    showProxy(cell, false);
+    m_scene.destroy(cell.proxy);
+    cell.proxy = {};
+    cell.hlod.reset();
+}
+
+void WorldPartition::startLoad(const CellCoord& coord, Cell& cell)
+{
+    cell.state = CellState::Loading;
+    m_loadsInFlight++;
+
+    ReadRequest request;
+    request.path = cell.path;
+    request.onComplete = [inbox = m_inbox, coord](ReadResult&& file) {
+        std::vector<CellObject> objects;
+        const bool ok = file.ok && parseCellBundle(file.data.data(), file.data.size(), file.path, objects);
+        if (!ok)
+        {
+            spdlog::error("Failed to load cell bundle {}", file.path);
+        }
+
+        std::lock_guard lock(inbox->mutex);
+        if (ok)
+        {
+            inbox->completed.emplace_back(coord, std::move(objects));
+        }
+        else
+        {
+            inbox->failed.push_back(coord);
+        }
+    };
+
+    std::vector<ReadRequest> batch;
+    batch.push_back(std::move(request));
+    AsyncIO::shared().submit(std::move(batch));
+}
+
+void WorldPartition::finishLoad(const CellCoord& coord, std::vector<CellObject>&& objects)
+{
+    Cell& cell = m_cells[coord];
+    const std::filesystem::path directory = std::filesystem::path(cell.path).parent_path();
+
+    cell.entities.reserve(objects.size());
+    for (const CellObject& object : objects)
+    {
+        const glm::vec3 position(object.transform[3]);
+        const std::string meshPath = (directory / object.meshPath).string();
+        const MeshId mesh = m_scene.addMesh(m_assets.acquireLodMesh(meshPath, object.meshIndex, position));
+        // Objects of a cell currently drawn as its proxy arrive hidden
+        const uint32_t flags = cell.showingProxy ? 0u : EntityVisible;
+        cell.entities.push_back(m_scene.create(mesh, object.transform, flags | EntityStreamed));
+    }
+    cell.state = CellState::Loaded;
+
+    spdlog::info("Loaded cell ({}, {}): {} objects", coord.first, coord.second, cell.entities.size());
+}
+
+} // namespace reactor
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "AssetManager.hpp"
+#include "SceneStore.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reactor
+{
+
+// One object of a cooked cell bundle. meshPath is relative to the bundle's directory.
+struct CellObject
+{
+    std::string meshPath;
+    uint32_t meshIndex = 0;
+    glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// Cell bundle layout: char magic[8] = "R_CELL", uint32 version, uint32 objectCount, then per
+// object uint32 pathLength, the path bytes, uint32 meshIndex and a column-major float4x4.
+bool writeCellBundle(const std::string& path, const std::vector<CellObject>& objects);
+
+// Decodes an in-memory cell bundle. Returns false when the data is malformed.
+bool parseCellBundle(const char* data, size_t size, const std::string& name, std::vector<CellObject>& objects);
+
+// Splits the objects of the .rscene file at scenePath into cells of cellSize units by the XZ
+// position of their origin and writes each cell's bundle to directory as cell_<x>_<z>.cell, with
+// mesh paths made relative to directory.
+bool cookWorldCells(const std::string& scenePath, const std::string& directory, float cellSize);
+
+// Cooks a cell's HLOD proxy: every object of the bundle at bundlePath is merged in world space and
+// simplified into one mesh, vertex colours averaged into the merged vertices. Written beside the
+// bundle as cell_<x>_<z>.hlod, a .mesh file whose level errors include the merge's simplification.
+bool cookCellHlod(const std::string& bundlePath);
+
+struct WorldPartitionSettings
+{
+    float cellSize = 64.0f;
+    float loadRadius = 160.0f;
+    float unloadRadius = 200.0f; // beyond loadRadius, so cells on the boundary do not thrash
+    uint32_t maxConcurrentLoads = 2;
+    float hlodRadius = 600.0f;   // cells with a proxy keep it resident this far out
+    float hlodPixelError = 2.0f; // a loaded cell switches to its proxy once the proxy's error projects below this
+};
+
+struct WorldPartitionStats
+{
+    size_t cellCount = 0;
+    size_t loadedCells = 0;
+    size_t loadingCells = 0;
+    size_t objectCount = 0;
+    size_t proxyCells = 0; // drawn as their HLOD proxy
+};
+
+// Streams a world split into square cells on the XZ plane. Each cell is a cooked bundle named
+// cell_<x>_<z>.cell in the world directory, where x and z are cell coordinates. Bundles are read
+// asynchronously, nearest first and at most maxConcurrentLoads at a time, once the focus point
+// comes within loadRadius of the cell centre, and are dropped again beyond unloadRadius. Loaded
+// objects become SceneStore entities. Meshes go through the AssetManager, so cells share them and
+// dropped ones age out of the cache.
+//
+// Cells with a cooked cell_<x>_<z>.hlod proxy keep it as one extra entity out to hlodRadius. The
+// proxy is drawn instead of the cell's objects while they are not loaded, and once the proxy's
+// simplification error projects to less than hlodPixelError pixels, so a distant cell costs one
+// draw however many objects it holds.
+// Render thread only.
+class WorldPartition
+{
+public:
+    WorldPartition(AssetManager& assets,
+                   SceneStore& scene,
+                   std::string directory,
+                   const WorldPartitionSettings& settings = {});
+    ~WorldPartition();
+
+    WorldPartition(const WorldPartition&) = delete;
+    WorldPartition& operator=(const WorldPartition&) = delete;
+
+    // Starts and finishes loads and unloads cells around focus, then picks between each cell's
+    // objects and its proxy as seen from eye. pixelsPerUnitAtOne is how many pixels one world unit
+    // covers at distance 1. Call once per frame.
+    void update(const glm::vec3& focus, const glm::vec3& eye, float pixelsPerUnitAtOne);
+
+    [[nodiscard]] const WorldPartitionStats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    using CellCoord = std::pair<int32_t, int32_t>;
+
+    enum class CellState
+    {
+        Unloaded,
+        Loading,
+        Loaded,
+    };
+
+    struct Cell
+    {
+        std::string path; // empty when the cell only has a proxy
+        CellState state = CellState::Unloaded;
+        std::vector<EntityId> entities;
+
+        std::string hlodPath;
+        std::shared_ptr<LodMesh> hlod;
+        EntityId proxy;
+        bool showingProxy = false;
+    };
+
+    // Parsed bundles handed from I/O threads to the render thread. Shared with in-flight reads so
+    // they can complete safely after the partition is gone.
+    struct Inbox
+    {
+        std::mutex mutex;
+        std::vector<std::pair<CellCoord, std::vector<CellObject>>> completed;
+        std::vector<CellCoord> failed;
+    };
+
+    void scanDirectory();
+    void startLoad(const CellCoord& coord, Cell& cell);
+    void finishLoad(const CellCoord& coord, std::vector<CellObject>&& objects);
+    void unload(Cell& cell);
+    void updateProxies(const glm::vec3& focus, const glm::vec3& eye, float pixelsPerUnitAtOne);
+    void showProxy(Cell& cell, bool show);
+    void releaseProxy(Cell& cell);
+    [[nodiscard]] float distanceTo(const CellCoord& coord, const glm::vec3& focus) const;
+
+    AssetManager& m_assets;
+    SceneStore& m_scene;
+    std::string m_directory;
+    WorldPartitionSettings m_settings;
+
+    std::map<CellCoord, Cell> m_cells;
+    std::shared_ptr<Inbox> m_inbox = std::make_shared<Inbox>();
+    uint32_t m_loadsInFlight = 0;
+    WorldPartitionStats m_stats;
+};
+
+} // namespace reactor
@@ -10,6 +10,9 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 
+#include <cstdio>
+#include <utility>
+
 namespace reactor {
 
 Imgui::Imgui(VulkanContext &vulkanContext, Window &window, EventManager &eventManager) :
@@ -85,6 +88,7 @@ void Imgui::createFrame() {
     ShowDockspace();
     ShowSceneView();
     ShowInspector();
+    ShowMemoryInspector();
     ShowConsole();
 }
 
@@ -111,6 +115,19 @@ void Imgui::ShowDockspace() {
     ImGui::Begin("DockSpace Window", nullptr, window_flags);
     ImGui::PopStyleVar(2);
 
+    if (ImGui::BeginMenuBar()) {
+        if (ImGui::BeginMenu("File")) {
+            if (ImGui::MenuItem("Save Scene")) {
+                m_sceneRequest = SceneRequest::Save;
+            }
+            if (ImGui::MenuItem("Load Scene")) {
+                m_sceneRequest = SceneRequest::Load;
+            }
+            ImGui::EndMenu();
+        }
+        ImGui::EndMenuBar();
+    }
+
     // Create dockspace ID
     ImGuiID dockspace_id = ImGui::GetID("MyDockSpace");
     ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
@@ -196,6 +213,94 @@ void Imgui::ShowInspector() {
     ImGui::End();
 }
 
+void Imgui::ShowMemoryInspector() {
+    constexpr float MiB = 1024.0f * 1024.0f;
+
+    ImGui::Begin("Memory");
+
+    ImGui::Text("VK_EXT_memory_budget: %s", m_memoryReport.budgetExtension ? "enabled" : "unavailable (estimated)");
+
+    if (ImGui::CollapsingHeader("Heaps", ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (const auto& heap : m_memoryReport.heaps) {
+            const float usage = static_cast<float>(heap.usage) / MiB;
+            const float budget = static_cast<float>(heap.budget) / MiB;
+            const float fraction = heap.budget > 0 ? static_cast<float>(heap.usage) / static_cast<float>(heap.budget) : 0.0f;
+
+            ImGui::Text("Heap %u (%s)", heap.heapIndex, heap.deviceLocal ? "device local" : "host");
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", usage, budget);
+            ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), overlay);
+            ImGui::Text("  %u blocks, %u allocations, %.1f MiB allocated",
+                        heap.blockCount,
+                        heap.allocationCount,
+                        static_cast<float>(heap.allocationBytes) / MiB);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Categories", ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+            const auto& usage = m_memoryReport.categories[i];
+            ImGui::Text("%-15s %8.2f MiB (%u)",
+                        toString(static_cast<MemoryCategory>(i)),
+                        static_cast<float>(usage.bytes) / MiB,
+                        usage.count);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Defragmentation")) {
+        const auto& defrag = m_defragReport;
+        ImGui::Text("Status: %s", defrag.active ? "running" : "idle");
+        ImGui::Text("Fragmentation: %.1f%% -> %.1f%%",
+                    defrag.before.fragmentation * 100.0f,
+                    defrag.after.fragmentation * 100.0f);
+        ImGui::Text("Free: %.1f MiB in %u ranges (largest %.1f MiB)",
+                    static_cast<float>(defrag.after.unusedBytes) / MiB,
+                    defrag.after.unusedRangeCount,
+                    static_cast<float>(defrag.after.largestFreeRange) / MiB);
+        ImGui::Text("Moved: %u allocations, %.1f MiB over %u passes",
+                    defrag.allocationsMoved,
+                    static_cast<float>(defrag.bytesMoved) / MiB,
+                    defrag.passes);
+
+        ImGui::BeginDisabled(defrag.active);
+        if (ImGui::Button("Defragment")) {
+            m_defragmentRequested = true;
+        }
+        ImGui::EndDisabled();
+    }
+
+    if (ImGui::CollapsingHeader("Uploads")) {
+        ImGui::Text("This frame: %.2f MiB in %u copies",
+                    static_cast<float>(m_uploadStats.bytesThisFrame) / MiB,
+                    m_uploadStats.copiesThisFrame);
+        ImGui::Text("Pending: %.2f MiB in %zu buffers",
+                    static_cast<float>(m_uploadStats.pendingBytes) / MiB,
+                    m_uploadStats.pendingRequests);
+    }
+
+    if (ImGui::CollapsingHeader("Assets")) {
+        ImGui::Text("Meshes: %zu (%zu referenced, %zu loading)",
+                    m_assetStats.meshCount,
+                    m_assetStats.referencedCount,
+                    m_assetStats.loadingCount);
+        if (m_assetStats.budgetBytes > 0) {
+            ImGui::Text("Resident: %.2f / %.2f MiB",
+                        static_cast<float>(m_assetStats.residentBytes) / MiB,
+                        static_cast<float>(m_assetStats.budgetBytes) / MiB);
+        } else {
+            ImGui::Text("Resident: %.2f MiB", static_cast<float>(m_assetStats.residentBytes) / MiB);
+        }
+        ImGui::Text("LOD levels resident: %u / %u", m_assetStats.residentLodLevels, m_assetStats.lodLevels);
+        ImGui::Text("Evictions: %llu", static_cast<unsigned long long>(m_assetStats.evictions));
+    }
+
+    if (ImGui::Button("Dump JSON")) {
+        writeMemoryReport(m_memoryReport, "memory_report.json");
+    }
+
+    ImGui::End();
+}
+
 void Imgui::ShowConsole() {
     ImGui::Begin("Console");
     ImGui::Text("Console");
@@ -215,6 +320,7 @@ void Imgui::SetupInitialDockLayout(ImGuiID dockspace_id) {
     // Assign windows to dock nodes
     ImGui::DockBuilderDockWindow("Scene View", dock_main);
     ImGui::DockBuilderDockWindow("Inspector", dock_right);
+    ImGui::DockBuilderDockWindow("Memory", dock_right);
     ImGui::DockBuilderDockWindow("Console", dock_bottom);
     ImGui::DockBuilderDockWindow("Composite", dock_main);  // or move to its own panel
 
@@ -232,4 +338,8 @@ vk::DescriptorSet Imgui::createDescriptorSet(vk::ImageView imageView, vk::Sample
 
 }
 
+void Imgui::removeDescriptorSet(vk::DescriptorSet descriptorSet) {
+    ImGui_ImplVulkan_RemoveTexture(descriptorSet);
+}
+
 } // namespace reactor
\ No newline at end of file
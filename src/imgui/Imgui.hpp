@@ -4,13 +4,23 @@
 
 #ifndef IMGUI_HPP
 #define IMGUI_HPP
+#include "../core/AssetManager.hpp"
 #include "../core/Window.hpp"
+#include "../vulkan/Defragmenter.hpp"
+#include "../vulkan/MemoryTelemetry.hpp"
+#include "../vulkan/UploadScheduler.hpp"
 #include "../vulkan/VulkanContext.hpp"
 
 #include <imgui.h>
 
 namespace reactor {
 
+enum class SceneRequest {
+    None,
+    Save,
+    Load,
+};
+
 class Imgui {
 public:
     Imgui(VulkanContext& vulkanContext, Window& window, EventManager& eventManager);
@@ -25,7 +35,18 @@ public:
     [[nodiscard]] float getFogDensity() const { return m_fogDensity; }
 
     static vk::DescriptorSet createDescriptorSet(vk::ImageView imageView, vk::Sampler sampler);
+    static void removeDescriptorSet(vk::DescriptorSet descriptorSet);
     void setSceneDescriptorSet(const vk::DescriptorSet descriptorSet) { m_sceneImguiId = descriptorSet; };
+    void setMemoryReport(MemoryReport report) { m_memoryReport = std::move(report); }
+    void setDefragmentationReport(const DefragmentationReport& report) { m_defragReport = report; }
+    void setUploadStats(const UploadStats& stats) { m_uploadStats = stats; }
+    void setAssetCacheStats(const AssetCacheStats& stats) { m_assetStats = stats; }
+
+    // True once after the user pressed "Defragment" in the memory panel.
+    bool consumeDefragmentRequest() { return std::exchange(m_defragmentRequested, false); }
+
+    // The File menu action chosen since the last call, if any.
+    SceneRequest consumeSceneRequest() { return std::exchange(m_sceneRequest, SceneRequest::None); }
 
 private:
 
@@ -40,9 +61,17 @@ private:
     float m_saturation = 1.0f;
     float m_fogDensity = 0.001f;
 
+    MemoryReport m_memoryReport;
+    DefragmentationReport m_defragReport;
+    UploadStats m_uploadStats;
+    AssetCacheStats m_assetStats;
+    bool m_defragmentRequested = false;
+    SceneRequest m_sceneRequest = SceneRequest::None;
+
     void ShowDockspace();
     void ShowSceneView();
     void ShowInspector();
+    void ShowMemoryInspector();
     void ShowConsole();
     void SetupInitialDockLayout(ImGuiID dockspace_id);
 
@@ -1,9 +1,70 @@
+#include "../core/Impostor.hpp"
 #include "../core/ModelIO.hpp"
+#include "../core/Scatter.hpp"
+#include "../core/Terrain.hpp"
+#include "../core/WorldPartition.hpp"
 
 #include <spdlog/spdlog.h>
 
-int main()
+#include <filesystem>
+#include <string>
+
+int main(int argc, char** argv)
 {
+    // BuildModel --cell <scene.rscene> <world directory> [cell size]: splits a scene into the .cell
+    // bundles the world partition streams, by default in cells of the partition's default size
+    if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--cell") {
+        const float cellSize = argc == 5 ? std::stof(argv[4]) : reactor::WorldPartitionSettings{}.cellSize;
+        return reactor::cookWorldCells(argv[2], argv[3], cellSize) ? 0 : 1;
+    }
+
+    // BuildModel --hlod <world directory>: cooks a .hlod proxy next to every .cell bundle
+    if (argc == 3 && std::string(argv[1]) == "--hlod") {
+        int failed = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(argv[2])) {
+            if (entry.is_regular_file() && entry.path().extension() == ".cell" &&
+                !reactor::cookCellHlod(entry.path().string())) {
+                ++failed;
+            }
+        }
+        return failed == 0 ? 0 : 1;
+    }
+
+    // BuildModel --impostor <file.mesh>...: bakes an octahedral impostor atlas beside each mesh
+    if (argc >= 3 && std::string(argv[1]) == "--impostor") {
+        int failed = 0;
+        for (int i = 2; i < argc; ++i) {
+            if (!reactor::cookImpostors(argv[i])) {
+                ++failed;
+            }
+        }
+        return failed == 0 ? 0 : 1;
+    }
+
+    // BuildModel --terrain <heightmap.r16> <out dir> <tile samples> <spacing> <min height> <max height>:
+    // splits a raw 16-bit heightmap into streamed height tiles, e.g. 257 samples per tile
+    if (argc == 8 && std::string(argv[1]) == "--terrain") {
+        const bool ok = reactor::cookHeightmap(argv[2],
+                                               argv[3],
+                                               static_cast<uint32_t>(std::stoul(argv[4])),
+                                               std::stof(argv[5]),
+                                               std::stof(argv[6]),
+                                               std::stof(argv[7]));
+        return ok ? 0 : 1;
+    }
+
+    // BuildModel --scatter <density.r8> <prop.mesh> <out.scatter> <size> <spacing> [seed]: turns a
+    // raw 8-bit density map covering size units around the origin into a GPU scatter layer
+    if ((argc == 7 || argc == 8) && std::string(argv[1]) == "--scatter") {
+        const bool ok = reactor::cookScatterLayer(argv[2],
+                                                  argv[3],
+                                                  argv[4],
+                                                  std::stof(argv[5]),
+                                                  std::stof(argv[6]),
+                                                  argc == 8 ? static_cast<uint32_t>(std::stoul(argv[7])) : 0u);
+        return ok ? 0 : 1;
+    }
+
     // Define input and output paths
     const std::string inputModel = "../workspace/monkey.obj";
     const std::string outputModel = "./monkey.mesh";
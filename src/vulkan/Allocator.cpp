@@ -6,22 +6,56 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "Buffer.hpp"
 
 namespace reactor
 {
 
-Allocator::Allocator(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Instance instance, vk::Queue graphicsQueue, uint32_t graphicsQueueFamilyIndex)
-    : m_device(device), m_graphicsQueue(graphicsQueue), m_graphicQueueFamilyIndex(graphicsQueueFamilyIndex)
+Allocator::Allocator(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Instance instance, vk::Queue graphicsQueue, uint32_t graphicsQueueFamilyIndex, bool memoryBudgetEnabled)
+    : m_device(device), m_graphicsQueue(graphicsQueue), m_graphicQueueFamilyIndex(graphicsQueueFamilyIndex),
+      m_memoryBudgetEnabled(memoryBudgetEnabled)
 {
     VmaAllocatorCreateInfo allocatorInfo = {};
     allocatorInfo.physicalDevice = physicalDevice;
     allocatorInfo.device = device;
     allocatorInfo.instance = instance;
+    allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+
+    // VK_EXT_memory_budget lets VMA report real driver-side usage instead of its own estimate.
+    if (m_memoryBudgetEnabled)
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 
     vmaCreateAllocator(&allocatorInfo, &m_allocator);
 
-    spdlog::info("Allocator created");
+    spdlog::info("Allocator created (memory budget extension: {})", m_memoryBudgetEnabled);
+
+    // Look for memory the CPU can write that lives on the GPU. Without resizable BAR this is a
+    // 256 MiB window at most, so only tiny static uploads skip staging there.
+    const vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+    constexpr auto hostVisibleDeviceLocal =
+        vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        const auto& type = memoryProperties.memoryTypes[i];
+        if ((type.propertyFlags & hostVisibleDeviceLocal) == hostVisibleDeviceLocal)
+        {
+            m_hostVisibleDeviceLocalHeapSize =
+                std::max(m_hostVisibleDeviceLocalHeapSize, memoryProperties.memoryHeaps[type.heapIndex].size);
+        }
+    }
+
+    constexpr vk::DeviceSize barWindow = 256ull * 1024 * 1024;
+    if (m_hostVisibleDeviceLocalHeapSize > barWindow)
+        m_directUploadLimit = 4 * 1024 * 1024;
+    else if (m_hostVisibleDeviceLocalHeapSize > 0)
+        m_directUploadLimit = 64 * 1024;
+
+    spdlog::info("Host-visible device-local heap: {} MiB, direct upload limit {} KiB",
+                 m_hostVisibleDeviceLocalHeapSize / (1024 * 1024),
+                 m_directUploadLimit / 1024);
 }
 
 Allocator::~Allocator()
@@ -30,21 +64,70 @@ Allocator::~Allocator()
         vmaDestroyAllocator(m_allocator);
 }
 
+MemoryReport Allocator::memoryReport() const
+{
+    return m_telemetry.snapshot(m_allocator, m_memoryBudgetEnabled);
+}
+
+VmaAllocationCreateInfo Allocator::allocationCreateInfo(MemoryPlacement placement) const
+{
+    VmaAllocationCreateInfo info = {};
+
+    switch (placement)
+    {
+    case MemoryPlacement::GpuOnly:
+        info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        break;
+    case MemoryPlacement::Dynamic:
+        // VMA picks HOST_VISIBLE | DEVICE_LOCAL when it exists and falls back to system memory.
+        info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+    case MemoryPlacement::StaticUpload:
+        // May land in memory that is not host visible; callers must check and stage in that case.
+        info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+                     | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT
+                     | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+    case MemoryPlacement::Staging:
+        info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+    case MemoryPlacement::Readback:
+        info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+    }
+
+    return info;
+}
+
 std::unique_ptr<Buffer> Allocator::createBufferWithData(const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage, const std::string& name)
 {
+    // Small static data goes straight into host-visible device-local memory when the device has it
+    if (size <= m_directUploadLimit)
+    {
+        auto directBuffer = std::make_unique<Buffer>(*this, size, usage, MemoryPlacement::StaticUpload, name);
+        if (directBuffer->isHostVisible())
+        {
+            memcpy(directBuffer->mappedData(), data, size);
+            directBuffer->flush();
+            return directBuffer;
+        }
+    }
+
     // Create CPU-visible staging buffer
     Buffer stagingBuffer(
         *this,
         size,
         vk::BufferUsageFlagBits::eTransferSrc,
-        VMA_MEMORY_USAGE_CPU_ONLY,
+        MemoryPlacement::Staging,
         name + " Staging");
 
-    // Map and copy data to staging buffer
-    void* mappedData;
-    vmaMapMemory(m_allocator, stagingBuffer.allocation(), &mappedData);
-    memcpy(mappedData, data, size);
-    vmaUnmapMemory(m_allocator, stagingBuffer.allocation());
+    // Copy data into the persistently mapped staging buffer
+    memcpy(stagingBuffer.mappedData(), data, size);
+    stagingBuffer.flush();
 
     // Create GPU-local destination buffer
     // Add the transfer destination usage flag
@@ -53,7 +136,7 @@ std::unique_ptr<Buffer> Allocator::createBufferWithData(const void* data, vk::De
         *this,
         size,
         usage,
-        VMA_MEMORY_USAGE_GPU_ONLY,
+        MemoryPlacement::GpuOnly,
         name);
 
     // Perform the copy
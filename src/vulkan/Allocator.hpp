@@ -4,14 +4,28 @@
 #include <vulkan/vulkan.hpp>
 #include <functional>
 
+#include "MemoryTelemetry.hpp"
+
 namespace reactor
 {
 class Buffer;
+class Defragmenter;
+
+// How a buffer's memory is accessed. The Allocator maps this onto the heaps the device actually
+// exposes, preferring host-visible device-local (ReBAR) memory for CPU-written data when present.
+enum class MemoryPlacement
+{
+    GpuOnly,      // Written by transfers or shaders only. Movable by the Defragmenter.
+    Dynamic,      // Rewritten by the CPU every frame and read by shaders (uniforms, instance data).
+    StaticUpload, // Written once by the CPU, then only read by the GPU.
+    Staging,      // CPU-written transfer source.
+    Readback,     // GPU-written, CPU-read.
+};
 
 class Allocator
 {
 public:
-    Allocator(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Instance instance, vk::Queue graphicsQueue, uint32_t graphicsQueueFamilyIndex);
+    Allocator(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Instance instance, vk::Queue graphicsQueue, uint32_t graphicsQueueFamilyIndex, bool memoryBudgetEnabled = false);
     ~Allocator();
 
     VmaAllocator getAllocator() const
@@ -31,6 +45,34 @@ public:
         return m_graphicQueueFamilyIndex;
     }
 
+    MemoryTelemetry& telemetry()
+    {
+        return m_telemetry;
+    }
+
+    // Per-heap budget/usage plus the per-category totals tracked by Buffer and Image.
+    [[nodiscard]] MemoryReport memoryReport() const;
+
+    // -- Placement policy --
+    [[nodiscard]] VmaAllocationCreateInfo allocationCreateInfo(MemoryPlacement placement) const;
+    // Static data up to this size is written straight into host-visible device-local memory
+    // instead of going through a staging copy. Zero when no such heap exists.
+    [[nodiscard]] vk::DeviceSize directUploadLimit() const
+    {
+        return m_directUploadLimit;
+    }
+
+    // The active Defragmenter registers itself here so a Buffer destroyed while one of its moves is
+    // in flight can hand that move back instead of freeing an allocation VMA is still relocating.
+    void setDefragmenter(Defragmenter* defragmenter)
+    {
+        m_defragmenter = defragmenter;
+    }
+    [[nodiscard]] Defragmenter* defragmenter() const
+    {
+        return m_defragmenter;
+    }
+
     // New factory method
     std::unique_ptr<Buffer> createBufferWithData(
         const void* data,
@@ -50,6 +92,12 @@ private:
     vk::Device m_device;
     vk::Queue m_graphicsQueue;
     uint32_t m_graphicQueueFamilyIndex;
+    bool m_memoryBudgetEnabled = false;
+    MemoryTelemetry m_telemetry;
+    Defragmenter* m_defragmenter = nullptr;
+
+    vk::DeviceSize m_hostVisibleDeviceLocalHeapSize = 0;
+    vk::DeviceSize m_directUploadLimit = 0;
 };
 
 } // namespace reactor
@@ -4,37 +4,80 @@
 
 #include "Buffer.hpp"
 
+#include "Defragmenter.hpp"
+
 #include <spdlog/spdlog.h>
 
 namespace reactor {
 
+namespace {
+    MemoryPlacement placementFor(VmaMemoryUsage memoryUsage) {
+        switch (memoryUsage) {
+            case VMA_MEMORY_USAGE_CPU_ONLY:
+                return MemoryPlacement::Staging;
+            case VMA_MEMORY_USAGE_CPU_TO_GPU:
+                return MemoryPlacement::Dynamic;
+            case VMA_MEMORY_USAGE_GPU_TO_CPU:
+                return MemoryPlacement::Readback;
+            default:
+                return MemoryPlacement::GpuOnly;
+        }
+    }
+}
+
     Buffer::Buffer(Allocator &allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage, std::string name)
-        : m_allocator(allocator), m_size(size), m_name(name)
+        : Buffer(allocator, size, usage, placementFor(memoryUsage), std::move(name))
+    {}
+
+    Buffer::Buffer(Allocator &allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, MemoryPlacement placement, std::string name)
+        : m_allocator(allocator), m_size(size), m_placement(placement), m_name(std::move(name)),
+          m_category(classifyBufferName(m_name))
     {
+        // Movable buffers must be usable as both ends of the defragmentation copy.
+        m_movable = placement == MemoryPlacement::GpuOnly;
+        m_usage = usage;
+        if (m_movable) {
+            m_usage |= vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+        }
+
         vk::BufferCreateInfo bufferInfo = {};
         bufferInfo.size = size;
-        bufferInfo.usage = usage;
+        bufferInfo.usage = m_usage;
         bufferInfo.sharingMode = vk::SharingMode::eExclusive;
 
-        VmaAllocationCreateInfo allocInfo = {};
-        allocInfo.usage = memoryUsage;
+        VmaAllocationCreateInfo allocInfo = m_allocator.allocationCreateInfo(placement);
+        allocInfo.pUserData = this;
 
+        VmaAllocationInfo allocationInfo = {};
         const VkResult result = vmaCreateBuffer(
             m_allocator.getAllocator(),
             reinterpret_cast<const VkBufferCreateInfo *>(&bufferInfo),
             &allocInfo,
             reinterpret_cast<VkBuffer *>(&m_buffer),
             &m_allocation,
-            nullptr);
+            &allocationInfo);
 
         if (result != VK_SUCCESS) {
             throw std::runtime_error("failed to create buffer!");
         }
+
+        // VMA leaves pMappedData null when a StaticUpload allocation fell back to non-host-visible memory.
+        m_mappedData = allocationInfo.pMappedData;
+
+        m_allocationSize = allocationInfo.size;
+        m_allocator.telemetry().track(m_category, m_allocationSize);
     }
 
     Buffer::~Buffer() {
         if (m_buffer && m_allocation) {
-            vmaDestroyBuffer(m_allocator.getAllocator(), m_buffer, m_allocation);
+            // Mid-move, the allocation belongs to the defragmentation pass until it ends.
+            Defragmenter* defragmenter = m_allocator.defragmenter();
+            if (defragmenter && defragmenter->release(*this)) {
+                m_allocator.getDevice().destroyBuffer(m_buffer);
+            } else {
+                vmaDestroyBuffer(m_allocator.getAllocator(), m_buffer, m_allocation);
+            }
+            m_allocator.telemetry().untrack(m_category, m_allocationSize);
 
             spdlog::info("Buffer {} destroyed", m_name.c_str());
 
@@ -53,5 +96,23 @@ void Buffer::unmap() {
     vmaUnmapMemory(m_allocator.getAllocator(), m_allocation);
 }
 
+void Buffer::flush(vk::DeviceSize offset, vk::DeviceSize size) {
+    vmaFlushAllocation(m_allocator.getAllocator(), m_allocation, offset, size);
+}
+
+void Buffer::invalidate(vk::DeviceSize offset, vk::DeviceSize size) {
+    vmaInvalidateAllocation(m_allocator.getAllocator(), m_allocation, offset, size);
+}
+
+vk::Buffer Buffer::relocate(vk::Buffer newHandle) {
+    const vk::Buffer oldHandle = m_buffer;
+    m_buffer = newHandle;
+
+    for (const auto& callback : m_relocationCallbacks) {
+        callback(*this);
+    }
+    return oldHandle;
+}
+
 
 } // reactor
\ No newline at end of file
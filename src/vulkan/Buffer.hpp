@@ -4,10 +4,15 @@
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
+#include <functional>
+
 namespace reactor {
 
 class Buffer {
 public:
+    Buffer(Allocator& allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, MemoryPlacement placement, std::string name="");
+
+    // Legacy VMA usages are translated to the equivalent placement.
     Buffer(Allocator& allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage, std::string name="");
 
     ~Buffer();
@@ -21,17 +26,50 @@ public:
     [[nodiscard]] vk::Buffer getHandle() const { return m_buffer; }
     [[nodiscard]] VmaAllocation allocation() const { return m_allocation; }
     [[nodiscard]] vk::DeviceSize size() const { return m_size; }
+    [[nodiscard]] MemoryCategory category() const { return m_category; }
+    [[nodiscard]] vk::BufferUsageFlags usage() const { return m_usage; }
+    [[nodiscard]] MemoryPlacement placement() const { return m_placement; }
+
+    // Non-null for every placement except GpuOnly, and for StaticUpload only when it landed in
+    // host-visible memory. The mapping lives as long as the buffer.
+    [[nodiscard]] void* mappedData() const { return m_mappedData; }
+    [[nodiscard]] bool isHostVisible() const { return m_mappedData != nullptr; }
+
+    // Makes CPU writes visible to the device; a no-op on host-coherent memory.
+    void flush(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+    // Makes device writes visible to CPU reads; a no-op on host-coherent memory.
+    void invalidate(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+
+    // Device-local buffers may be relocated by the Defragmenter; host-visible ones stay pinned.
+    [[nodiscard]] bool isMovable() const { return m_movable; }
+
+    // Invoked after the defragmenter swapped in a new vk::Buffer. Owners of descriptor sets that
+    // reference this buffer use it to rewrite them; per-frame users just read getHandle() again.
+    using RelocationCallback = std::function<void(const Buffer&)>;
+    void addRelocationCallback(RelocationCallback callback) { m_relocationCallbacks.push_back(std::move(callback)); }
 
     void* map();
     void unmap();
 
 private:
+    friend class Defragmenter;
+
+    // Replaces the handle with one bound to the allocation's new location. Returns the old handle.
+    vk::Buffer relocate(vk::Buffer newHandle);
+
     Allocator& m_allocator;
     vk::Buffer m_buffer = VK_NULL_HANDLE;
     VmaAllocation m_allocation = VK_NULL_HANDLE;
     vk::DeviceSize m_size = 0;
+    vk::DeviceSize m_allocationSize = 0;
+    vk::BufferUsageFlags m_usage;
+    MemoryPlacement m_placement = MemoryPlacement::GpuOnly;
+    bool m_movable = false;
+    void* m_mappedData = nullptr;
 
     std::string m_name;
+    MemoryCategory m_category = MemoryCategory::Other;
+    std::vector<RelocationCallback> m_relocationCallbacks;
 };
 
 } // reactor
@@ -0,0 +1,261 @@
+#include "Defragmenter.hpp"
+
+#include "Buffer.hpp"
+
+#include <spdlog/spdlog.h>
+
+namespace reactor
+{
+
+Defragmenter::Defragmenter(Allocator& allocator, vk::DeviceSize maxBytesPerFrame, uint32_t maxMovesPerFrame)
+    : m_allocator(allocator), m_maxBytesPerFrame(maxBytesPerFrame), m_maxMovesPerFrame(maxMovesPerFrame)
+{
+    m_allocator.setDefragmenter(this);
+}
+
+Defragmenter::~Defragmenter()
+{
+    // The owner waits for the device to go idle before tearing down, so a pending pass is complete.
+    if (m_passPending)
+    {
+        finishPass();
+    }
+    if (m_context)
+    {
+        end();
+    }
+    m_allocator.setDefragmenter(nullptr);
+}
+
+void Defragmenter::request()
+{
+    if (!m_context)
+    {
+        begin();
+    }
+}
+
+void Defragmenter::setAutoTrigger(float fragmentationThreshold, vk::DeviceSize minUnusedBytes, uint32_t checkInterval)
+{
+    m_autoThreshold = fragmentationThreshold;
+    m_autoMinUnused = minUnusedBytes;
+    m_autoInterval = checkInterval;
+}
+
+void Defragmenter::update(vk::CommandBuffer cmd, size_t frameSlot)
+{
+    if (m_passPending)
+    {
+        // Only one pass is in flight; it completes when its own frame slot comes around again.
+        if (frameSlot != m_pendingSlot)
+        {
+            return;
+        }
+        finishPass();
+    }
+
+    if (!m_context && m_autoInterval > 0 && ++m_framesSinceCheck >= m_autoInterval)
+    {
+        m_framesSinceCheck = 0;
+        const FragmentationStats stats = measure(m_allocator.getAllocator());
+        if (stats.fragmentation > m_autoThreshold && stats.unusedBytes > m_autoMinUnused)
+        {
+            begin();
+        }
+    }
+
+    if (m_context)
+    {
+        recordPass(cmd);
+        if (m_passPending)
+        {
+            m_pendingSlot = frameSlot;
+        }
+    }
+}
+
+void Defragmenter::begin()
+{
+    m_report = {};
+    m_report.before = measure(m_allocator.getAllocator());
+    m_report.active = true;
+
+    VmaDefragmentationInfo info = {};
+    info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    info.pool = nullptr; // default pools
+    info.maxBytesPerPass = m_maxBytesPerFrame;
+    info.maxAllocationsPerPass = m_maxMovesPerFrame;
+
+    if (vmaBeginDefragmentation(m_allocator.getAllocator(), &info, &m_context) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to begin GPU memory defragmentation");
+        m_context = nullptr;
+        m_report.active = false;
+        return;
+    }
+
+    spdlog::info("Defragmentation started: {:.1f}% fragmented, {} bytes free in {} ranges",
+                 m_report.before.fragmentation * 100.0f,
+                 m_report.before.unusedBytes,
+                 m_report.before.unusedRangeCount);
+}
+
+void Defragmenter::recordPass(vk::CommandBuffer cmd)
+{
+    const VmaAllocator allocator = m_allocator.getAllocator();
+    const vk::Device device = m_allocator.getDevice();
+
+    const VkResult result = vmaBeginDefragmentationPass(allocator, m_context, &m_passInfo);
+    if (result == VK_SUCCESS)
+    {
+        // Nothing left to move
+        end();
+        return;
+    }
+    if (result != VK_INCOMPLETE)
+    {
+        spdlog::error("Defragmentation pass failed to begin");
+        end();
+        return;
+    }
+
+    bool anyCopies = false;
+    for (uint32_t i = 0; i < m_passInfo.moveCount; ++i)
+    {
+        VmaDefragmentationMove& move = m_passInfo.pMoves[i];
+
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(allocator, move.srcAllocation, &allocationInfo);
+
+        // Buffers register themselves as user data; images leave it null and stay pinned.
+        auto* buffer = static_cast<Buffer*>(allocationInfo.pUserData);
+        if (buffer == nullptr || !buffer->isMovable())
+        {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        vk::BufferCreateInfo bufferInfo{};
+        bufferInfo.size = buffer->size();
+        bufferInfo.usage = buffer->usage();
+        bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+        const vk::Buffer newHandle = device.createBuffer(bufferInfo);
+        if (vmaBindBufferMemory(allocator, move.dstTmpAllocation, newHandle) != VK_SUCCESS)
+        {
+            device.destroyBuffer(newHandle);
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        const vk::BufferCopy region(0, 0, buffer->size());
+        cmd.copyBuffer(buffer->getHandle(), newHandle, 1, &region);
+
+        // Everything recorded from here on, including this frame's draws, uses the new handle.
+        m_pendingMoves.push_back({buffer, buffer->relocate(newHandle), i});
+        anyCopies = true;
+    }
+
+    if (anyCopies)
+    {
+        vk::MemoryBarrier barrier{};
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+                                | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead
+                                | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                            vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader
+                                | vk::PipelineStageFlagBits::eFragmentShader
+                                | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                            {},
+                            barrier,
+                            nullptr,
+                            nullptr);
+    }
+
+    m_passPending = true;
+    m_report.passes++;
+}
+
+bool Defragmenter::release(Buffer& buffer)
+{
+    if (!m_passPending)
+    {
+        return false;
+    }
+    for (auto& move : m_pendingMoves)
+    {
+        if (move.buffer == &buffer)
+        {
+            // The old handle is still destroyed in finishPass; the frame copying out of it may be
+            // in flight.
+            m_passInfo.pMoves[move.moveIndex].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            move.buffer = nullptr;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Defragmenter::finishPass()
+{
+    const vk::Device device = m_allocator.getDevice();
+
+    // The frame that copied out of the old buffers has completed, and every later frame was
+    // recorded against the new handles.
+    for (const auto& move : m_pendingMoves)
+    {
+        device.destroyBuffer(move.oldHandle);
+    }
+    m_pendingMoves.clear();
+    m_passPending = false;
+
+    const VkResult result = vmaEndDefragmentationPass(m_allocator.getAllocator(), m_context, &m_passInfo);
+    if (result == VK_SUCCESS)
+    {
+        end();
+    }
+}
+
+void Defragmenter::end()
+{
+    VmaDefragmentationStats stats = {};
+    vmaEndDefragmentation(m_allocator.getAllocator(), m_context, &stats);
+    m_context = nullptr;
+
+    m_report.active = false;
+    m_report.bytesMoved = stats.bytesMoved;
+    m_report.allocationsMoved = stats.allocationsMoved;
+    m_report.after = measure(m_allocator.getAllocator());
+
+    spdlog::info("Defragmentation finished after {} passes: moved {} allocations ({} bytes), "
+                 "fragmentation {:.1f}% -> {:.1f}%, freed {} bytes of blocks",
+                 m_report.passes,
+                 stats.allocationsMoved,
+                 stats.bytesMoved,
+                 m_report.before.fragmentation * 100.0f,
+                 m_report.after.fragmentation * 100.0f,
+                 stats.bytesFreed);
+}
+
+FragmentationStats Defragmenter::measure(VmaAllocator allocator)
+{
+    VmaTotalStatistics totals = {};
+    vmaCalculateStatistics(allocator, &totals);
+
+    FragmentationStats stats;
+    stats.blockBytes = totals.total.statistics.blockBytes;
+    stats.allocationBytes = totals.total.statistics.allocationBytes;
+    stats.unusedBytes = stats.blockBytes - stats.allocationBytes;
+    stats.largestFreeRange = totals.total.unusedRangeSizeMax;
+    stats.unusedRangeCount = totals.total.unusedRangeCount;
+
+    if (stats.unusedBytes > 0)
+    {
+        stats.fragmentation =
+            1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(stats.unusedBytes);
+    }
+    return stats;
+}
+
+} // namespace reactor
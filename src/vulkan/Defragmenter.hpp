@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Allocator.hpp"
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+namespace reactor
+{
+
+struct FragmentationStats
+{
+    vk::DeviceSize blockBytes = 0;
+    vk::DeviceSize allocationBytes = 0;
+    vk::DeviceSize unusedBytes = 0;
+    vk::DeviceSize largestFreeRange = 0;
+    uint32_t unusedRangeCount = 0;
+
+    // 0 = all free space is one contiguous range, approaching 1 = free space is scattered.
+    float fragmentation = 0.0f;
+};
+
+struct DefragmentationReport
+{
+    bool active = false;
+    FragmentationStats before;
+    FragmentationStats after;
+    vk::DeviceSize bytesMoved = 0;
+    uint32_t allocationsMoved = 0;
+    uint32_t passes = 0;
+};
+
+// Incrementally compacts VMA's default pools using the defragmentation API. Each frame at most
+// one pass is in flight: its copies are recorded into the frame's command buffer and the pass is
+// ended once that frame's fence has been waited on again. Only buffers flagged movable are
+// relocated; images and host-visible buffers are left in place.
+class Defragmenter
+{
+public:
+    explicit Defragmenter(Allocator& allocator,
+                          vk::DeviceSize maxBytesPerFrame = 8 * 1024 * 1024,
+                          uint32_t maxMovesPerFrame = 64);
+    ~Defragmenter();
+
+    Defragmenter(const Defragmenter&) = delete;
+    Defragmenter& operator=(const Defragmenter&) = delete;
+
+    // Starts a defragmentation cycle if none is running.
+    void request();
+
+    // Call once per frame after the frame slot's fence has been waited on and the command buffer
+    // has begun. Finishes the pass recorded in this slot earlier and records the next one.
+    void update(vk::CommandBuffer cmd, size_t frameSlot);
+
+    // A cycle is started automatically every checkInterval frames when fragmentation exceeds the
+    // threshold and there is enough free space worth compacting.
+    void setAutoTrigger(float fragmentationThreshold, vk::DeviceSize minUnusedBytes, uint32_t checkInterval = 600);
+
+    [[nodiscard]] bool isActive() const
+    {
+        return m_context != nullptr;
+    }
+    [[nodiscard]] const DefragmentationReport& report() const
+    {
+        return m_report;
+    }
+
+    static FragmentationStats measure(VmaAllocator allocator);
+
+    // Called by a Buffer's destructor. If the buffer has a move in the pass still in flight, the
+    // move is switched to a destroy so VMA frees both its source and destination at the end of the
+    // pass, and true is returned: the caller then only destroys its vk::Buffer handle and must not
+    // free the allocation itself.
+    bool release(Buffer& buffer);
+
+private:
+    struct PendingMove
+    {
+        Buffer* buffer = nullptr; // null once the buffer was destroyed during the pass
+        vk::Buffer oldHandle;
+        uint32_t moveIndex = 0;   // into m_passInfo.pMoves
+    };
+
+    void begin();
+    void finishPass();
+    void recordPass(vk::CommandBuffer cmd);
+    void end();
+
+    Allocator& m_allocator;
+    vk::DeviceSize m_maxBytesPerFrame;
+    uint32_t m_maxMovesPerFrame;
+
+    VmaDefragmentationContext m_context = nullptr;
+    VmaDefragmentationPassMoveInfo m_passInfo{};
+    std::vector<PendingMove> m_pendingMoves;
+    bool m_passPending = false;
+    size_t m_pendingSlot = 0;
+
+    float m_autoThreshold = 0.0f;
+    vk::DeviceSize m_autoMinUnused = 0;
+    uint32_t m_autoInterval = 0;
+    uint32_t m_framesSinceCheck = 0;
+
+    DefragmentationReport m_report;
+};
+
+} // namespace reactor
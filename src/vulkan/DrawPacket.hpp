@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace reactor
+{
+
+class Mesh;
+
+enum class DrawPass : uint32_t
+{
+    DepthPrepass = 0,
+    Shadow = 1,
+    Main = 2,
+};
+
+// One visible entity to draw in one pass. Sorting by key groups draws by pass, pipeline, material
+// and mesh, and orders each group front to back.
+//
+// Key layout, most significant first:
+//   63-62 pass | 61-56 pipeline | 55-44 material | 43-24 mesh | 23-0 depth
+struct DrawPacket
+{
+    uint64_t key;
+    const Mesh* mesh;
+    uint32_t entity; // dense scene index
+
+    static uint64_t makeKey(DrawPass pass, uint32_t pipeline, uint32_t material, const Mesh* mesh, float depth)
+    {
+        // Non-negative floats order like their bit patterns; the top 24 bits keep the exponent and
+        // 15 bits of mantissa, so near objects still sort finely without a fixed depth range
+        uint32_t depthBits;
+        const float clamped = depth > 0.0f ? depth : 0.0f;
+        std::memcpy(&depthBits, &clamped, sizeof(depthBits));
+
+        return (static_cast<uint64_t>(pass) & 0x3) << 62 | (static_cast<uint64_t>(pipeline) & 0x3F) << 56
+               | (static_cast<uint64_t>(material) & 0xFFF) << 44 | static_cast<uint64_t>(meshBits(mesh)) << 24
+               | (depthBits >> 8);
+    }
+
+    static uint32_t material(uint64_t key)
+    {
+        return static_cast<uint32_t>((key >> 44) & 0xFFF);
+    }
+
+    static uint32_t depthBits(uint64_t key)
+    {
+        return static_cast<uint32_t>(key & 0xFFFFFF);
+    }
+
+private:
+    // Twenty scrambled pointer bits. Two meshes may share them; batches still split on the pointer
+    // itself, so a collision costs an extra draw, never a wrong one.
+    static uint32_t meshBits(const Mesh* mesh)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(mesh) >> 4;
+        return static_cast<uint32_t>((static_cast<uint64_t>(address) * 0x9E3779B97F4A7C15ull) >> 44);
+    }
+};
+
+} // namespace reactor
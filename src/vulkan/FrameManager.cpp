@@ -29,7 +29,7 @@ FrameManager::FrameManager(vk::Device device, Allocator& allocator, uint32_t com
         frame.inFlightFence = m_device.createFence(fenceInfo);
 
         // create a uniform buffer
-        frame.uniformBuffer = std::make_unique<Buffer>(allocator, 1024, vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_ONLY);
+        frame.uniformBuffer = std::make_unique<Buffer>(allocator, 1024, vk::BufferUsageFlagBits::eUniformBuffer, MemoryPlacement::Dynamic, "Frame Uniform Buffer");
     }
 
     vk::SemaphoreCreateInfo semaphoreInfo{};
@@ -51,6 +51,9 @@ FrameManager::FrameManager(vk::Device device, Allocator& allocator, uint32_t com
 FrameManager::~FrameManager() {
     spdlog::info("Destroying FrameManager and cleaning up resources.");
 
+    // The owner has waited for the device to go idle, so nothing can still be in flight.
+    flushDeferred();
+
     for (auto& semaphore : m_imageAvailableSemaphores) {
         m_device.destroySemaphore(semaphore);
     }
@@ -76,6 +79,9 @@ bool FrameManager::beginFrame(vk::SwapchainKHR swapchain, uint32_t& outImageInde
         throw std::runtime_error("Failed to wait for fence!");
     }
 
+    // Every frame up to m_frameNumber - framesInFlight is now known to be complete.
+    collectDeferred();
+
     auto resultValue = m_device.acquireNextImageKHR(
         swapchain,
         UINT64_MAX,
@@ -133,6 +139,74 @@ void FrameManager::endFrame(vk::Queue graphicsQueue, vk::Queue presentQueue, vk:
 
     // Advance to next frame
     m_currentFrame = (m_currentFrame + 1) % m_frames.size();
+    m_frameNumber++;
+}
+
+void FrameManager::onSwapchainRecreated(uint32_t swapchainImageCount) {
+    // The old images may still have a present pending that waits on these semaphores.
+    auto oldSemaphores = std::move(m_renderFinishedSemaphores);
+    defer([device = m_device, oldSemaphores = std::move(oldSemaphores)] {
+        for (auto semaphore : oldSemaphores) {
+            device.destroySemaphore(semaphore);
+        }
+    });
+
+    vk::SemaphoreCreateInfo semaphoreInfo{};
+    m_renderFinishedSemaphores.resize(swapchainImageCount);
+    for (auto& semaphore : m_renderFinishedSemaphores) {
+        semaphore = m_device.createSemaphore(semaphoreInfo);
+    }
+
+    m_imagesInFlight.assign(swapchainImageCount, VK_NULL_HANDLE);
+}
+
+void FrameManager::defer(std::function<void()>&& release) {
+    std::lock_guard lock(m_deferredMutex);
+    m_deferred.push_back({m_frameNumber, std::move(release)});
+}
+
+void FrameManager::retire(vk::ImageView view) {
+    if (!view) return;
+    defer([device = m_device, view] { device.destroyImageView(view); });
+}
+
+void FrameManager::retire(vk::Pipeline pipeline) {
+    if (!pipeline) return;
+    defer([device = m_device, pipeline] { device.destroyPipeline(pipeline); });
+}
+
+void FrameManager::collectDeferred() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(m_deferredMutex);
+        // Entries are queued in frame order; a resource retired during frame N may have been
+        // recorded into frame N, which is complete once slot N is reused at frame N + framesInFlight.
+        while (!m_deferred.empty() && m_deferred.front().frameNumber + m_framesInFlightCount <= m_frameNumber) {
+            ready.push_back(std::move(m_deferred.front().release));
+            m_deferred.pop_front();
+        }
+    }
+
+    // Run outside the lock; a release may itself retire further resources.
+    for (auto& release : ready) {
+        release();
+    }
+}
+
+void FrameManager::flushDeferred() {
+    for (;;) {
+        std::deque<DeferredRelease> pending;
+        {
+            std::lock_guard lock(m_deferredMutex);
+            if (m_deferred.empty()) {
+                break;
+            }
+            pending.swap(m_deferred);
+        }
+        for (auto& entry : pending) {
+            entry.release();
+        }
+    }
 }
 
 } // namespace reactor
@@ -7,6 +7,11 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
 #include "Buffer.hpp"
 
 namespace reactor {
@@ -38,7 +43,45 @@ namespace reactor {
         size_t getFramesInFlightCount() const { return m_framesInFlightCount; }
         size_t getCurrentFrameIndex() const { return m_currentFrame; }
 
+        // Monotonic number of the frame currently being recorded.
+        uint64_t getFrameNumber() const { return m_frameNumber; }
+
+        // Call after the swapchain was recreated; present semaphores of the old images are retired.
+        void onSwapchainRecreated(uint32_t swapchainImageCount);
+
+        // -- Deferred destruction --
+        // Releases run once every frame that could still reference the resource has signaled its
+        // fence, i.e. when the current frame's slot comes around again. Safe to call from any thread
+        // and at any point of the frame, including between endFrame and beginFrame.
+        void defer(std::function<void()>&& release);
+
+        template <typename T>
+        void retire(std::unique_ptr<T> resource) {
+            if (!resource) return;
+            auto holder = std::make_shared<std::unique_ptr<T>>(std::move(resource));
+            defer([holder] { holder->reset(); });
+        }
+
+        template <typename T>
+        void retire(std::shared_ptr<T> resource) {
+            if (!resource) return;
+            defer([resource = std::move(resource)]() mutable { resource.reset(); });
+        }
+
+        void retire(vk::ImageView view);
+        void retire(vk::Pipeline pipeline);
+
+        // Runs every pending release regardless of fences. Only valid once the device is idle.
+        void flushDeferred();
+
     private:
+        void collectDeferred();
+
+        struct DeferredRelease {
+            uint64_t frameNumber;
+            std::function<void()> release;
+        };
+
         vk::Device m_device;
         vk::CommandPool m_commandPool;
         std::vector<Frame> m_frames;
@@ -47,6 +90,10 @@ namespace reactor {
         std::vector<vk::Fence> m_imagesInFlight;
         size_t m_currentFrame;
         size_t m_framesInFlightCount;
+        std::atomic<uint64_t> m_frameNumber{0};
+
+        std::mutex m_deferredMutex;
+        std::deque<DeferredRelease> m_deferred;
     };
 }
 #endif //FRAMEMANAGER_HPP
@@ -0,0 +1,516 @@
+#include "GpuCulling.hpp"
+
+#include "../core/SceneStore.hpp"
+#include "FrameManager.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+constexpr uint32_t kWorkgroupSize = 64; // local_size_x in cull.comp
+constexpr vk::DeviceSize kMinBufferSize = 256;
+constexpr uint32_t kInitialInstanceBudget = 256; // per view, for a mesh with no counts yet
+
+// Layouts shared with cull.comp
+struct GpuMeshInfo
+{
+    uint32_t firstLevel;
+    uint32_t levelCount;
+    float localRadius;
+    uint32_t fallbackDraw;
+};
+
+struct GpuLevelInfo
+{
+    float error;
+    uint32_t draw;
+};
+
+struct CullUniforms
+{
+    glm::mat4 viewProjection;
+    glm::mat4 occluderViewProjection;
+    glm::vec4 planes[18];
+    glm::vec4 eye; // w: pixels per unit at distance 1
+    glm::vec4 hiZ; // xy mip-0 size, z mip count, w 1 when it holds the previous frame
+    float maxPixelError;
+    uint32_t objectCount;
+    uint32_t drawCount;
+    uint32_t instanceCapacity; // end of the last draw's range
+};
+
+enum Binding : uint32_t
+{
+    BindTransforms = 0,
+    BindSphereX = 1, // through BindSphereRadius = 4
+    BindMeshIds = 5,
+    BindFlags = 6,
+    BindMeshes = 7,
+    BindLevels = 8,
+    BindDraws = 9,
+    BindInstances = 10,
+    BindLodRequests = 11,
+    BindOccludedEarly = 12,
+    BindUniforms = 13,
+    BindHiZ = 14,
+};
+
+// Fills a mapped host-visible buffer and makes the write visible to the device
+void write(Buffer& buffer, const void* data, size_t bytes)
+{
+    if (bytes > 0)
+    {
+        std::memcpy(buffer.mappedData(), data, bytes);
+        buffer.flush(0, bytes);
+    }
+}
+} // namespace
+
+GpuCulling::GpuCulling(VulkanRenderer& renderer,
+                       FrameManager& frameManager,
+                       HiZPyramid& hiZ,
+                       const std::string& shaderPath)
+    : m_renderer(renderer), m_frameManager(frameManager), m_hiZ(hiZ)
+{
+    m_frames.resize(m_frameManager.getFramesInFlightCount());
+    for (auto& frame : m_frames)
+    {
+        frame.uniforms = std::make_unique<Buffer>(m_renderer.allocator(),
+                                                  sizeof(CullUniforms),
+                                                  vk::BufferUsageFlagBits::eUniformBuffer,
+                                                  MemoryPlacement::Dynamic,
+                                                  "Cull Uniforms");
+    }
+    createPipeline(shaderPath);
+}
+
+void GpuCulling::createPipeline(const std::string& shaderPath)
+{
+    spdlog::info("Creating GPU culling pipeline");
+
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+    for (uint32_t binding = BindTransforms; binding <= BindOccludedEarly; ++binding)
+    {
+        bindings.push_back({binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute});
+    }
+    bindings.push_back({BindUniforms, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute});
+    bindings.push_back({BindHiZ, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute});
+
+    m_descriptors =
+        std::make_unique<DescriptorSet>(m_renderer.device(), m_renderer.descriptorPool(), m_frames.size(), bindings);
+
+    m_pipeline = Pipeline::Builder(m_renderer.device())
+                     .setComputeShader(shaderPath)
+                     .setDescriptorSetLayouts({m_descriptors->getLayout()})
+                     .addPushContantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t))
+                     .build();
+}
+
+bool GpuCulling::reserve(std::unique_ptr<Buffer>& buffer,
+                         vk::DeviceSize bytes,
+                         vk::BufferUsageFlags usage,
+                         MemoryPlacement placement,
+                         const char* name)
+{
+    bytes = std::max(bytes, kMinBufferSize);
+    if (buffer && buffer->size() >= bytes)
+    {
+        return false;
+    }
+
+    // Grow by half again so a slowly growing scene does not reallocate every frame
+    m_frameManager.retire(std::move(buffer));
+    buffer = std::make_unique<Buffer>(m_renderer.allocator(), bytes + bytes / 2, usage, placement, name);
+    return true;
+}
+
+uint32_t GpuCulling::drawFor(const Mesh* mesh, uint32_t users)
+{
+    auto [it, inserted] = m_drawOf.try_emplace(mesh, static_cast<uint32_t>(m_drawMeshes.size()));
+    if (inserted)
+    {
+        m_drawMeshes.push_back(mesh);
+        m_drawCapacity.push_back(0);
+    }
+    // Every user of a mesh source may land on any of its levels
+    m_drawCapacity[it->second] += users;
+    return it->second;
+}
+
+void GpuCulling::readLodRequests(const SceneStore& scene, FrameResources& frame)
+{
+    // This slot's fence has signalled, so the levels its culling pass wanted are readable
+    if (!frame.lodRequests || frame.requestCount == 0)
+    {
+        return;
+    }
+
+    frame.lodRequests->invalidate();
+    const auto* wanted = static_cast<const uint32_t*>(frame.lodRequests->mappedData());
+    const size_t count = std::min(frame.requestCount, scene.meshSourceCount());
+    for (MeshId mesh = 0; mesh < count; ++mesh)
+    {
+        const MeshSource& source = scene.meshSource(mesh);
+        if (wanted[mesh] != kNone && source.lod && source.users > 0)
+        {
+            source.lod->want(wanted[mesh]);
+        }
+    }
+}
+
+void GpuCulling::readDrawCounts(const FrameResources& frame)
+{
+    // This slot's fence has signalled, so the instance counts its culling pass left are readable
+    if (!frame.draws || frame.drawMeshes.empty())
+    {
+        return;
+    }
+
+    frame.draws->invalidate();
+    const auto* commands = static_cast<const vk::DrawIndexedIndirectCommand*>(frame.draws->mappedData());
+    const auto drawCount = static_cast<uint32_t>(frame.drawMeshes.size());
+    for (uint32_t draw = 0; draw < drawCount; ++draw)
+    {
+        uint32_t peak = 0;
+        for (uint32_t view = 0; view < kViewCount; ++view)
+        {
+            peak = std::max(peak, commands[view * drawCount + draw].instanceCount);
+        }
+
+        // A full range may have turned entities away, so it doubles; otherwise it follows the count
+        const uint32_t capacity = frame.drawCapacity[draw];
+        m_instanceBudget[frame.drawMeshes[draw]] =
+            peak >= capacity ? std::max(capacity * 2, kInitialInstanceBudget)
+                             : std::max(peak + peak / 2, kInitialInstanceBudget);
+    }
+}
+
+void GpuCulling::buildDrawTable(const SceneStore& scene, const Mesh* placeholder, FrameResources& frame)
+{
+    m_drawOf.clear();
+    m_drawMeshes.clear();
+    m_drawCapacity.clear();
+
+    const size_t meshCount = scene.meshSourceCount();
+    std::vector<GpuMeshInfo> meshes(meshCount);
+    std::vector<GpuLevelInfo> levels;
+    for (MeshId mesh = 0; mesh < meshCount; ++mesh)
+    {
+        const MeshSource& source = scene.meshSource(mesh);
+        GpuMeshInfo& info = meshes[mesh];
+        info = {static_cast<uint32_t>(levels.size()), 0, source.localBounds.radius, kNone};
+        if (source.users == 0)
+        {
+            continue;
+        }
+
+        bool anyReady = false;
+        bool failed = false;
+        if (source.lod)
+        {
+            info.levelCount = source.lod->levelCount();
+            for (uint32_t level = 0; level < info.levelCount; ++level)
+            {
+                const Mesh* levelMesh = source.lod->levelMesh(level);
+                levels.push_back({source.lod->levelError(level), levelMesh ? drawFor(levelMesh, source.users) : kNone});
+                anyReady |= levelMesh != nullptr;
+            }
+            failed = source.lod->hasFailed();
+        }
+        else if (const Mesh* handleMesh = source.handle.get())
+        {
+            info.levelCount = 1;
+            levels.push_back({0.0f, drawFor(handleMesh, source.users)});
+            anyReady = true;
+        }
+        else
+        {
+            failed = source.handle.hasFailed();
+        }
+
+        if (!anyReady && !failed && placeholder)
+        {
+            info.fallbackDraw = drawFor(placeholder, source.users);
+        }
+    }
+
+    auto& descriptorsDirty = frame.descriptorsDirty;
+    constexpr auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+    descriptorsDirty |= reserve(frame.meshes, meshes.size() * sizeof(GpuMeshInfo), storage, MemoryPlacement::Dynamic, "Cull Meshes");
+    descriptorsDirty |= reserve(frame.levels, levels.size() * sizeof(GpuLevelInfo), storage, MemoryPlacement::Dynamic, "Cull Levels");
+    write(*frame.meshes, meshes.data(), meshes.size() * sizeof(GpuMeshInfo));
+    write(*frame.levels, levels.data(), levels.size() * sizeof(GpuLevelInfo));
+
+    // Each view gets its own copy of every draw. A range never needs more than the mesh's users,
+    // and usually far less: each entity lands on only one of its levels.
+    const auto drawCount = static_cast<uint32_t>(m_drawMeshes.size());
+    for (uint32_t draw = 0; draw < drawCount; ++draw)
+    {
+        const auto budget = m_instanceBudget.find(m_drawMeshes[draw]);
+        const uint32_t limit = budget != m_instanceBudget.end() ? budget->second : kInitialInstanceBudget;
+        m_drawCapacity[draw] = std::min(m_drawCapacity[draw], limit);
+    }
+    std::erase_if(m_instanceBudget, [this](const auto& entry) { return !m_drawOf.contains(entry.first); });
+
+    descriptorsDirty |= reserve(frame.draws,
+                                kViewCount * drawCount * sizeof(vk::DrawIndexedIndirectCommand),
+                                storage | vk::BufferUsageFlagBits::eIndirectBuffer,
+                                MemoryPlacement::Dynamic,
+                                "Cull Draws");
+    auto* commands = static_cast<vk::DrawIndexedIndirectCommand*>(frame.draws->mappedData());
+    uint32_t firstInstance = 0;
+    for (uint32_t view = 0; view < kViewCount; ++view)
+    {
+        for (uint32_t draw = 0; draw < drawCount; ++draw)
+        {
+            commands[view * drawCount + draw] = {m_drawMeshes[draw]->getIndexCount(), 0, 0, 0, firstInstance};
+            firstInstance += m_drawCapacity[draw];
+        }
+    }
+    frame.draws->flush(0, kViewCount * drawCount * sizeof(vk::DrawIndexedIndirectCommand));
+
+    if (reserve(frame.instances,
+                static_cast<vk::DeviceSize>(firstInstance) * sizeof(InstanceTransform),
+                storage | vk::BufferUsageFlagBits::eVertexBuffer,
+                MemoryPlacement::GpuOnly,
+                "Cull Instances"))
+    {
+        // The defragmenter may move it; rebind before this slot records again
+        frame.instances->addRelocationCallback([&frame](const Buffer&) { frame.descriptorsDirty = true; });
+        descriptorsDirty = true;
+    }
+
+    // Requests start at "none" and the culling pass lowers them to the finest level it wanted
+    descriptorsDirty |= reserve(frame.lodRequests, meshCount * sizeof(uint32_t), storage, MemoryPlacement::Readback, "Cull LOD Requests");
+    std::memset(frame.lodRequests->mappedData(), 0xFF, meshCount * sizeof(uint32_t));
+    frame.lodRequests->flush(0, meshCount * sizeof(uint32_t));
+    frame.requestCount = meshCount;
+
+    frame.drawMeshes = m_drawMeshes;
+    frame.drawCapacity = m_drawCapacity;
+    frame.instanceCapacity = firstInstance;
+}
+
+void GpuCulling::uploadScene(const SceneStore& scene, FrameResources& frame)
+{
+    const size_t count = scene.size();
+    frame.objectCount = static_cast<uint32_t>(count);
+
+    auto upload = [&](std::unique_ptr<Buffer>& buffer, const void* data, size_t bytes, const char* name) {
+        frame.descriptorsDirty |=
+            reserve(buffer, bytes, vk::BufferUsageFlagBits::eStorageBuffer, MemoryPlacement::Dynamic, name);
+        write(*buffer, data, bytes);
+    };
+
+    // The scene is already laid out as one array per field, so each is a single copy
+    const BoundsArrays& bounds = scene.bounds();
+    upload(frame.transforms, scene.transforms().data(), count * sizeof(glm::mat4), "Cull Transforms");
+    upload(frame.spheres[0], bounds.x.data(), count * sizeof(float), "Cull Sphere X");
+    upload(frame.spheres[1], bounds.y.data(), count * sizeof(float), "Cull Sphere Y");
+    upload(frame.spheres[2], bounds.z.data(), count * sizeof(float), "Cull Sphere Z");
+    upload(frame.spheres[3], bounds.radius.data(), count * sizeof(float), "Cull Sphere Radius");
+    upload(frame.meshIds, scene.meshes().data(), count * sizeof(MeshId), "Cull Mesh Ids");
+    upload(frame.flags, scene.flags().data(), count * sizeof(uint32_t), "Cull Flags");
+
+    // Written by the early camera phase and read by the late one, so it never leaves the GPU
+    if (reserve(frame.occludedEarly,
+                count * sizeof(uint32_t),
+                vk::BufferUsageFlagBits::eStorageBuffer,
+                MemoryPlacement::GpuOnly,
+                "Cull Occluded Early"))
+    {
+        frame.occludedEarly->addRelocationCallback([&frame](const Buffer&) { frame.descriptorsDirty = true; });
+        frame.descriptorsDirty = true;
+    }
+}
+
+void GpuCulling::updateDescriptors(FrameResources& frame, size_t frameIndex)
+{
+    const std::array<const Buffer*, BindUniforms + 1> buffers = {frame.transforms.get(),
+                                                                 frame.spheres[0].get(),
+                                                                 frame.spheres[1].get(),
+                                                                 frame.spheres[2].get(),
+                                                                 frame.spheres[3].get(),
+                                                                 frame.meshIds.get(),
+                                                                 frame.flags.get(),
+                                                                 frame.meshes.get(),
+                                                                 frame.levels.get(),
+                                                                 frame.draws.get(),
+                                                                 frame.instances.get(),
+                                                                 frame.lodRequests.get(),
+                                                                 frame.occludedEarly.get(),
+                                                                 frame.uniforms.get()};
+
+    std::array<vk::DescriptorBufferInfo, BindUniforms + 1> infos;
+    std::vector<vk::WriteDescriptorSet> writes;
+    for (uint32_t binding = 0; binding < buffers.size(); ++binding)
+    {
+        infos[binding] = vk::DescriptorBufferInfo(buffers[binding]->getHandle(), 0, VK_WHOLE_SIZE);
+
+        vk::WriteDescriptorSet descriptorWrite{};
+        descriptorWrite.dstSet = m_descriptors->get(frameIndex);
+        descriptorWrite.dstBinding = binding;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType =
+            binding == BindUniforms ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+        descriptorWrite.pBufferInfo = &infos[binding];
+        writes.push_back(descriptorWrite);
+    }
+
+    const vk::DescriptorImageInfo hiZInfo(m_hiZ.sampler(), m_hiZ.view(), vk::ImageLayout::eGeneral);
+    writes.push_back(
+        vk::WriteDescriptorSet(m_descriptors->get(frameIndex), BindHiZ, 0, vk::DescriptorType::eCombinedImageSampler, hiZInfo));
+
+    m_descriptors->updateSet(writes);
+    frame.boundPyramid = m_hiZ.view();
+    frame.descriptorsDirty = false;
+}
+
+void GpuCulling::update(const SceneStore& scene, const Mesh* placeholder, const CullParams& params, size_t frameIndex)
+{
+    FrameResources& frame = m_frames[frameIndex];
+
+    readLodRequests(scene, frame);
+    readDrawCounts(frame);
+    buildDrawTable(scene, placeholder, frame);
+    uploadScene(scene, frame);
+
+    // The late phase culls the camera again, so it shares the camera's planes
+    constexpr std::array<CullView, kViewCount> planeSource = {CullView::Camera, CullView::Shadow, CullView::Camera};
+    CullUniforms uniforms{};
+    for (uint32_t view = 0; view < kViewCount; ++view)
+    {
+        const Frustum& frustum = params.frusta[static_cast<uint32_t>(planeSource[view])];
+        std::copy(frustum.planes.begin(), frustum.planes.end(), uniforms.planes + view * 6);
+    }
+    uniforms.viewProjection = params.viewProjection;
+    uniforms.occluderViewProjection = m_occluderViewProjection;
+    uniforms.eye = glm::vec4(params.eye, params.pixelsPerUnitAtOne);
+    uniforms.hiZ = glm::vec4(static_cast<float>(m_hiZ.baseExtent().width),
+                             static_cast<float>(m_hiZ.baseExtent().height),
+                             static_cast<float>(m_hiZ.levelCount()),
+                             m_hiZ.valid() ? 1.0f : 0.0f);
+    uniforms.maxPixelError = params.maxPixelError;
+    uniforms.objectCount = frame.objectCount;
+    uniforms.drawCount = static_cast<uint32_t>(frame.drawMeshes.size());
+    uniforms.instanceCapacity = frame.instanceCapacity;
+    write(*frame.uniforms, &uniforms, sizeof(uniforms));
+
+    // This frame's early draws become the occluders the next frame tests against
+    m_occluderViewProjection = params.viewProjection;
+
+    if (frame.descriptorsDirty || frame.boundPyramid != m_hiZ.view())
+    {
+        updateDescriptors(frame, frameIndex);
+    }
+}
+
+void GpuCulling::bindPipeline(vk::CommandBuffer cmd, size_t frameIndex) const
+{
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline->get());
+    const vk::DescriptorSet set = m_descriptors->get(frameIndex);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline->getLayout(), 0, set, nullptr);
+}
+
+void GpuCulling::finishDispatch(vk::CommandBuffer cmd)
+{
+    // Draw counts and instances feed the passes; LOD requests are read on the host once the
+    // frame's fence signals
+    const vk::MemoryBarrier drawBarrier(vk::AccessFlagBits::eShaderWrite,
+                                        vk::AccessFlagBits::eIndirectCommandRead
+                                            | vk::AccessFlagBits::eVertexAttributeRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+                        {},
+                        drawBarrier,
+                        nullptr,
+                        nullptr);
+    const vk::MemoryBarrier hostBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eHostRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eHost,
+                        {},
+                        hostBarrier,
+                        nullptr,
+                        nullptr);
+}
+
+void GpuCulling::dispatch(vk::CommandBuffer cmd, size_t frameIndex)
+{
+    const FrameResources& frame = m_frames[frameIndex];
+    if (frame.objectCount == 0 || frame.drawMeshes.empty())
+    {
+        return;
+    }
+
+    bindPipeline(cmd, frameIndex);
+    const uint32_t groups = (frame.objectCount + kWorkgroupSize - 1) / kWorkgroupSize;
+    for (const CullView view : {CullView::Camera, CullView::Shadow})
+    {
+        cmd.pushConstants(m_pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(view), &view);
+        cmd.dispatch(groups, 1, 1);
+    }
+    finishDispatch(cmd);
+}
+
+void GpuCulling::dispatchLate(vk::CommandBuffer cmd, size_t frameIndex)
+{
+    const FrameResources& frame = m_frames[frameIndex];
+    if (frame.objectCount == 0 || frame.drawMeshes.empty())
+    {
+        return;
+    }
+
+    // The early phase's occlusion results and LOD requests are read and updated again
+    const vk::MemoryBarrier earlyBarrier(vk::AccessFlagBits::eShaderWrite,
+                                         vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        {},
+                        earlyBarrier,
+                        nullptr,
+                        nullptr);
+
+    bindPipeline(cmd, frameIndex);
+    const CullView view = CullView::CameraLate;
+    cmd.pushConstants(m_pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(view), &view);
+    cmd.dispatch((frame.objectCount + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1);
+    finishDispatch(cmd);
+}
+
+void GpuCulling::draw(vk::CommandBuffer cmd, size_t frameIndex, CullView view) const
+{
+    const FrameResources& frame = m_frames[frameIndex];
+    if (frame.drawMeshes.empty())
+    {
+        return;
+    }
+
+    const vk::DeviceSize offset = 0;
+    const vk::Buffer instanceBuffer = frame.instances->getHandle();
+    cmd.bindVertexBuffers(1, 1, &instanceBuffer, &offset);
+
+    // Draws the culling pass left empty cost a bind and a zero-instance draw each
+    const auto drawCount = static_cast<uint32_t>(frame.drawMeshes.size());
+    const uint32_t firstCommand = static_cast<uint32_t>(view) * drawCount;
+    for (uint32_t draw = 0; draw < drawCount; ++draw)
+    {
+        const Mesh* mesh = frame.drawMeshes[draw];
+        const vk::Buffer vertexBuffer = mesh->getVertexBuffer();
+        cmd.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+        cmd.bindIndexBuffer(mesh->getIndexBuffer(), 0, vk::IndexType::eUint32);
+        cmd.drawIndexedIndirect(frame.draws->getHandle(),
+                                (firstCommand + draw) * sizeof(vk::DrawIndexedIndirectCommand),
+                                1,
+                                sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "../core/Frustum.hpp"
+#include "Buffer.hpp"
+#include "DescriptorSet.hpp"
+#include "HiZPyramid.hpp"
+#include "Mesh.hpp"
+#include "Pipeline.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace reactor
+{
+
+class FrameManager;
+class SceneStore;
+class VulkanRenderer;
+
+// Views the culling pass writes draws for, in dispatch order.
+enum class CullView : uint32_t
+{
+    Camera = 0,     // visible against the previous frame's depth pyramid
+    Shadow = 1,
+    CameraLate = 2, // hidden by the previous frame's pyramid but not by this frame's
+};
+
+struct CullParams
+{
+    glm::mat4 viewProjection{1.0f}; // camera
+    std::array<Frustum, 2> frusta;  // camera and shadow
+    // LOD is chosen from the camera for every view, so an entity keeps its level across passes
+    glm::vec3 eye{0.0f};
+    float pixelsPerUnitAtOne = 1.0f; // pixels one world unit covers at distance 1
+    float maxPixelError = 1.0f;
+};
+
+// GPU-driven culling and submission. Entity transforms and bounds are copied into storage buffers
+// every frame; a compute pass then culls them against each view, picks a LOD level per entity and
+// appends its transform to that level's instance range, bumping the instance count of the level's
+// indirect draw. Recording a pass costs one indirect draw per resident mesh no matter how many
+// entities use it. Levels the GPU wanted but found missing are read back a few frames later and
+// requested from their LodMesh, which keeps streaming driven by what is actually on screen.
+//
+// The camera is also occlusion culled in two phases. dispatch() tests it against the depth pyramid
+// left by the previous frame; the renderer then draws the survivors into depth, rebuilds the
+// pyramid from that and calls dispatchLate(), which re-tests only what the first phase hid. The
+// late draws complete the depth buffer before the main pass draws both sets.
+//
+// Instance ranges start at each draw's firstInstance, so the device needs drawIndirectFirstInstance.
+// A range holds at most as many instances as the draw's mesh has users, but is sized from how many
+// the draw actually received when its frame slot last ran, with headroom: reserving every user on
+// every level would cost users * levels * views instances. An entity that finds its range full is
+// skipped for that frame; a draw that filled its range has its budget doubled, so a level that
+// suddenly gains many entities catches up within a few frames.
+class GpuCulling
+{
+public:
+    GpuCulling(VulkanRenderer& renderer, FrameManager& frameManager, HiZPyramid& hiZ, const std::string& shaderPath);
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // Consumes the LOD requests this frame slot produced last time, then uploads the scene and
+    // builds the draw table. Call once per frame after the scene's transforms and bounds are
+    // current; placeholder stands in for meshes still loading.
+    void update(const SceneStore& scene, const Mesh* placeholder, const CullParams& params, size_t frameIndex);
+
+    // Records the camera and shadow culling dispatches and the barriers that make their output
+    // visible to indirect draws and vertex input. Must be outside a render pass.
+    void dispatch(vk::CommandBuffer cmd, size_t frameIndex);
+
+    // Records the late camera phase, after the pyramid has been rebuilt from this frame's early
+    // camera draws.
+    void dispatchLate(vk::CommandBuffer cmd, size_t frameIndex);
+
+    // Records the draws of one view into the current render pass; the graphics pipeline and its
+    // descriptor sets must already be bound.
+    void draw(vk::CommandBuffer cmd, size_t frameIndex, CullView view) const;
+
+private:
+    static constexpr uint32_t kViewCount = 3;
+
+    struct FrameResources
+    {
+        // Scene arrays, dense entity order
+        std::unique_ptr<Buffer> transforms;
+        std::array<std::unique_ptr<Buffer>, 4> spheres; // x, y, z, radius
+        std::unique_ptr<Buffer> meshIds;
+        std::unique_ptr<Buffer> flags;
+        // Draw table
+        std::unique_ptr<Buffer> meshes;
+        std::unique_ptr<Buffer> levels;
+        std::unique_ptr<Buffer> draws; // kViewCount * drawCount commands
+        std::unique_ptr<Buffer> instances;
+        std::unique_ptr<Buffer> lodRequests;   // per MeshId, read back
+        std::unique_ptr<Buffer> occludedEarly; // per entity, early phase to late phase
+        std::unique_ptr<Buffer> uniforms;
+        vk::ImageView boundPyramid; // pyramid view the descriptors point at
+
+        size_t requestCount = 0; // MeshIds lodRequests was cleared for
+        uint32_t objectCount = 0;
+        uint32_t instanceCapacity = 0; // instances across every view's ranges
+        std::vector<const Mesh*> drawMeshes; // indexed by draw
+        std::vector<uint32_t> drawCapacity;  // instances per view, indexed by draw
+        bool descriptorsDirty = true;
+    };
+
+    void createPipeline(const std::string& shaderPath);
+    void readLodRequests(const SceneStore& scene, FrameResources& frame);
+    void readDrawCounts(const FrameResources& frame);
+    void buildDrawTable(const SceneStore& scene, const Mesh* placeholder, FrameResources& frame);
+    void uploadScene(const SceneStore& scene, FrameResources& frame);
+    void updateDescriptors(FrameResources& frame, size_t frameIndex);
+    void bindPipeline(vk::CommandBuffer cmd, size_t frameIndex) const;
+    static void finishDispatch(vk::CommandBuffer cmd);
+
+    // Grows buffer to hold at least bytes, retiring the old one. Returns true when it was replaced.
+    bool reserve(std::unique_ptr<Buffer>& buffer,
+                 vk::DeviceSize bytes,
+                 vk::BufferUsageFlags usage,
+                 MemoryPlacement placement,
+                 const char* name);
+    uint32_t drawFor(const Mesh* mesh, uint32_t users);
+
+    VulkanRenderer& m_renderer;
+    FrameManager& m_frameManager;
+    HiZPyramid& m_hiZ;
+    glm::mat4 m_occluderViewProjection{1.0f}; // camera the pyramid was last built from
+    std::vector<FrameResources> m_frames;
+    std::unique_ptr<DescriptorSet> m_descriptors;
+    std::unique_ptr<Pipeline> m_pipeline;
+
+    // Scratch for building the draw table
+    std::unordered_map<const Mesh*, uint32_t> m_drawOf;
+    std::vector<const Mesh*> m_drawMeshes;
+    std::vector<uint32_t> m_drawCapacity;
+
+    // Instances per view each mesh's draw is given, learned from the counts read back
+    std::unordered_map<const Mesh*, uint32_t> m_instanceBudget;
+};
+
+} // namespace reactor
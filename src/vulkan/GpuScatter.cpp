@@ -0,0 +1,601 @@
+#include "GpuScatter.hpp"
+
+#include "../core/AssetManager.hpp"
+#include "../core/LodMesh.hpp"
+#include "FrameManager.hpp"
+#include "TerrainRenderer.hpp"
+#include "Vertex.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+constexpr uint32_t kWorkgroupSize = 8; // local_size_x and local_size_y in scatter.comp
+constexpr vk::DeviceSize kMinBufferSize = 256;
+// Instance range of each indirect draw. Instances past it are dropped, so a layer's spacing and
+// maxDistance should keep what one view sees of it below this
+constexpr uint32_t kMaxInstancesPerDraw = 16384;
+
+// Layouts shared with scatter.comp
+struct GpuScatterLayer
+{
+    glm::vec4 area;   // world XZ of the density map's corner, its size, cell spacing
+    glm::vec4 shape;  // min and max scale, max distance, local bounds radius
+    glm::vec4 center; // local bounds centre
+    glm::uvec4 cells; // first cell XZ of this frame's window, cells per side of it
+    glm::uvec4 draws; // first command, level count, instances per command, seed
+    glm::vec4 errors[GpuScatter::kMaxLevels / 4];
+    glm::uvec4 levels[GpuScatter::kMaxLevels / 4]; // resident level drawn in place of each one
+};
+
+struct ScatterUniforms
+{
+    glm::vec4 planes[12]; // six per view, camera then shadow
+    glm::vec4 eye;        // w: pixels per unit at distance 1
+    glm::vec4 terrain;    // tile size (zero for flat ground), height of sample 0 or of the flat ground,
+                          // height per step, last sample index
+    glm::ivec4 tiles;     // first tile XZ and tiles per side of the slot table
+    float maxPixelError;
+    uint32_t pad[3];
+    GpuScatterLayer layers[GpuScatter::kMaxLayers];
+};
+
+enum Binding : uint32_t
+{
+    BindDraws = 0,
+    BindInstances = 1,
+    BindTiles = 2,
+    BindUniforms = 3,
+    BindHeights = 4,
+};
+
+// Fills a mapped host-visible buffer and makes the write visible to the device
+void write(Buffer& buffer, const void* data, size_t bytes)
+{
+    if (bytes > 0)
+    {
+        std::memcpy(buffer.mappedData(), data, bytes);
+        buffer.flush(0, bytes);
+    }
+}
+} // namespace
+
+GpuScatter::GpuScatter(VulkanRenderer& renderer,
+                       FrameManager& frameManager,
+                       AssetManager& assetManager,
+                       const TerrainRenderer* terrain,
+                       float groundHeight,
+                       const std::string& directory,
+                       const std::string& shaderPath)
+    : m_renderer(renderer), m_frameManager(frameManager), m_terrain(terrain), m_groundHeight(groundHeight)
+{
+    for (ScatterLayer& source : loadScatterLayers(directory))
+    {
+        if (m_layers.size() == kMaxLayers)
+        {
+            spdlog::warn("More than {} scatter layers in {}; ignoring the rest", kMaxLayers, directory);
+            break;
+        }
+        Layer layer;
+        layer.mesh = assetManager.acquireLodMesh(source.meshPath, source.meshIndex);
+        layer.source = std::move(source);
+        m_layers.push_back(std::move(layer));
+    }
+    if (m_layers.empty())
+    {
+        return;
+    }
+    spdlog::info("Scatter: {} layers in {}", m_layers.size(), directory);
+
+    // Density is interpolated between samples, so cells finer than the map still vary smoothly
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.magFilter = vk::Filter::eLinear;
+    samplerInfo.minFilter = vk::Filter::eLinear;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    m_densitySampler = m_renderer.device().createSampler(samplerInfo);
+
+    for (Layer& layer : m_layers)
+    {
+        const uint32_t resolution = layer.source.densityResolution;
+        vk::ImageCreateInfo imageInfo{};
+        imageInfo.imageType = vk::ImageType::e2D;
+        imageInfo.format = vk::Format::eR8Unorm;
+        imageInfo.extent = vk::Extent3D{resolution, resolution, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = vk::SampleCountFlagBits::e1;
+        imageInfo.tiling = vk::ImageTiling::eOptimal;
+        imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+        imageInfo.sharingMode = vk::SharingMode::eExclusive;
+        imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+        layer.density = std::make_unique<Image>(m_renderer.allocator(), imageInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+
+        vk::ImageViewCreateInfo viewInfo{};
+        viewInfo.image = layer.density->get();
+        viewInfo.viewType = vk::ImageViewType::e2D;
+        viewInfo.format = vk::Format::eR8Unorm;
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+        layer.densityView = m_renderer.device().createImageView(viewInfo);
+    }
+
+    if (!m_terrain)
+    {
+        createFlatGround();
+    }
+
+    m_frames.resize(m_frameManager.getFramesInFlightCount());
+    for (auto& frame : m_frames)
+    {
+        frame.uniforms = std::make_unique<Buffer>(m_renderer.allocator(),
+                                                  sizeof(ScatterUniforms),
+                                                  vk::BufferUsageFlagBits::eUniformBuffer,
+                                                  MemoryPlacement::Dynamic,
+                                                  "Scatter Uniforms");
+    }
+    createPipeline(shaderPath);
+}
+
+GpuScatter::~GpuScatter()
+{
+    auto device = m_renderer.device();
+    for (const Layer& layer : m_layers)
+    {
+        if (layer.densityView)
+        {
+            device.destroyImageView(layer.densityView);
+        }
+    }
+    if (m_flatHeightsView)
+    {
+        device.destroyImageView(m_flatHeightsView);
+    }
+    if (m_flatHeightsSampler)
+    {
+        device.destroySampler(m_flatHeightsSampler);
+    }
+    if (m_densitySampler)
+    {
+        device.destroySampler(m_densitySampler);
+    }
+}
+
+void GpuScatter::createFlatGround()
+{
+    // scatter.comp never reads it with no tile size set, but the binding must still be valid
+    vk::ImageCreateInfo imageInfo{};
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = vk::Format::eR16Uint;
+    imageInfo.extent = vk::Extent3D{1, 1, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    m_flatHeights = std::make_unique<Image>(m_renderer.allocator(), imageInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    vk::ImageViewCreateInfo viewInfo{};
+    viewInfo.image = m_flatHeights->get();
+    viewInfo.viewType = vk::ImageViewType::e2DArray;
+    viewInfo.format = vk::Format::eR16Uint;
+    viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    m_flatHeightsView = m_renderer.device().createImageView(viewInfo);
+
+    // Integer formats cannot be filtered
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.magFilter = vk::Filter::eNearest;
+    samplerInfo.minFilter = vk::Filter::eNearest;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    m_flatHeightsSampler = m_renderer.device().createSampler(samplerInfo);
+}
+
+void GpuScatter::createPipeline(const std::string& shaderPath)
+{
+    spdlog::info("Creating scatter pipeline");
+
+    const std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        {BindDraws, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+        {BindInstances, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+        {BindTiles, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+        {BindUniforms, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+        {BindHeights, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute},
+    };
+    m_descriptors =
+        std::make_unique<DescriptorSet>(m_renderer.device(), m_renderer.descriptorPool(), m_frames.size(), bindings);
+
+    const std::vector<vk::DescriptorSetLayoutBinding> layerBindings = {
+        {0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute},
+    };
+    m_layerDescriptors = std::make_unique<DescriptorSet>(
+        m_renderer.device(), m_renderer.descriptorPool(), m_layers.size(), layerBindings);
+    std::vector<vk::DescriptorImageInfo> densityInfos;
+    densityInfos.reserve(m_layers.size());
+    std::vector<vk::WriteDescriptorSet> writes;
+    for (uint32_t i = 0; i < m_layers.size(); ++i)
+    {
+        densityInfos.emplace_back(m_densitySampler, m_layers[i].densityView, vk::ImageLayout::eShaderReadOnlyOptimal);
+        writes.emplace_back(
+            m_layerDescriptors->get(i), 0, 0, vk::DescriptorType::eCombinedImageSampler, densityInfos.back());
+    }
+    m_layerDescriptors->updateSet(writes);
+
+    m_pipeline = Pipeline::Builder(m_renderer.device())
+                     .setComputeShader(shaderPath)
+                     .setDescriptorSetLayouts({m_descriptors->getLayout(), m_layerDescriptors->getLayout()})
+                     .addPushContantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t))
+                     .build();
+}
+
+bool GpuScatter::reserve(std::unique_ptr<Buffer>& buffer,
+                         vk::DeviceSize bytes,
+                         vk::BufferUsageFlags usage,
+                         MemoryPlacement placement,
+                         const char* name)
+{
+    bytes = std::max(bytes, kMinBufferSize);
+    if (buffer && buffer->size() >= bytes)
+    {
+        return false;
+    }
+
+    m_frameManager.retire(std::move(buffer));
+    buffer = std::make_unique<Buffer>(m_renderer.allocator(), bytes + bytes / 2, usage, placement, name);
+    return true;
+}
+
+void GpuScatter::uploadMaps(vk::CommandBuffer cmd)
+{
+    size_t totalBytes = 0;
+    for (const Layer& layer : m_layers)
+    {
+        totalBytes += layer.source.density.size();
+    }
+    auto staging = std::make_unique<Buffer>(
+        m_renderer.allocator(), totalBytes, vk::BufferUsageFlagBits::eTransferSrc, MemoryPlacement::Staging, "Scatter Staging");
+    auto* bytes = static_cast<char*>(staging->mappedData());
+
+    const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    auto barrier = [&](vk::Image image,
+                       vk::AccessFlags srcAccess,
+                       vk::AccessFlags dstAccess,
+                       vk::ImageLayout from,
+                       vk::ImageLayout to) {
+        return vk::ImageMemoryBarrier(
+            srcAccess, dstAccess, from, to, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range);
+    };
+    std::vector<vk::ImageMemoryBarrier> toTransfer;
+    std::vector<vk::ImageMemoryBarrier> toShader;
+    for (const Layer& layer : m_layers)
+    {
+        toTransfer.push_back(barrier(layer.density->get(),
+                                     {},
+                                     vk::AccessFlagBits::eTransferWrite,
+                                     vk::ImageLayout::eUndefined,
+                                     vk::ImageLayout::eTransferDstOptimal));
+        toShader.push_back(barrier(layer.density->get(),
+                                   vk::AccessFlagBits::eTransferWrite,
+                                   vk::AccessFlagBits::eShaderRead,
+                                   vk::ImageLayout::eTransferDstOptimal,
+                                   vk::ImageLayout::eShaderReadOnlyOptimal));
+    }
+    if (m_flatHeights)
+    {
+        toTransfer.push_back(barrier(m_flatHeights->get(),
+                                     {},
+                                     vk::AccessFlagBits::eTransferWrite,
+                                     vk::ImageLayout::eUndefined,
+                                     vk::ImageLayout::eTransferDstOptimal));
+        toShader.push_back(barrier(m_flatHeights->get(),
+                                   vk::AccessFlagBits::eTransferWrite,
+                                   vk::AccessFlagBits::eShaderRead,
+                                   vk::ImageLayout::eTransferDstOptimal,
+                                   vk::ImageLayout::eShaderReadOnlyOptimal));
+    }
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransfer);
+
+    size_t offset = 0;
+    for (Layer& layer : m_layers)
+    {
+        const uint32_t resolution = layer.source.densityResolution;
+        memcpy(bytes + offset, layer.source.density.data(), layer.source.density.size());
+
+        vk::BufferImageCopy region{};
+        region.bufferOffset = offset;
+        region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+        region.imageExtent = vk::Extent3D{resolution, resolution, 1};
+        cmd.copyBufferToImage(staging->getHandle(), layer.density->get(), vk::ImageLayout::eTransferDstOptimal, region);
+
+        offset += layer.source.density.size();
+        // The GPU copy is the only one needed from here on
+        layer.source.density.clear();
+        layer.source.density.shrink_to_fit();
+    }
+    staging->flush();
+    if (m_flatHeights)
+    {
+        cmd.clearColorImage(m_flatHeights->get(),
+                            vk::ImageLayout::eTransferDstOptimal,
+                            vk::ClearColorValue(std::array<uint32_t, 4>{0, 0, 0, 0}),
+                            range);
+    }
+
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, toShader);
+    m_frameManager.retire(std::move(staging));
+    m_mapsUploaded = true;
+}
+
+void GpuScatter::updateDescriptors(FrameResources& frame, uint32_t frameIdx)
+{
+    const std::array<const Buffer*, BindUniforms + 1> buffers = {
+        frame.draws.get(), frame.instances.get(), frame.tiles.get(), frame.uniforms.get()};
+
+    std::array<vk::DescriptorBufferInfo, BindUniforms + 1> infos;
+    std::vector<vk::WriteDescriptorSet> writes;
+    for (uint32_t binding = 0; binding < buffers.size(); ++binding)
+    {
+        infos[binding] = vk::DescriptorBufferInfo(buffers[binding]->getHandle(), 0, VK_WHOLE_SIZE);
+
+        vk::WriteDescriptorSet descriptorWrite{};
+        descriptorWrite.dstSet = m_descriptors->get(frameIdx);
+        descriptorWrite.dstBinding = binding;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType =
+            binding == BindUniforms ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+        descriptorWrite.pBufferInfo = &infos[binding];
+        writes.push_back(descriptorWrite);
+    }
+
+    const vk::DescriptorImageInfo heightsInfo(m_terrain ? m_terrain->heightsSampler() : m_flatHeightsSampler,
+                                              m_terrain ? m_terrain->heightsView() : m_flatHeightsView,
+                                              vk::ImageLayout::eShaderReadOnlyOptimal);
+    writes.push_back(vk::WriteDescriptorSet(
+        m_descriptors->get(frameIdx), BindHeights, 0, vk::DescriptorType::eCombinedImageSampler, heightsInfo));
+
+    m_descriptors->updateSet(writes);
+    frame.descriptorsDirty = false;
+}
+
+void GpuScatter::dispatch(vk::CommandBuffer cmd, uint32_t frameIdx, const CullParams& params)
+{
+    FrameResources& frame = m_frames[frameIdx];
+    if (!m_mapsUploaded)
+    {
+        uploadMaps(cmd);
+    }
+
+    constexpr auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+    ScatterUniforms uniforms{};
+    for (uint32_t view = 0; view < kViewCount; ++view)
+    {
+        const Frustum& frustum = params.frusta[view];
+        std::copy(frustum.planes.begin(), frustum.planes.end(), uniforms.planes + view * 6);
+    }
+    uniforms.eye = glm::vec4(params.eye, params.pixelsPerUnitAtOne);
+    uniforms.maxPixelError = params.maxPixelError;
+
+    // Props stand on whatever terrain is resident; cells over tiles still streaming stay empty
+    m_tileSlots.clear();
+    uniforms.terrain = glm::vec4(0.0f, m_groundHeight, 0.0f, 0.0f);
+    if (m_terrain)
+    {
+        glm::ivec2 firstTile;
+        glm::uvec2 tileCount;
+        m_terrain->terrain().residentSlots(firstTile, tileCount, m_tileSlots);
+        const HeightTile& layout = m_terrain->terrain().layout();
+        uniforms.terrain = glm::vec4(layout.tileSize,
+                                     layout.minHeight,
+                                     (layout.maxHeight - layout.minHeight) / 65535.0f,
+                                     static_cast<float>(layout.resolution - 1));
+        uniforms.tiles = glm::ivec4(firstTile, glm::ivec2(tileCount));
+    }
+    frame.descriptorsDirty |=
+        reserve(frame.tiles, m_tileSlots.size() * sizeof(uint32_t), storage, MemoryPlacement::Dynamic, "Scatter Tiles");
+    write(*frame.tiles, m_tileSlots.data(), m_tileSlots.size() * sizeof(uint32_t));
+
+    // Only the cells whose props could be within maxDistance of the camera are dispatched
+    frame.layers.clear();
+    uint32_t commandCount = 0;
+    const glm::vec2 eye(params.eye.x, params.eye.z);
+    for (uint32_t index = 0; index < m_layers.size(); ++index)
+    {
+        const ScatterLayer& source = m_layers[index].source;
+        LodMesh& lod = *m_layers[index].mesh;
+        const uint32_t levelCount = std::min(lod.levelCount(), kMaxLevels);
+        if (levelCount == 0)
+        {
+            continue; // table of contents still loading, or failed
+        }
+
+        const float radius = lod.boundsRadius() * source.maxScale;
+        const float reach = source.maxDistance + radius + glm::length(lod.boundsCenter()) * source.maxScale;
+        const glm::vec2 lo = glm::max(source.origin, eye - reach);
+        const glm::vec2 hi = glm::min(source.origin + source.size, eye + reach);
+        if (lo.x >= hi.x || lo.y >= hi.y)
+        {
+            continue;
+        }
+        const auto cellsPerSide = static_cast<uint32_t>(std::ceil(source.size / source.spacing));
+        const glm::uvec2 firstCell(glm::floor((lo - source.origin) / source.spacing));
+        const glm::uvec2 lastCell = glm::min(glm::uvec2(glm::ceil((hi - source.origin) / source.spacing)),
+                                             glm::uvec2(cellsPerSide));
+        if (lastCell.x <= firstCell.x || lastCell.y <= firstCell.y)
+        {
+            continue;
+        }
+
+        // A level is wanted from the distance at which its error shrinks below maxPixelError,
+        // nearest for the smallest props. Levels starting beyond maxDistance are never drawn
+        LayerDraws draws;
+        draws.layer = index;
+        draws.firstCommand = commandCount;
+        draws.levelCount = levelCount;
+        draws.cellCount = lastCell - firstCell;
+        bool anyReady = false;
+        for (uint32_t level = 0; level < levelCount; ++level)
+        {
+            const float start =
+                lod.levelError(level) * params.pixelsPerUnitAtOne * source.minScale / params.maxPixelError;
+            if (start <= source.maxDistance)
+            {
+                lod.want(level);
+            }
+            draws.meshes[level] = lod.levelMesh(level);
+            anyReady |= draws.meshes[level] != nullptr;
+        }
+        if (!anyReady)
+        {
+            continue;
+        }
+
+        GpuScatterLayer& info = uniforms.layers[index];
+        info.area = glm::vec4(source.origin, source.size, source.spacing);
+        info.shape = glm::vec4(source.minScale, source.maxScale, source.maxDistance, lod.boundsRadius());
+        info.center = glm::vec4(lod.boundsCenter(), 0.0f);
+        info.cells = glm::uvec4(firstCell, draws.cellCount);
+        info.draws = glm::uvec4(commandCount,
+                                levelCount,
+                                std::min(draws.cellCount.x * draws.cellCount.y, kMaxInstancesPerDraw),
+                                source.seed);
+        for (uint32_t level = 0; level < levelCount; ++level)
+        {
+            info.errors[level / 4][level % 4] = lod.levelError(level);
+
+            // Same fallback order as LodMesh::want: the level itself, then finer, then coarser
+            uint32_t drawn = kNone;
+            for (uint32_t i = level + 1; i-- > 0 && drawn == kNone;)
+            {
+                drawn = draws.meshes[i] ? i : kNone;
+            }
+            for (uint32_t i = level + 1; i < levelCount && drawn == kNone; ++i)
+            {
+                drawn = draws.meshes[i] ? i : kNone;
+            }
+            info.levels[level / 4][level % 4] = drawn;
+        }
+
+        commandCount += kViewCount * levelCount;
+        frame.layers.push_back(draws);
+    }
+    write(*frame.uniforms, &uniforms, sizeof(uniforms));
+
+    // Counts start at zero every frame; the dispatch appends to them
+    frame.descriptorsDirty |= reserve(frame.draws,
+                                      commandCount * sizeof(vk::DrawIndexedIndirectCommand),
+                                      storage | vk::BufferUsageFlagBits::eIndirectBuffer,
+                                      MemoryPlacement::Dynamic,
+                                      "Scatter Draws");
+    auto* commands = static_cast<vk::DrawIndexedIndirectCommand*>(frame.draws->mappedData());
+    uint32_t firstInstance = 0;
+    for (const LayerDraws& draws : frame.layers)
+    {
+        const uint32_t capacity = uniforms.layers[draws.layer].draws.z;
+        for (uint32_t view = 0; view < kViewCount; ++view)
+        {
+            for (uint32_t level = 0; level < draws.levelCount; ++level)
+            {
+                const Mesh* mesh = draws.meshes[level];
+                commands[draws.firstCommand + view * draws.levelCount + level] = {
+                    mesh ? mesh->getIndexCount() : 0, 0, 0, 0, firstInstance};
+                firstInstance += mesh ? capacity : 0;
+            }
+        }
+    }
+    frame.draws->flush(0, commandCount * sizeof(vk::DrawIndexedIndirectCommand));
+
+    if (reserve(frame.instances,
+                static_cast<vk::DeviceSize>(firstInstance) * sizeof(InstanceTransform),
+                storage | vk::BufferUsageFlagBits::eVertexBuffer,
+                MemoryPlacement::GpuOnly,
+                "Scatter Instances"))
+    {
+        // The defragmenter may move it; rebind before this slot records again
+        frame.instances->addRelocationCallback([&frame](const Buffer&) { frame.descriptorsDirty = true; });
+        frame.descriptorsDirty = true;
+    }
+
+    if (frame.descriptorsDirty)
+    {
+        updateDescriptors(frame, frameIdx);
+    }
+    if (frame.layers.empty())
+    {
+        return;
+    }
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline->get());
+    const vk::DescriptorSet set = m_descriptors->get(frameIdx);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline->getLayout(), 0, set, nullptr);
+    for (const LayerDraws& draws : frame.layers)
+    {
+        const vk::DescriptorSet layerSet = m_layerDescriptors->get(draws.layer);
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline->getLayout(), 1, layerSet, nullptr);
+        cmd.pushConstants(
+            m_pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(draws.layer), &draws.layer);
+        cmd.dispatch((draws.cellCount.x + kWorkgroupSize - 1) / kWorkgroupSize,
+                     (draws.cellCount.y + kWorkgroupSize - 1) / kWorkgroupSize,
+                     1);
+    }
+
+    const vk::MemoryBarrier drawBarrier(vk::AccessFlagBits::eShaderWrite,
+                                        vk::AccessFlagBits::eIndirectCommandRead
+                                            | vk::AccessFlagBits::eVertexAttributeRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+                        {},
+                        drawBarrier,
+                        nullptr,
+                        nullptr);
+}
+
+void GpuScatter::draw(vk::CommandBuffer cmd, uint32_t frameIdx, CullView view) const
+{
+    const FrameResources& frame = m_frames[frameIdx];
+    if (frame.layers.empty())
+    {
+        return;
+    }
+
+    const vk::DeviceSize offset = 0;
+    const vk::Buffer instanceBuffer = frame.instances->getHandle();
+    cmd.bindVertexBuffers(1, 1, &instanceBuffer, &offset);
+
+    for (const LayerDraws& draws : frame.layers)
+    {
+        const uint32_t firstCommand = draws.firstCommand + static_cast<uint32_t>(view) * draws.levelCount;
+        for (uint32_t level = 0; level < draws.levelCount; ++level)
+        {
+            const Mesh* mesh = draws.meshes[level];
+            if (!mesh)
+            {
+                continue;
+            }
+            const vk::Buffer vertexBuffer = mesh->getVertexBuffer();
+            cmd.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
+            cmd.bindIndexBuffer(mesh->getIndexBuffer(), 0, vk::IndexType::eUint32);
+            cmd.drawIndexedIndirect(frame.draws->getHandle(),
+                                    (firstCommand + level) * sizeof(vk::DrawIndexedIndirectCommand),
+                                    1,
+                                    sizeof(vk::DrawIndexedIndirectCommand));
+        }
+    }
+}
+
+} // namespace reactor
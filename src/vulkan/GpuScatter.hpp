@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../core/Scatter.hpp"
+#include "Buffer.hpp"
+#include "DescriptorSet.hpp"
+#include "GpuCulling.hpp"
+#include "Image.hpp"
+#include "Mesh.hpp"
+#include "Pipeline.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+class AssetManager;
+class FrameManager;
+class LodMesh;
+class TerrainRenderer;
+class VulkanRenderer;
+
+// Procedural props placed entirely on the GPU (see Scatter.hpp). Each frame, one compute thread per
+// cell within reach of the camera decides from the cell's hash and the layer's density map whether
+// it holds an instance, sets it on the terrain, culls it against the camera and shadow views, picks
+// its LOD level and appends its transform to that level's indirect draw. Instances never exist on
+// the host: the CPU only sizes the draw table, keeps the levels the camera can need resident and
+// records one indirect draw per view and level. Each draw's instances start at its firstInstance,
+// so the device needs drawIndirectFirstInstance. Render thread only.
+class GpuScatter
+{
+public:
+    static constexpr uint32_t kMaxLayers = 8;
+    static constexpr uint32_t kMaxLevels = 8;
+
+    // Layers are the .scatter files in directory. terrain, when given, is sampled for the ground
+    // height; without it props stand on flat ground at groundHeight.
+    GpuScatter(VulkanRenderer& renderer,
+               FrameManager& frameManager,
+               AssetManager& assetManager,
+               const TerrainRenderer* terrain,
+               float groundHeight,
+               const std::string& directory,
+               const std::string& shaderPath);
+    ~GpuScatter();
+
+    GpuScatter(const GpuScatter&) = delete;
+    GpuScatter& operator=(const GpuScatter&) = delete;
+
+    // False when the directory held no usable layers; nothing else may be called then.
+    [[nodiscard]] bool valid() const
+    {
+        return !m_layers.empty();
+    }
+
+    // Builds this frame's draw table and records the scatter dispatch with the barriers that make
+    // its output visible to indirect draws and vertex input. Must be outside a render pass and
+    // after the terrain's update. params.frusta supplies the camera and shadow views.
+    void dispatch(vk::CommandBuffer cmd, uint32_t frameIdx, const CullParams& params);
+
+    // Records the instances of one view, CullView::Camera or CullView::Shadow, into the current
+    // render pass; a mesh pipeline and its descriptor sets must already be bound.
+    void draw(vk::CommandBuffer cmd, uint32_t frameIdx, CullView view) const;
+
+private:
+    static constexpr uint32_t kViewCount = 2;
+
+    struct Layer
+    {
+        ScatterLayer source; // density samples are dropped once uploaded
+        std::shared_ptr<LodMesh> mesh;
+        std::unique_ptr<Image> density;
+        vk::ImageView densityView;
+    };
+
+    // A layer dispatched this frame: its commands, view by view and level by level
+    struct LayerDraws
+    {
+        uint32_t layer = 0;
+        uint32_t firstCommand = 0;
+        uint32_t levelCount = 0;
+        glm::uvec2 cellCount{0};
+        std::array<const Mesh*, kMaxLevels> meshes{}; // null where the level is not resident
+    };
+
+    struct FrameResources
+    {
+        std::unique_ptr<Buffer> draws; // per layer, kViewCount * levelCount commands
+        std::unique_ptr<Buffer> instances;
+        std::unique_ptr<Buffer> tiles; // terrain slot per tile
+        std::unique_ptr<Buffer> uniforms;
+        std::vector<LayerDraws> layers;
+        bool descriptorsDirty = true;
+    };
+
+    void createPipeline(const std::string& shaderPath);
+    void createFlatGround();
+    void uploadMaps(vk::CommandBuffer cmd);
+    void updateDescriptors(FrameResources& frame, uint32_t frameIdx);
+
+    // Grows buffer to hold at least bytes, retiring the old one. Returns true when it was replaced.
+    bool reserve(std::unique_ptr<Buffer>& buffer,
+                 vk::DeviceSize bytes,
+                 vk::BufferUsageFlags usage,
+                 MemoryPlacement placement,
+                 const char* name);
+
+    VulkanRenderer& m_renderer;
+    FrameManager& m_frameManager;
+    const TerrainRenderer* m_terrain;
+    float m_groundHeight;
+    std::vector<Layer> m_layers;
+    std::vector<FrameResources> m_frames;
+    vk::Sampler m_densitySampler;
+    std::unique_ptr<DescriptorSet> m_descriptors;      // per frame
+    std::unique_ptr<DescriptorSet> m_layerDescriptors; // per layer, its density map
+    std::unique_ptr<Pipeline> m_pipeline;
+    bool m_mapsUploaded = false;
+
+    // Stands in for the terrain's heights when there is none
+    std::unique_ptr<Image> m_flatHeights;
+    vk::ImageView m_flatHeightsView;
+    vk::Sampler m_flatHeightsSampler;
+
+    // Scratch
+    std::vector<uint32_t> m_tileSlots;
+};
+
+} // namespace reactor
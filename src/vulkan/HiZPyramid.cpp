@@ -0,0 +1,246 @@
+#include "HiZPyramid.hpp"
+
+#include "FrameManager.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kTileSize = 32; // mip-0 texels per workgroup side in hiz.comp
+
+struct HiZPush
+{
+    int32_t depthSize[2];
+    int32_t baseSize[2];
+    int32_t levelCount;
+    int32_t sampleCount;
+    uint32_t groupCount;
+};
+} // namespace
+
+HiZPyramid::HiZPyramid(VulkanRenderer& renderer,
+                       FrameManager& frameManager,
+                       const std::string& shaderPath,
+                       vk::Extent2D depthExtent,
+                       uint32_t depthSamples)
+    : m_renderer(renderer), m_frameManager(frameManager), m_depthExtent(depthExtent), m_depthSamples(depthSamples)
+{
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.magFilter = vk::Filter::eNearest;
+    samplerInfo.minFilter = vk::Filter::eNearest;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    m_sampler = m_renderer.device().createSampler(samplerInfo);
+
+    m_counter = std::make_unique<Buffer>(m_renderer.allocator(),
+                                         sizeof(uint32_t),
+                                         vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                         MemoryPlacement::Dynamic,
+                                         "Hi-Z Counter");
+
+    const size_t framesInFlight = m_frameManager.getFramesInFlightCount();
+    m_boundDepth.resize(framesInFlight);
+    m_boundPyramid.resize(framesInFlight);
+
+    createPipeline(shaderPath);
+    createImage();
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    auto device = m_renderer.device();
+    for (auto view : m_levelViews)
+    {
+        device.destroyImageView(view);
+    }
+    device.destroyImageView(m_view);
+    device.destroySampler(m_sampler);
+}
+
+void HiZPyramid::createPipeline(const std::string& shaderPath)
+{
+    spdlog::info("Creating Hi-Z pyramid pipeline");
+
+    const std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        {0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute},
+        {1, vk::DescriptorType::eStorageImage, kMaxLevels, vk::ShaderStageFlagBits::eCompute},
+        {2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+    };
+    m_descriptors = std::make_unique<DescriptorSet>(
+        m_renderer.device(), m_renderer.descriptorPool(), m_frameManager.getFramesInFlightCount(), bindings);
+
+    m_pipeline = Pipeline::Builder(m_renderer.device())
+                     .setComputeShader(shaderPath)
+                     .setDescriptorSetLayouts({m_descriptors->getLayout()})
+                     .addPushContantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(HiZPush))
+                     .build();
+}
+
+void HiZPyramid::createImage()
+{
+    // Largest power of two that fits, so every mip-0 texel covers at least one depth texel
+    const uint32_t maxBase = 1u << (kMaxLevels - 1);
+    m_baseExtent = vk::Extent2D{std::min(std::bit_floor(std::max(m_depthExtent.width, 1u)), maxBase),
+                                std::min(std::bit_floor(std::max(m_depthExtent.height, 1u)), maxBase)};
+    m_levelCount = static_cast<uint32_t>(std::bit_width(std::max(m_baseExtent.width, m_baseExtent.height)));
+
+    vk::ImageCreateInfo imageInfo{};
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = vk::Format::eR32Sfloat;
+    imageInfo.extent = vk::Extent3D{m_baseExtent.width, m_baseExtent.height, 1};
+    imageInfo.mipLevels = m_levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    m_image = std::make_unique<Image>(m_renderer.allocator(), imageInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    vk::ImageViewCreateInfo viewInfo{};
+    viewInfo.image = m_image->get();
+    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.format = vk::Format::eR32Sfloat;
+    viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_levelCount, 0, 1);
+    m_view = m_renderer.device().createImageView(viewInfo);
+
+    m_levelViews.clear();
+    for (uint32_t level = 0; level < m_levelCount; ++level)
+    {
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1);
+        m_levelViews.push_back(m_renderer.device().createImageView(viewInfo));
+    }
+
+    m_initialized = false;
+    m_valid = false;
+}
+
+void HiZPyramid::retireImage()
+{
+    // Frames in flight may still be culling against the old pyramid
+    for (auto view : m_levelViews)
+    {
+        m_frameManager.retire(view);
+    }
+    m_levelViews.clear();
+    m_frameManager.retire(m_view);
+    m_view = nullptr;
+    m_frameManager.retire(std::move(m_image));
+}
+
+void HiZPyramid::resize(vk::Extent2D depthExtent)
+{
+    m_depthExtent = depthExtent;
+    retireImage();
+    createImage();
+}
+
+void HiZPyramid::updateDescriptors(size_t frameIndex, vk::ImageView depthView)
+{
+    const vk::DescriptorImageInfo depthInfo(m_sampler, depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+    // Unused slots repeat the coarsest mip so every array element is valid
+    std::array<vk::DescriptorImageInfo, kMaxLevels> levelInfos;
+    for (uint32_t level = 0; level < kMaxLevels; ++level)
+    {
+        levelInfos[level] = vk::DescriptorImageInfo(
+            nullptr, m_levelViews[std::min(level, m_levelCount - 1)], vk::ImageLayout::eGeneral);
+    }
+
+    const vk::DescriptorBufferInfo counterInfo(m_counter->getHandle(), 0, VK_WHOLE_SIZE);
+
+    const vk::DescriptorSet set = m_descriptors->get(frameIndex);
+    m_descriptors->updateSet({
+        vk::WriteDescriptorSet(set, 0, 0, vk::DescriptorType::eCombinedImageSampler, depthInfo),
+        vk::WriteDescriptorSet(set, 1, 0, vk::DescriptorType::eStorageImage, levelInfos),
+        vk::WriteDescriptorSet(set, 2, 0, vk::DescriptorType::eStorageBuffer, {}, counterInfo),
+    });
+
+    m_boundDepth[frameIndex] = depthView;
+    m_boundPyramid[frameIndex] = m_view;
+}
+
+void HiZPyramid::build(vk::CommandBuffer cmd, size_t frameIndex, vk::ImageView depthView)
+{
+    if (m_boundDepth[frameIndex] != depthView || m_boundPyramid[frameIndex] != m_view)
+    {
+        updateDescriptors(frameIndex, depthView);
+    }
+
+    // Earlier culling reads of the pyramid must finish before it is overwritten; a new image
+    // leaves eUndefined the first time
+    const vk::ImageMemoryBarrier toGeneral(vk::AccessFlagBits::eShaderRead,
+                                           vk::AccessFlagBits::eShaderWrite,
+                                           m_initialized ? vk::ImageLayout::eGeneral : vk::ImageLayout::eUndefined,
+                                           vk::ImageLayout::eGeneral,
+                                           VK_QUEUE_FAMILY_IGNORED,
+                                           VK_QUEUE_FAMILY_IGNORED,
+                                           m_image->get(),
+                                           {vk::ImageAspectFlagBits::eColor, 0, m_levelCount, 0, 1});
+    // The counter is shared by every build; the last one's atomics must finish before the clear
+    const vk::BufferMemoryBarrier counterIdle(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                                              vk::AccessFlagBits::eTransferWrite,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              m_counter->getHandle(),
+                                              0,
+                                              VK_WHOLE_SIZE);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                        {},
+                        nullptr,
+                        counterIdle,
+                        toGeneral);
+    m_initialized = true;
+
+    cmd.fillBuffer(m_counter->getHandle(), 0, sizeof(uint32_t), 0);
+    const vk::BufferMemoryBarrier counterReady(vk::AccessFlagBits::eTransferWrite,
+                                               vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                                               VK_QUEUE_FAMILY_IGNORED,
+                                               VK_QUEUE_FAMILY_IGNORED,
+                                               m_counter->getHandle(),
+                                               0,
+                                               VK_WHOLE_SIZE);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        {},
+                        nullptr,
+                        counterReady,
+                        nullptr);
+
+    const uint32_t groupsX = (m_baseExtent.width + kTileSize - 1) / kTileSize;
+    const uint32_t groupsY = (m_baseExtent.height + kTileSize - 1) / kTileSize;
+    const HiZPush push{{static_cast<int32_t>(m_depthExtent.width), static_cast<int32_t>(m_depthExtent.height)},
+                       {static_cast<int32_t>(m_baseExtent.width), static_cast<int32_t>(m_baseExtent.height)},
+                       static_cast<int32_t>(m_levelCount),
+                       static_cast<int32_t>(m_depthSamples),
+                       groupsX * groupsY};
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline->get());
+    const vk::DescriptorSet set = m_descriptors->get(frameIndex);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipeline->getLayout(), 0, set, nullptr);
+    cmd.pushConstants(m_pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
+    cmd.dispatch(groupsX, groupsY, 1);
+
+    const vk::MemoryBarrier pyramidReady(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        {},
+                        pyramidReady,
+                        nullptr,
+                        nullptr);
+    m_valid = true;
+}
+
+} // namespace reactor
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "DescriptorSet.hpp"
+#include "Image.hpp"
+#include "Pipeline.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+class FrameManager;
+class VulkanRenderer;
+
+// Hierarchical depth for occlusion culling. Mip 0 is the depth buffer reduced to the largest power
+// of two that fits, each further mip the farthest of the four texels below it, so one texel bounds
+// the depth of everything visible in the screen area it covers. Built from the multisampled depth
+// prepass in a single compute dispatch. The image stays in eGeneral.
+class HiZPyramid
+{
+public:
+    static constexpr uint32_t kMaxLevels = 13; // levels array size in hiz.comp
+
+    HiZPyramid(VulkanRenderer& renderer,
+               FrameManager& frameManager,
+               const std::string& shaderPath,
+               vk::Extent2D depthExtent,
+               uint32_t depthSamples);
+    ~HiZPyramid();
+
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+    // Recreates the pyramid for a new depth buffer size. Its contents are invalid until build().
+    void resize(vk::Extent2D depthExtent);
+
+    // Reduces depthView, which must be in eDepthStencilReadOnlyOptimal, into the pyramid and makes
+    // the result visible to compute shaders.
+    void build(vk::CommandBuffer cmd, size_t frameIndex, vk::ImageView depthView);
+
+    // All mips, for texelFetch with an explicit level
+    [[nodiscard]] vk::ImageView view() const
+    {
+        return m_view;
+    }
+    [[nodiscard]] vk::Sampler sampler() const
+    {
+        return m_sampler;
+    }
+    [[nodiscard]] vk::Extent2D baseExtent() const
+    {
+        return m_baseExtent;
+    }
+    [[nodiscard]] uint32_t levelCount() const
+    {
+        return m_levelCount;
+    }
+    // True once built since the last resize
+    [[nodiscard]] bool valid() const
+    {
+        return m_valid;
+    }
+
+private:
+    void createPipeline(const std::string& shaderPath);
+    void createImage();
+    void retireImage();
+    void updateDescriptors(size_t frameIndex, vk::ImageView depthView);
+
+    VulkanRenderer& m_renderer;
+    FrameManager& m_frameManager;
+    vk::Extent2D m_depthExtent;
+    uint32_t m_depthSamples;
+
+    vk::Extent2D m_baseExtent;
+    uint32_t m_levelCount = 0;
+    std::unique_ptr<Image> m_image;
+    vk::ImageView m_view;
+    std::vector<vk::ImageView> m_levelViews;
+    vk::Sampler m_sampler;
+    bool m_initialized = false; // moved out of eUndefined
+    bool m_valid = false;
+
+    std::unique_ptr<Buffer> m_counter; // workgroups finished, zeroed before each build
+    std::unique_ptr<DescriptorSet> m_descriptors;
+    std::vector<vk::ImageView> m_boundDepth;   // per frame
+    std::vector<vk::ImageView> m_boundPyramid; // per frame
+    std::unique_ptr<Pipeline> m_pipeline;
+};
+
+} // namespace reactor
@@ -11,17 +11,22 @@ namespace reactor {
         VmaAllocationCreateInfo allocInfo = {};
         allocInfo.usage = memoryUsage;
 
+        VmaAllocationInfo allocationInfo = {};
         const VkResult result = vmaCreateImage(
             m_allocator.getAllocator(),
             reinterpret_cast<const VkImageCreateInfo*>(&imageInfo),
             &allocInfo,
             reinterpret_cast<VkImage*>(&m_image),
             &m_allocation,
-            nullptr);
+            &allocationInfo);
 
         if (result != VK_SUCCESS) {
             throw std::runtime_error("Failed to create image!");
         }
+
+        // Every image in the renderer is an attachment or shadow map.
+        m_allocationSize = allocationInfo.size;
+        m_allocator.telemetry().track(MemoryCategory::RenderTarget, m_allocationSize);
     }
 
     Image::~Image() {
@@ -31,10 +36,12 @@ namespace reactor {
     Image::Image(Image&& other) noexcept
         : m_allocator(other.m_allocator), // Initialize reference in move constructor
           m_image(other.m_image),
-          m_allocation(other.m_allocation)
+          m_allocation(other.m_allocation),
+          m_allocationSize(other.m_allocationSize)
     {
         other.m_image = VK_NULL_HANDLE;
         other.m_allocation = VK_NULL_HANDLE;
+        other.m_allocationSize = 0;
     }
 
     Image& Image::operator=(Image&& other) noexcept {
@@ -45,10 +52,12 @@ namespace reactor {
             // Transfer ownership of resources from 'other' to 'this'.
             m_image = other.m_image;
             m_allocation = other.m_allocation;
+            m_allocationSize = other.m_allocationSize;
 
             // Invalidate 'other' to prevent it from cleaning up the moved resources.
             other.m_image = VK_NULL_HANDLE;
             other.m_allocation = VK_NULL_HANDLE;
+            other.m_allocationSize = 0;
 
             // **DO NOT** attempt to assign to m_allocator.
             // m_allocator is a reference and must remain bound to its original Allocator instance.
@@ -60,6 +69,7 @@ namespace reactor {
     void Image::cleanup() {
         if (m_image && m_allocation) {
             vmaDestroyImage(m_allocator.getAllocator(), m_image, m_allocation);
+            m_allocator.telemetry().untrack(MemoryCategory::RenderTarget, m_allocationSize);
             spdlog::info("Image destroyed");
             m_image = VK_NULL_HANDLE;
             m_allocation = VK_NULL_HANDLE;
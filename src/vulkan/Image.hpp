@@ -27,6 +27,7 @@ namespace reactor {
         Allocator& m_allocator;
         vk::Image m_image = VK_NULL_HANDLE;
         VmaAllocation m_allocation = VK_NULL_HANDLE;
+        vk::DeviceSize m_allocationSize = 0;
 
         void cleanup();
     };
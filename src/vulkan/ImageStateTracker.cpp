@@ -20,6 +20,10 @@ vk::ImageLayout ImageStateTracker::getCurrentLayout(vk::Image image) const {
     return it->second;
 }
 
+void ImageStateTracker::forgetState(vk::Image image) {
+    m_imageStates.erase(image);
+}
+
 void ImageStateTracker::transition(
     vk::CommandBuffer cmd,
     vk::Image image,
@@ -23,6 +23,9 @@ public:
 
     vk::ImageLayout getCurrentLayout(vk::Image image) const;
 
+    // Stop tracking an image that is being retired; its handle value may be reused later.
+    void forgetState(vk::Image image);
+
 private:
     std::map<vk::Image, vk::ImageLayout> m_imageStates;
 };
@@ -0,0 +1,260 @@
+#include "ImpostorRenderer.hpp"
+
+#include "FrameManager.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace reactor
+{
+
+namespace
+{
+constexpr uint32_t kLayerCount = 2; // albedo, normal and depth
+
+struct ImpostorPush
+{
+    glm::vec4 bounds;
+    glm::vec4 eye; // w holds the atlas grid size
+};
+} // namespace
+
+ImpostorRenderer::ImpostorRenderer(VulkanRenderer& renderer,
+                                   FrameManager& frameManager,
+                                   AssetLoader& loader,
+                                   vk::DescriptorSetLayout sceneLayout,
+                                   const std::string& vertShaderPath,
+                                   const std::string& fragShaderPath)
+    : m_renderer(renderer), m_frameManager(frameManager), m_loader(loader)
+{
+    spdlog::info("Creating impostor pipeline");
+
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.magFilter = vk::Filter::eLinear;
+    samplerInfo.minFilter = vk::Filter::eLinear;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    m_sampler = m_renderer.device().createSampler(samplerInfo);
+
+    const std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        {0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment},
+    };
+    m_descriptors =
+        std::make_unique<DescriptorSet>(m_renderer.device(), m_renderer.descriptorPool(), kMaxAtlases, bindings);
+
+    // Same targets as the main pass; quads are seen from either side
+    m_pipeline = Pipeline::Builder(m_renderer.device())
+                     .setVertexShader(vertShaderPath)
+                     .setFragmentShader(fragShaderPath)
+                     .setInstanceInputFromTransform()
+                     .setColorAttachment(vk::Format::eR16G16B16A16Sfloat)
+                     .setDepthAttachment(vk::Format::eD32Sfloat, true)
+                     .setDescriptorSetLayouts({sceneLayout, m_descriptors->getLayout()})
+                     .setMultisample(4)
+                     .setCullMode(vk::CullModeFlagBits::eNone)
+                     .addPushContantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(ImpostorPush))
+                     .build();
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+    auto device = m_renderer.device();
+    for (const Slot& slot : m_slots)
+    {
+        device.destroyImageView(slot.view);
+    }
+    device.destroySampler(m_sampler);
+}
+
+uint32_t ImpostorRenderer::find(const LodMesh& mesh)
+{
+    auto [it, inserted] = m_meshes.try_emplace(&mesh);
+    MeshEntry& entry = it->second;
+    if (inserted || entry.mesh.expired())
+    {
+        entry.mesh = mesh.weak_from_this();
+
+        // Meshes reloaded after eviction find the atlas of their file again
+        const std::string path = impostorPath(mesh.path(), mesh.meshIndex());
+        auto [atlasIt, created] = m_atlases.try_emplace(path);
+        if (created)
+        {
+            auto atlas = std::make_shared<Atlas>();
+            spawn(m_loader.readImpostorAsync(path), [atlas](std::shared_ptr<const ImpostorAtlas> data) {
+                const State state = data ? State::Loaded : State::Failed;
+                atlas->data = std::move(data);
+                atlas->state.store(state, std::memory_order_release);
+            });
+            atlasIt->second = atlas;
+            m_loading.push_back(std::move(atlas));
+        }
+        entry.atlas = atlasIt->second;
+    }
+    return entry.atlas->slot;
+}
+
+void ImpostorRenderer::update(vk::CommandBuffer cmd)
+{
+    // Uploads are a few megabytes each, so one per frame keeps a burst of arrivals from stalling
+    bool uploaded = false;
+    std::erase_if(m_loading, [&](const std::shared_ptr<Atlas>& atlas) {
+        const State state = atlas->state.load(std::memory_order_acquire);
+        if (state == State::Failed)
+        {
+            return true;
+        }
+        if (state != State::Loaded || uploaded)
+        {
+            return false;
+        }
+        if (m_slots.size() == kMaxAtlases)
+        {
+            if (!m_warnedFull)
+            {
+                spdlog::warn("More than {} impostor atlases; further meshes draw as geometry", kMaxAtlases);
+                m_warnedFull = true;
+            }
+            atlas->data.reset();
+            return true;
+        }
+        upload(cmd, *atlas);
+        uploaded = true;
+        return true;
+    });
+
+    // Entries of destroyed meshes pile up as the world streams; drop them once they double
+    if (m_meshes.size() > m_pruneThreshold)
+    {
+        std::erase_if(m_meshes, [](const auto& entry) { return entry.second.mesh.expired(); });
+        m_pruneThreshold = std::max<size_t>(256, m_meshes.size() * 2);
+    }
+}
+
+void ImpostorRenderer::upload(vk::CommandBuffer cmd, Atlas& atlas)
+{
+    const ImpostorAtlas& data = *atlas.data;
+    const uint32_t size = data.size();
+
+    vk::ImageCreateInfo imageInfo{};
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = vk::Format::eR8G8B8A8Unorm;
+    imageInfo.extent = vk::Extent3D{size, size, 1};
+    imageInfo.mipLevels = data.levelCount;
+    imageInfo.arrayLayers = kLayerCount;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    auto image = std::make_unique<Image>(m_renderer.allocator(), imageInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    // Both layers back to back, each with its whole mip chain
+    const size_t layerBytes = data.levelOffset(data.levelCount) * sizeof(uint32_t);
+    auto staging = std::make_unique<Buffer>(m_renderer.allocator(),
+                                            kLayerCount * layerBytes,
+                                            vk::BufferUsageFlagBits::eTransferSrc,
+                                            MemoryPlacement::Staging,
+                                            "Impostor Staging");
+    auto* bytes = static_cast<char*>(staging->mappedData());
+    memcpy(bytes, data.albedo.data(), layerBytes);
+    memcpy(bytes + layerBytes, data.normalDepth.data(), layerBytes);
+    staging->flush();
+
+    const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, data.levelCount, 0, kLayerCount);
+    const vk::ImageMemoryBarrier toTransfer({},
+                                            vk::AccessFlagBits::eTransferWrite,
+                                            vk::ImageLayout::eUndefined,
+                                            vk::ImageLayout::eTransferDstOptimal,
+                                            VK_QUEUE_FAMILY_IGNORED,
+                                            VK_QUEUE_FAMILY_IGNORED,
+                                            image->get(),
+                                            range);
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransfer);
+
+    std::vector<vk::BufferImageCopy> regions;
+    for (uint32_t layer = 0; layer < kLayerCount; ++layer)
+    {
+        for (uint32_t level = 0; level < data.levelCount; ++level)
+        {
+            vk::BufferImageCopy region{};
+            region.bufferOffset = layer * layerBytes + data.levelOffset(level) * sizeof(uint32_t);
+            region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, layer, 1);
+            region.imageExtent = vk::Extent3D{size >> level, size >> level, 1};
+            regions.push_back(region);
+        }
+    }
+    cmd.copyBufferToImage(staging->getHandle(), image->get(), vk::ImageLayout::eTransferDstOptimal, regions);
+
+    const vk::ImageMemoryBarrier toShader(vk::AccessFlagBits::eTransferWrite,
+                                          vk::AccessFlagBits::eShaderRead,
+                                          vk::ImageLayout::eTransferDstOptimal,
+                                          vk::ImageLayout::eShaderReadOnlyOptimal,
+                                          VK_QUEUE_FAMILY_IGNORED,
+                                          VK_QUEUE_FAMILY_IGNORED,
+                                          image->get(),
+                                          range);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eFragmentShader,
+                        {},
+                        nullptr,
+                        nullptr,
+                        toShader);
+    m_frameManager.retire(std::move(staging));
+
+    vk::ImageViewCreateInfo viewInfo{};
+    viewInfo.image = image->get();
+    viewInfo.viewType = vk::ImageViewType::e2DArray;
+    viewInfo.format = vk::Format::eR8G8B8A8Unorm;
+    viewInfo.subresourceRange = range;
+
+    Slot& slot = m_slots.emplace_back();
+    slot.image = std::move(image);
+    slot.view = m_renderer.device().createImageView(viewInfo);
+    slot.bounds = glm::vec4(data.center, data.radius);
+    slot.gridSize = static_cast<float>(data.gridSize);
+
+    const auto index = static_cast<uint32_t>(m_slots.size() - 1);
+    const vk::DescriptorImageInfo atlasInfo(m_sampler, slot.view, vk::ImageLayout::eShaderReadOnlyOptimal);
+    m_descriptors->updateSet({
+        vk::WriteDescriptorSet(m_descriptors->get(index), 0, 0, vk::DescriptorType::eCombinedImageSampler, atlasInfo),
+    });
+
+    atlas.slot = index;
+    atlas.data.reset();
+}
+
+void ImpostorRenderer::draw(vk::CommandBuffer cmd,
+                            vk::DescriptorSet sceneSet,
+                            vk::Buffer instanceBuffer,
+                            const glm::vec3& eye,
+                            const std::vector<ImpostorBatch>& batches) const
+{
+    if (batches.empty())
+    {
+        return;
+    }
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline->getLayout(), 0, sceneSet, nullptr);
+    const vk::DeviceSize offset = 0;
+    cmd.bindVertexBuffers(1, 1, &instanceBuffer, &offset);
+
+    for (const auto& [atlas, firstInstance, instanceCount] : batches)
+    {
+        const Slot& slot = m_slots[atlas];
+        const ImpostorPush push{slot.bounds, glm::vec4(eye, slot.gridSize)};
+        const vk::DescriptorSet set = m_descriptors->get(atlas);
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipeline->getLayout(), 1, set, nullptr);
+        cmd.pushConstants(m_pipeline->getLayout(), vk::ShaderStageFlagBits::eVertex, 0, sizeof(push), &push);
+        cmd.draw(6, instanceCount, 0, firstInstance);
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../core/AssetLoader.hpp"
+#include "../core/Impostor.hpp"
+#include "../core/LodMesh.hpp"
+#include "DescriptorSet.hpp"
+#include "Image.hpp"
+#include "Pipeline.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace reactor
+{
+
+class FrameManager;
+class VulkanRenderer;
+
+// Instances drawn from one atlas, read from the frame's instance buffer.
+struct ImpostorBatch
+{
+    uint32_t atlas;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+// Draws distant instances as single quads cut from their mesh's octahedral impostor atlas. Atlases
+// are looked up per LodMesh; the first lookup reads <mesh>.<index>.impostor in the background,
+// and finished reads are uploaded at most one per frame. Meshes without an atlas file keep drawing
+// as geometry. Render thread only.
+class ImpostorRenderer
+{
+public:
+    static constexpr uint32_t kNoAtlas = ~0u;
+    static constexpr uint32_t kMaxAtlases = 32; // one descriptor set each, allocated up front
+
+    // sceneLayout is the main pass's set 0: scene and light uniforms and the shadow map.
+    ImpostorRenderer(VulkanRenderer& renderer,
+                     FrameManager& frameManager,
+                     AssetLoader& loader,
+                     vk::DescriptorSetLayout sceneLayout,
+                     const std::string& vertShaderPath,
+                     const std::string& fragShaderPath);
+    ~ImpostorRenderer();
+
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    // Atlas that draws mesh as an impostor, or kNoAtlas while it loads or when the mesh has none.
+    uint32_t find(const LodMesh& mesh);
+
+    // Records the upload of an atlas that finished loading. Must be outside a render pass and
+    // before the main pass.
+    void update(vk::CommandBuffer cmd);
+
+    // Records the batches into the main pass. sceneSet is bound again as set 0, since the impostor
+    // pipeline's push constants make its layout incompatible with the mesh pipeline's.
+    void draw(vk::CommandBuffer cmd,
+              vk::DescriptorSet sceneSet,
+              vk::Buffer instanceBuffer,
+              const glm::vec3& eye,
+              const std::vector<ImpostorBatch>& batches) const;
+
+private:
+    enum class State
+    {
+        Loading,
+        Loaded,
+        Failed,
+    };
+
+    struct Atlas
+    {
+        std::atomic<State> state{State::Loading};
+        std::shared_ptr<const ImpostorAtlas> data; // written once before state becomes Loaded
+        uint32_t slot = kNoAtlas;                   // set once uploaded
+    };
+
+    // Uploaded atlas, indexed by slot
+    struct Slot
+    {
+        std::unique_ptr<Image> image;
+        vk::ImageView view;
+        glm::vec4 bounds; // object-space centre and radius
+        float gridSize;
+    };
+
+    struct MeshEntry
+    {
+        std::weak_ptr<const LodMesh> mesh; // expired once the address may belong to another mesh
+        std::shared_ptr<Atlas> atlas;
+    };
+
+    void upload(vk::CommandBuffer cmd, Atlas& atlas);
+
+    VulkanRenderer& m_renderer;
+    FrameManager& m_frameManager;
+    AssetLoader& m_loader;
+    vk::Sampler m_sampler;
+    std::unique_ptr<DescriptorSet> m_descriptors; // kMaxAtlases sets, one per slot
+    std::unique_ptr<Pipeline> m_pipeline;
+
+    std::unordered_map<std::string, std::shared_ptr<Atlas>> m_atlases; // by impostor path
+    std::unordered_map<const LodMesh*, MeshEntry> m_meshes;
+    std::vector<std::shared_ptr<Atlas>> m_loading;
+    std::vector<Slot> m_slots;
+    size_t m_pruneThreshold = 256;
+    bool m_warnedFull = false;
+};
+
+} // namespace reactor
@@ -0,0 +1,139 @@
+#include "MemoryTelemetry.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
+namespace reactor
+{
+
+const char* toString(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::RenderTarget:
+        return "render_targets";
+    case MemoryCategory::Mesh:
+        return "meshes";
+    case MemoryCategory::Uniform:
+        return "uniforms";
+    case MemoryCategory::Staging:
+        return "staging";
+    default:
+        return "other";
+    }
+}
+
+MemoryCategory classifyBufferName(const std::string& name)
+{
+    // Staging is checked first: mesh uploads are named "Staging Vertex" / "... Staging".
+    if (name.find("Staging") != std::string::npos)
+        return MemoryCategory::Staging;
+    if (name.find("Vertex") != std::string::npos || name.find("Index") != std::string::npos
+        || name.find("Mesh") != std::string::npos)
+        return MemoryCategory::Mesh;
+    if (name.find("Uniform") != std::string::npos || name.find("MVP") != std::string::npos
+        || name.find("UBO") != std::string::npos)
+        return MemoryCategory::Uniform;
+    return MemoryCategory::Other;
+}
+
+void MemoryTelemetry::track(MemoryCategory category, vk::DeviceSize bytes)
+{
+    const auto index = static_cast<size_t>(category);
+    m_bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+    m_counts[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryTelemetry::untrack(MemoryCategory category, vk::DeviceSize bytes)
+{
+    const auto index = static_cast<size_t>(category);
+    m_bytes[index].fetch_sub(bytes, std::memory_order_relaxed);
+    m_counts[index].fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryReport MemoryTelemetry::snapshot(VmaAllocator allocator, bool budgetExtension) const
+{
+    MemoryReport report;
+    report.budgetExtension = budgetExtension;
+
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    // Without VK_EXT_memory_budget VMA estimates these from its own blocks and the heap size.
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(allocator, budgets.data());
+
+    report.heaps.reserve(memoryProperties->memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+    {
+        const VkMemoryHeap& heap = memoryProperties->memoryHeaps[i];
+
+        HeapBudget entry;
+        entry.heapIndex = i;
+        entry.deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        entry.heapSize = heap.size;
+        entry.budget = budgets[i].budget;
+        entry.usage = budgets[i].usage;
+        entry.blockBytes = budgets[i].statistics.blockBytes;
+        entry.allocationBytes = budgets[i].statistics.allocationBytes;
+        entry.blockCount = budgets[i].statistics.blockCount;
+        entry.allocationCount = budgets[i].statistics.allocationCount;
+        report.heaps.push_back(entry);
+    }
+
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i)
+    {
+        report.categories[i].bytes = m_bytes[i].load(std::memory_order_relaxed);
+        report.categories[i].count = m_counts[i].load(std::memory_order_relaxed);
+    }
+
+    return report;
+}
+
+std::string toJson(const MemoryReport& report)
+{
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"budgetExtension\": " << (report.budgetExtension ? "true" : "false") << ",\n";
+
+    out << "  \"heaps\": [\n";
+    for (size_t i = 0; i < report.heaps.size(); ++i)
+    {
+        const HeapBudget& heap = report.heaps[i];
+        out << "    {\"index\": " << heap.heapIndex << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+            << ", \"size\": " << heap.heapSize << ", \"budget\": " << heap.budget << ", \"usage\": " << heap.usage
+            << ", \"blockBytes\": " << heap.blockBytes << ", \"allocationBytes\": " << heap.allocationBytes
+            << ", \"blockCount\": " << heap.blockCount << ", \"allocationCount\": " << heap.allocationCount << "}"
+            << (i + 1 < report.heaps.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+
+    out << "  \"categories\": {\n";
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i)
+    {
+        const CategoryUsage& usage = report.categories[i];
+        out << "    \"" << toString(static_cast<MemoryCategory>(i)) << "\": {\"bytes\": " << usage.bytes
+            << ", \"count\": " << usage.count << "}" << (i + 1 < kMemoryCategoryCount ? "," : "") << "\n";
+    }
+    out << "  }\n";
+    out << "}\n";
+    return out.str();
+}
+
+bool writeMemoryReport(const MemoryReport& report, const std::string& path)
+{
+    std::ofstream outFile(path);
+    if (!outFile.is_open())
+    {
+        spdlog::error("Failed to open memory report for writing: {}", path);
+        return false;
+    }
+
+    outFile << toJson(report);
+    spdlog::info("Wrote memory report to {}", path);
+    return true;
+}
+
+} // namespace reactor
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+enum class MemoryCategory : uint32_t
+{
+    RenderTarget,
+    Mesh,
+    Uniform,
+    Staging,
+    Other,
+    Count
+};
+
+constexpr size_t kMemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+const char* toString(MemoryCategory category);
+
+// Buffers carry a debug name ("Vertex Buffer", "Mesh Staging", ...); the category is derived from it.
+MemoryCategory classifyBufferName(const std::string& name);
+
+struct HeapBudget
+{
+    uint32_t heapIndex = 0;
+    bool deviceLocal = false;
+    vk::DeviceSize heapSize = 0;
+    vk::DeviceSize budget = 0;
+    vk::DeviceSize usage = 0;
+    vk::DeviceSize blockBytes = 0;
+    vk::DeviceSize allocationBytes = 0;
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+};
+
+struct CategoryUsage
+{
+    vk::DeviceSize bytes = 0;
+    uint32_t count = 0;
+};
+
+struct MemoryReport
+{
+    bool budgetExtension = false;
+    std::vector<HeapBudget> heaps;
+    std::array<CategoryUsage, kMemoryCategoryCount> categories{};
+};
+
+class MemoryTelemetry
+{
+public:
+    MemoryTelemetry() = default;
+
+    void track(MemoryCategory category, vk::DeviceSize bytes);
+    void untrack(MemoryCategory category, vk::DeviceSize bytes);
+
+    [[nodiscard]] MemoryReport snapshot(VmaAllocator allocator, bool budgetExtension) const;
+
+    MemoryTelemetry(const MemoryTelemetry&) = delete;
+    MemoryTelemetry& operator=(const MemoryTelemetry&) = delete;
+
+private:
+    std::array<std::atomic<uint64_t>, kMemoryCategoryCount> m_bytes{};
+    std::array<std::atomic<uint32_t>, kMemoryCategoryCount> m_counts{};
+};
+
+std::string toJson(const MemoryReport& report);
+bool writeMemoryReport(const MemoryReport& report, const std::string& path);
+
+} // namespace reactor
@@ -1,90 +1,40 @@
 #include "Mesh.hpp"
-#include <cstring>  // For memcpy
-
 #include "Allocator.hpp"
+#include "UploadScheduler.hpp"
 
 namespace reactor {
 
-// Forward declaration of a helper function to perform the copy.
-// This keeps the constructor clean.
-// Helper function for one-time command submission.
-// This could be placed in a utility file or within the Allocator class.
-void immediateSubmit(
-    Allocator& allocator,
-    std::function<void(vk::CommandBuffer cmd)>&& function)
-{
-    vk::Device device = allocator.getDevice();
-    vk::Queue graphicsQueue = allocator.getGraphicsQueue();
-    uint32_t queueFamilyIndex = allocator.getGraphicsQueueFamilyIndex();
-
-    // Create a temporary command pool and buffer
-    vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eTransient, queueFamilyIndex);
-    vk::CommandPool cmdPool = device.createCommandPool(poolInfo);
-
-    vk::CommandBufferAllocateInfo allocInfo(cmdPool, vk::CommandBufferLevel::ePrimary, 1);
-    vk::CommandBuffer cmd = device.allocateCommandBuffers(allocInfo)[0];
-
-    // Record and submit commands
-    vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-    cmd.begin(beginInfo);
-
-    function(cmd); // Execute the provided command recording function
-
-    cmd.end();
-
-    vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &cmd);
-    graphicsQueue.submit(submitInfo, nullptr);
-    graphicsQueue.waitIdle(); // Wait for the operation to complete
-
-    // Clean up temporary resources
-    device.freeCommandBuffers(cmdPool, cmd);
-    device.destroyCommandPool(cmdPool);
-}
-
 Mesh::Mesh(Allocator& allocator, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
     vk::DeviceSize vertexSize = vertices.size() * sizeof(Vertex);
     vk::DeviceSize indexSize = indices.size() * sizeof(uint32_t);
     m_indexCount = static_cast<uint32_t>(indices.size());
 
-    // Staging buffers (CPU-visible)
-    Buffer stagingVertex(allocator, vertexSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_TO_GPU, "Staging Vertex");
-    void* data;
-    vmaMapMemory(allocator.getAllocator(), stagingVertex.allocation(), &data);
-    memcpy(data, vertices.data(), static_cast<size_t>(vertexSize));
-    vmaUnmapMemory(allocator.getAllocator(), stagingVertex.allocation());
-
-    Buffer stagingIndex(allocator, indexSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_TO_GPU, "Staging Index");
-    vmaMapMemory(allocator.getAllocator(), stagingIndex.allocation(), &data);
-    memcpy(data, indices.data(), static_cast<size_t>(indexSize));
-    vmaUnmapMemory(allocator.getAllocator(), stagingIndex.allocation());
-
-    // GPU buffers (device-local)
-    m_vertexBuffer = std::make_unique<Buffer>(allocator, vertexSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, VMA_MEMORY_USAGE_GPU_ONLY, "Vertex Buffer");
-    m_indexBuffer = std::make_unique<Buffer>(allocator, indexSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, VMA_MEMORY_USAGE_GPU_ONLY, "Index Buffer");
-
-
-    // One-time transfer from staging to device-local buffers
-    immediateSubmit(allocator, [&](vk::CommandBuffer cmd) {
-        vk::BufferCopy vertexCopyRegion{};
-        vertexCopyRegion.srcOffset = 0;
-        vertexCopyRegion.dstOffset = 0;
-        vertexCopyRegion.size = vertexSize;
-        cmd.copyBuffer(stagingVertex.getHandle(), m_vertexBuffer->getHandle(), 1, &vertexCopyRegion);
-
-        vk::BufferCopy indexCopyRegion{};
-        indexCopyRegion.srcOffset = 0;
-        indexCopyRegion.dstOffset = 0;
-        indexCopyRegion.size = indexSize;
-        cmd.copyBuffer(stagingIndex.getHandle(), m_indexBuffer->getHandle(), 1, &indexCopyRegion);
-    });
+    // The allocator writes small meshes straight into host-visible device-local memory and
+    // stages everything else into device-local buffers.
+    m_vertexBuffer = allocator.createBufferWithData(vertices.data(), vertexSize, vk::BufferUsageFlagBits::eVertexBuffer, "Vertex Buffer");
+    m_indexBuffer = allocator.createBufferWithData(indices.data(), indexSize, vk::BufferUsageFlagBits::eIndexBuffer, "Index Buffer");
+}
 
+Mesh::Mesh(UploadScheduler& scheduler, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::vec3& position)
+    : m_pendingUploads(std::make_shared<std::atomic<uint32_t>>(2)) {
+    vk::DeviceSize vertexSize = vertices.size() * sizeof(Vertex);
+    vk::DeviceSize indexSize = indices.size() * sizeof(uint32_t);
+    m_indexCount = static_cast<uint32_t>(indices.size());
 
+    auto onReady = [pending = m_pendingUploads] { pending->fetch_sub(1, std::memory_order_release); };
+    m_vertexBuffer = scheduler.enqueue(vertices.data(), vertexSize, vk::BufferUsageFlagBits::eVertexBuffer, "Vertex Buffer", position, onReady);
+    m_indexBuffer = scheduler.enqueue(indices.data(), indexSize, vk::BufferUsageFlagBits::eIndexBuffer, "Index Buffer", position, onReady);
 }
 
+Mesh::Mesh(std::shared_ptr<Buffer> vertexBuffer, std::shared_ptr<Buffer> indexBuffer, uint32_t indexCount)
+    : m_vertexBuffer(std::move(vertexBuffer)),
+      m_indexBuffer(std::move(indexBuffer)),
+      m_indexCount(indexCount) {}
 
 Mesh::Mesh(Mesh&& other) noexcept
     : m_vertexBuffer(std::move(other.m_vertexBuffer)),
       m_indexBuffer(std::move(other.m_indexBuffer)),
+      m_pendingUploads(std::move(other.m_pendingUploads)),
       m_indexCount(other.m_indexCount) {
     other.m_indexCount = 0;
 }
@@ -93,6 +43,7 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept {
     if (this != &other) {
         m_vertexBuffer = std::move(other.m_vertexBuffer);
         m_indexBuffer = std::move(other.m_indexBuffer);
+        m_pendingUploads = std::move(other.m_pendingUploads);
         m_indexCount = other.m_indexCount;
         other.m_indexCount = 0;
     }
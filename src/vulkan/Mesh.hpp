@@ -2,6 +2,7 @@
 
 #include "Buffer.hpp"
 #include "Vertex.hpp"
+#include <atomic>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -9,11 +10,23 @@
 namespace reactor
 {
 
+class UploadScheduler;
+
 class Mesh
 {
 public:
     Mesh(Allocator& allocator, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
+    // Uploads through the scheduler; the mesh is not drawable until isReady() returns true.
+    // position is used to prioritize the upload against other pending ones.
+    Mesh(UploadScheduler& scheduler,
+         const std::vector<Vertex>& vertices,
+         const std::vector<uint32_t>& indices,
+         const glm::vec3& position = glm::vec3(0.0f));
+
+    // Wraps buffers whose contents have already been uploaded.
+    Mesh(std::shared_ptr<Buffer> vertexBuffer, std::shared_ptr<Buffer> indexBuffer, uint32_t indexCount);
+
     // Movable but not copyable (due to Buffer)
     Mesh(Mesh&& other) noexcept;
     Mesh& operator=(Mesh&& other) noexcept;
@@ -34,13 +47,97 @@ public:
     {
         return m_indexCount;
     }
+    vk::DeviceSize getMemorySize() const
+    {
+        return m_vertexBuffer->size() + m_indexBuffer->size();
+    }
+    bool isReady() const
+    {
+        return !m_pendingUploads || m_pendingUploads->load(std::memory_order_acquire) == 0;
+    }
 
 private:
-    std::unique_ptr<Buffer> m_vertexBuffer;
-    std::unique_ptr<Buffer> m_indexBuffer;
+    std::shared_ptr<Buffer> m_vertexBuffer;
+    std::shared_ptr<Buffer> m_indexBuffer;
+    // Shared with the scheduler's completion callbacks so the mesh stays movable while uploading.
+    std::shared_ptr<std::atomic<uint32_t>> m_pendingUploads;
     uint32_t m_indexCount = 0;
+};
+
+// Reference to a mesh that may still be loading. Copies share one slot, so a scene entity can hold
+// the handle before the loader has produced the mesh.
+class MeshHandle
+{
+public:
+    MeshHandle()
+        : m_slot(std::make_shared<Slot>())
+    {}
+    MeshHandle(std::shared_ptr<Mesh> mesh)
+        : MeshHandle()
+    {
+        publish(std::move(mesh));
+    }
+
+    // Null until the mesh has been published and its buffers have landed on the GPU.
+    Mesh* get() const
+    {
+        if (m_slot->state.load(std::memory_order_acquire) != State::Published)
+            return nullptr;
+        return m_slot->mesh->isReady() ? m_slot->mesh.get() : nullptr;
+    }
+    bool isReady() const
+    {
+        return get() != nullptr;
+    }
+    bool hasFailed() const
+    {
+        return m_slot->state.load(std::memory_order_acquire) == State::Failed;
+    }
+    bool isLoading() const
+    {
+        return m_slot->state.load(std::memory_order_acquire) == State::Loading;
+    }
+
+    // The published mesh, ready or not; null while loading.
+    std::shared_ptr<Mesh> shared() const
+    {
+        if (m_slot->state.load(std::memory_order_acquire) != State::Published)
+            return nullptr;
+        return m_slot->mesh;
+    }
+
+    // Number of handles sharing this slot.
+    long useCount() const
+    {
+        return m_slot.use_count();
+    }
+
+    // Called once by the loader.
+    void publish(std::shared_ptr<Mesh> mesh)
+    {
+        m_slot->mesh = std::move(mesh);
+        m_slot->state.store(m_slot->mesh ? State::Published : State::Failed, std::memory_order_release);
+    }
+    void fail()
+    {
+        m_slot->state.store(State::Failed, std::memory_order_release);
+    }
+
+private:
+    enum class State
+    {
+        Loading,
+        Published,
+        Failed,
+    };
+
+    struct Slot
+    {
+        std::shared_ptr<Mesh> mesh;
+        std::atomic<State> state{State::Loading};
+    };
 
-    void createBuffer(Allocator& allocator, const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage, std::unique_ptr<Buffer>& buffer, const std::string& name);
+    std::shared_ptr<Slot> m_slot;
 };
 
 } // namespace reactor
@@ -1,23 +1,24 @@
 #include "Pipeline.hpp"
-#include <fstream>
 #include <stdexcept>
 
+#include "../core/AsyncIO.hpp"
 #include "ShaderModule.hpp"
 #include "VulkanUtils.hpp"
 
 namespace reactor
 {
 
-    static std::vector<char> readFile(const std::string& filename)
+    // Reads all shader stages as one batch so they load in parallel.
+    static std::vector<std::vector<char>> readFiles(const std::vector<std::string>& filenames)
     {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
-        if (!file.is_open())
-            throw std::runtime_error("Failed to open shader file: " + filename);
-        size_t fileSize = (size_t)file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        return buffer;
+        std::vector<std::vector<char>> buffers;
+        for (auto& file : AsyncIO::shared().readAll(filenames))
+        {
+            if (!file.ok)
+                throw std::runtime_error("Failed to open shader file: " + file.path);
+            buffers.push_back(std::move(file.data));
+        }
+        return buffers;
     }
 
     Pipeline::Builder::Builder(vk::Device device)
@@ -36,6 +37,12 @@ namespace reactor
         return *this;
     }
 
+    Pipeline::Builder& Pipeline::Builder::setComputeShader(const std::string& shaderPath)
+    {
+        m_compShaderPath = shaderPath;
+        return *this;
+    }
+
     Pipeline::Builder& Pipeline::Builder::setColorAttachment(vk::Format format)
     {
         m_colorAttachmentFormat = format;
@@ -63,6 +70,23 @@ namespace reactor
         return *this;
     }
 
+    Pipeline::Builder& Pipeline::Builder::setInstanceInputFromTransform()
+    {
+        m_bindings.push_back(InstanceTransform::getBindingDescription());
+        auto attrs = InstanceTransform::getAttributeDescriptions();
+        m_attributes.insert(m_attributes.end(), attrs.begin(), attrs.end());
+        return *this;
+    }
+
+    Pipeline::Builder& Pipeline::Builder::addVertexInput(
+        const vk::VertexInputBindingDescription& binding,
+        const std::vector<vk::VertexInputAttributeDescription>& attributes)
+    {
+        m_bindings.push_back(binding);
+        m_attributes.insert(m_attributes.end(), attributes.begin(), attributes.end());
+        return *this;
+    }
+
     Pipeline::Builder& Pipeline::Builder::setMultisample(uint32_t samples)
     {
         m_samples = samples;
@@ -96,17 +120,23 @@ namespace reactor
 
     std::unique_ptr<Pipeline> Pipeline::Builder::build() const
     {
+        if (!m_compShaderPath.empty())
+            return buildCompute();
+
         // 1. Shader Stages
-        auto vertShaderCode = readFile(m_vertShaderPath);
-        auto vertShaderModule = ShaderModule(m_device, vertShaderCode);
+        std::vector<std::string> shaderPaths = {m_vertShaderPath};
+        if (!m_fragShaderPath.empty())
+            shaderPaths.push_back(m_fragShaderPath);
+        auto shaderCode = readFiles(shaderPaths);
+
+        auto vertShaderModule = ShaderModule(m_device, shaderCode[0]);
         vk::PipelineShaderStageCreateInfo vertStageInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule.getHandle(), "main");
 
         std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = {vertStageInfo};
         std::unique_ptr<ShaderModule> fragShaderModule;
         if (!m_fragShaderPath.empty())
         {
-            auto fragShaderCode = readFile(m_fragShaderPath);
-            fragShaderModule = std::make_unique<ShaderModule>(m_device, fragShaderCode);
+            fragShaderModule = std::make_unique<ShaderModule>(m_device, shaderCode[1]);
             vk::PipelineShaderStageCreateInfo fragStageInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule->getHandle(), "main");
             shaderStages.push_back(fragStageInfo);
         }
@@ -203,6 +233,28 @@ namespace reactor
         return std::unique_ptr<Pipeline>(new Pipeline(m_device, pipelineLayout, result.value));
     }
 
+    std::unique_ptr<Pipeline> Pipeline::Builder::buildCompute() const
+    {
+        auto shaderCode = readFiles({m_compShaderPath});
+        auto compShaderModule = ShaderModule(m_device, shaderCode[0]);
+        vk::PipelineShaderStageCreateInfo compStageInfo({}, vk::ShaderStageFlagBits::eCompute, compShaderModule.getHandle(), "main");
+
+        vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, m_setLayouts);
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(m_pushRanges.size());
+        pipelineLayoutInfo.pPushConstantRanges = m_pushRanges.data();
+        vk::PipelineLayout pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
+
+        vk::ComputePipelineCreateInfo pipelineInfo({}, compStageInfo, pipelineLayout);
+        auto result = m_device.createComputePipeline({}, pipelineInfo);
+        if (result.result != vk::Result::eSuccess)
+        {
+            m_device.destroyPipelineLayout(pipelineLayout);
+            throw std::runtime_error("Failed to create compute pipeline!");
+        }
+
+        return std::unique_ptr<Pipeline>(new Pipeline(m_device, pipelineLayout, result.value));
+    }
+
     // --- Pipeline Implementation ---
 
     Pipeline::Pipeline(vk::Device device, vk::PipelineLayout layout, vk::Pipeline pipeline)
@@ -19,10 +19,16 @@ namespace reactor
 
             Builder& setVertexShader(const std::string& shaderPath);
             Builder& setFragmentShader(const std::string& shaderPath);
+            // Builds a compute pipeline instead; only layouts and push constants apply to it.
+            Builder& setComputeShader(const std::string& shaderPath);
             Builder& setColorAttachment(vk::Format format);
             Builder& setDepthAttachment(vk::Format format, bool depthWriteEnable = true);
             Builder& setDescriptorSetLayouts(const std::vector<vk::DescriptorSetLayout>& layouts);
             Builder& setVertexInputFromVertex();
+            Builder& setInstanceInputFromTransform();
+            // One more binding with its attributes, for inputs other than Vertex and InstanceTransform.
+            Builder& addVertexInput(const vk::VertexInputBindingDescription& binding,
+                                    const std::vector<vk::VertexInputAttributeDescription>& attributes);
             Builder& setMultisample(uint32_t samples);
             Builder& setCullMode(vk::CullModeFlags cullMode);
             Builder& setFrontFace(vk::FrontFace frontFace);
@@ -32,9 +38,12 @@ namespace reactor
             [[nodiscard]] std::unique_ptr<Pipeline> build() const;
 
         private:
+            [[nodiscard]] std::unique_ptr<Pipeline> buildCompute() const;
+
             vk::Device m_device;
             std::string m_vertShaderPath;
             std::string m_fragShaderPath;
+            std::string m_compShaderPath;
             vk::Format m_colorAttachmentFormat = vk::Format::eUndefined;
             vk::Format m_depthAttachmentFormat = vk::Format::eUndefined;
             bool m_depthWriteEnable = true;
@@ -80,7 +80,7 @@ void ShadowMapping::createResources()
         m_mvpBuffer.push_back(std::make_unique<Buffer>(m_renderer.allocator(),
                                                        sizeof(SceneUBO),
                                                        vk::BufferUsageFlagBits::eUniformBuffer,
-                                                       VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                                       MemoryPlacement::Dynamic,
                                                        "MVP Buffer"));
     }
 }
@@ -103,13 +103,13 @@ void ShadowMapping::createPipeline()
         .setVertexShader("../resources/shaders/triangle.vert.spv")
         // No fragment shader, we only want depth output
         .setVertexInputFromVertex()
+        .setInstanceInputFromTransform()
         .setDepthAttachment(vk::Format::eD32Sfloat, true) // depth test and write enabled
         .enableDepthBias()
         .setDescriptorSetLayouts(setLayouts)
         .setMultisample(1)
         .setCullMode(vk::CullModeFlagBits::eFront)
-        .setFrontFace(vk::FrontFace::eClockwise) // Match main geometry pipeline
-        .addPushContantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4));
+        .setFrontFace(vk::FrontFace::eClockwise); // Match main geometry pipeline
 
     m_depthPassPipeline = builder.build();
 }
@@ -218,11 +218,11 @@ void ShadowMapping::setLightMatrix(const glm::mat4& lightSpaceMatrix, size_t fra
     ubo.view = glm::mat4(1.0f);
     ubo.projection = lightSpaceMatrix;
     ubo.lightSpaceMatrix = glm::mat4(1.0f);
+    m_lightFrustum = Frustum::fromMatrix(lightSpaceMatrix);
 
-    // map buffer, copy matrix
-    void* data = m_mvpBuffer[frameIndex]->map();
-    memcpy(data, &ubo, sizeof(SceneUBO));
-    m_mvpBuffer[frameIndex]->unmap();
+    // copy matrix into the persistently mapped buffer
+    memcpy(m_mvpBuffer[frameIndex]->mappedData(), &ubo, sizeof(SceneUBO));
+    m_mvpBuffer[frameIndex]->flush(0, sizeof(SceneUBO));
 }
 
 } // namespace reactor
\ No newline at end of file
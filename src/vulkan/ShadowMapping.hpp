@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../core/Frustum.hpp"
 #include "Buffer.hpp"
 #include "DescriptorSet.hpp"
 #include "Image.hpp"
@@ -27,6 +28,12 @@ public:
 
     void setLightMatrix(const glm::mat4& lightMVP, size_t frameIndex);
 
+    // Volume the shadow map covers, from the last light matrix
+    const Frustum& lightFrustum() const
+    {
+        return m_lightFrustum;
+    }
+
     uint32_t resolution() const
     {
         return m_resolution;
@@ -49,6 +56,7 @@ private:
     vk::Sampler m_shadowMapSampler;
 
     std::vector<std::unique_ptr<Buffer>> m_mvpBuffer;
+    Frustum m_lightFrustum;
 
     std::unique_ptr<DescriptorSet> m_descriptors;
 
@@ -36,15 +36,27 @@ namespace reactor {
 
     Swapchain::Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, const Window& window)
         : m_device(device), m_physicalDevice(physicalDevice), m_surface(surface), m_window(window) {
+        create(VK_NULL_HANDLE);
 
+        spdlog::info("Created swapchain: format = {}, extent = {}x{}, images = {}",
+            static_cast<int>(m_format),
+            m_extent.width, m_extent.height,
+            m_images.size());
+    }
+
+    Swapchain::~Swapchain() {
+        cleanup();
+    }
+
+    void Swapchain::create(vk::SwapchainKHR oldSwapchain) {
         // Query surface capabilities
-        auto capabilities = physicalDevice.getSurfaceCapabilitiesKHR(surface);
-        auto formats      = physicalDevice.getSurfaceFormatsKHR(surface);
-        auto presentModes = physicalDevice.getSurfacePresentModesKHR(surface);
+        auto capabilities = m_physicalDevice.getSurfaceCapabilitiesKHR(m_surface);
+        auto formats      = m_physicalDevice.getSurfaceFormatsKHR(m_surface);
+        auto presentModes = m_physicalDevice.getSurfacePresentModesKHR(m_surface);
 
         vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
         vk::PresentModeKHR presentMode = chooseSwapPresentMode(presentModes);
-        vk::Extent2D extent = chooseSwapExtent(capabilities, window);
+        vk::Extent2D extent = chooseSwapExtent(capabilities, m_window);
 
         uint32_t imageCount = capabilities.minImageCount + 1;
         if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
@@ -52,7 +64,7 @@ namespace reactor {
         }
 
         vk::SwapchainCreateInfoKHR createInfo = {};
-        createInfo.surface = surface;
+        createInfo.surface = m_surface;
         createInfo.minImageCount = imageCount;
         createInfo.imageFormat = surfaceFormat.format;
         createInfo.imageColorSpace = surfaceFormat.colorSpace;
@@ -67,7 +79,7 @@ namespace reactor {
         createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        createInfo.oldSwapchain = oldSwapchain;
 
         m_swapchain = m_device.createSwapchainKHR(createInfo);
         m_images = m_device.getSwapchainImagesKHR(m_swapchain);
@@ -75,6 +87,7 @@ namespace reactor {
         m_extent = extent;
 
         // Create image views
+        m_imageViews.clear();
         m_imageViews.reserve(m_images.size());
         for (auto image : m_images) {
             vk::ImageViewCreateInfo viewInfo = {};
@@ -93,18 +106,6 @@ namespace reactor {
 
             m_imageViews.push_back(m_device.createImageView(viewInfo));
         }
-
-        spdlog::info("Created swapchain: format = {}, extent = {}x{}, images = {}, present mode = {}",
-        static_cast<int>(surfaceFormat.format),
-        extent.width, extent.height,
-        m_images.size(),
-        static_cast<int>(presentMode)
-    );
-
-    }
-
-    Swapchain::~Swapchain() {
-        cleanup();
     }
 
     void Swapchain::cleanup() {
@@ -121,72 +122,23 @@ namespace reactor {
         m_images.clear();
     }
 
-    void Swapchain::recreate() {
+    RetiredSwapchain Swapchain::recreate() {
         spdlog::info("Recreating swapchain...");
 
-        cleanup();
-
-        // Query and (re-)create swapchain just like constructor
-        auto capabilities = m_physicalDevice.getSurfaceCapabilitiesKHR(m_surface);
-        auto formats      = m_physicalDevice.getSurfaceFormatsKHR(m_surface);
-        auto presentModes = m_physicalDevice.getSurfacePresentModesKHR(m_surface);
-
-        vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
-        vk::PresentModeKHR presentMode = chooseSwapPresentMode(presentModes);
-        vk::Extent2D extent = chooseSwapExtent(capabilities, m_window);
-
-        uint32_t imageCount = capabilities.minImageCount + 1;
-        if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
-            imageCount = capabilities.maxImageCount;
-        }
-
-        vk::SwapchainCreateInfoKHR createInfo = {};
-        createInfo.surface = m_surface;
-        createInfo.minImageCount = imageCount;
-        createInfo.imageFormat = surfaceFormat.format;
-        createInfo.imageColorSpace = surfaceFormat.colorSpace;
-        createInfo.imageExtent = extent;
-        createInfo.imageArrayLayers = 1;
-        createInfo.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
-        createInfo.imageSharingMode = vk::SharingMode::eExclusive;
-        createInfo.preTransform = capabilities.currentTransform;
-        createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
-        createInfo.presentMode = presentMode;
-        createInfo.clipped = VK_TRUE;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
-
-        m_swapchain = m_device.createSwapchainKHR(createInfo);
-        m_images = m_device.getSwapchainImagesKHR(m_swapchain);
-        m_format = surfaceFormat.format;
-        m_extent = extent;
-
-        m_imageViews.reserve(m_images.size());
-        for (auto image : m_images) {
-            vk::ImageViewCreateInfo viewInfo = {};
-            viewInfo.image = image;
-            viewInfo.viewType = vk::ImageViewType::e2D;
-            viewInfo.format = m_format;
-            viewInfo.components = {
-                vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity,
-                vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity
-            };
-            viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-            viewInfo.subresourceRange.baseMipLevel = 0;
-            viewInfo.subresourceRange.levelCount = 1;
-            viewInfo.subresourceRange.baseArrayLayer = 0;
-            viewInfo.subresourceRange.layerCount = 1;
+        RetiredSwapchain retired{m_swapchain, std::move(m_imageViews)};
+        m_swapchain = nullptr;
+        m_imageViews.clear();
+        m_images.clear();
 
-            m_imageViews.push_back(m_device.createImageView(viewInfo));
-        }
+        // Passing the old swapchain lets the driver recycle its resources while presents finish.
+        create(retired.swapchain);
 
-        spdlog::info("Swapchain recreated: format = {}, extent = {}x{}, images = {}, present mode = {}",
-        static_cast<int>(m_format),
-        m_extent.width, m_extent.height,
-        m_images.size(),
-        static_cast<int>(chooseSwapPresentMode(
-            m_physicalDevice.getSurfacePresentModesKHR(m_surface)))
-    );
+        spdlog::info("Swapchain recreated: format = {}, extent = {}x{}, images = {}",
+            static_cast<int>(m_format),
+            m_extent.width, m_extent.height,
+            m_images.size());
 
+        return retired;
     }
 
 }
@@ -11,6 +11,12 @@
 #include "../core/Window.hpp"
 
 namespace reactor {
+    // Handles of a replaced swapchain; destroy them once no frame in flight references them.
+    struct RetiredSwapchain {
+        vk::SwapchainKHR swapchain;
+        std::vector<vk::ImageView> imageViews;
+    };
+
     class Swapchain {
     public:
         Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, const Window& window);
@@ -23,9 +29,12 @@ namespace reactor {
         [[nodiscard]] const std::vector<vk::ImageView>& getImageViews() const { return m_imageViews; }
         [[nodiscard]] const std::vector<vk::Image>& getImages() const { return m_images; }
 
-        void recreate();
+        // Builds a new swapchain from the old one without waiting for the device; the caller
+        // is responsible for destroying the returned handles once in-flight frames complete.
+        [[nodiscard]] RetiredSwapchain recreate();
 
     private:
+        void create(vk::SwapchainKHR oldSwapchain);
         void cleanup();
 
         vk::Device m_device; // Store a copy for cleanup
@@ -0,0 +1,350 @@
+#include "TerrainRenderer.hpp"
+
+#include "FrameManager.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace reactor
+{
+
+namespace
+{
+struct TerrainPush
+{
+    glm::vec4 eye;     // w holds world units between samples
+    glm::vec4 terrain; // height of sample 0, height per sample step, last sample index, grid quads per side
+};
+} // namespace
+
+TerrainRenderer::TerrainRenderer(VulkanRenderer& renderer,
+                                 FrameManager& frameManager,
+                                 vk::DescriptorSetLayout sceneLayout,
+                                 const std::string& directory,
+                                 const std::string& vertShaderPath,
+                                 const std::string& fragShaderPath)
+    : m_renderer(renderer), m_frameManager(frameManager), m_terrain(directory)
+{
+    if (!m_terrain.valid())
+    {
+        return;
+    }
+    spdlog::info("Creating terrain pipelines");
+
+    // Heights are fetched texel by texel, since vertices sit on samples
+    vk::SamplerCreateInfo samplerInfo{};
+    samplerInfo.magFilter = vk::Filter::eNearest;
+    samplerInfo.minFilter = vk::Filter::eNearest;
+    samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    m_sampler = m_renderer.device().createSampler(samplerInfo);
+
+    const uint32_t resolution = m_terrain.layout().resolution;
+    vk::ImageCreateInfo imageInfo{};
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = vk::Format::eR16Uint;
+    imageInfo.extent = vk::Extent3D{resolution, resolution, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = m_terrain.settings().maxResidentTiles;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    m_heights = std::make_unique<Image>(m_renderer.allocator(), imageInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    vk::ImageViewCreateInfo viewInfo{};
+    viewInfo.image = m_heights->get();
+    viewInfo.viewType = vk::ImageViewType::e2DArray;
+    viewInfo.format = vk::Format::eR16Uint;
+    viewInfo.subresourceRange =
+        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, imageInfo.arrayLayers);
+    m_heightsView = m_renderer.device().createImageView(viewInfo);
+
+    const std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        {0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eVertex},
+    };
+    m_descriptors = std::make_unique<DescriptorSet>(m_renderer.device(), m_renderer.descriptorPool(), 1, bindings);
+    const vk::DescriptorImageInfo heightsInfo(m_sampler, m_heightsView, vk::ImageLayout::eShaderReadOnlyOptimal);
+    m_descriptors->updateSet({
+        vk::WriteDescriptorSet(m_descriptors->get(0), 0, 0, vk::DescriptorType::eCombinedImageSampler, heightsInfo),
+    });
+
+    // Same targets and winding as the mesh pipelines. terrain.vert declares gl_Position invariant,
+    // so the main pass lands exactly on the prepass depth
+    const std::vector setLayouts = {sceneLayout, m_descriptors->getLayout()};
+    m_pipeline = Pipeline::Builder(m_renderer.device())
+                     .setVertexShader(vertShaderPath)
+                     .setFragmentShader(fragShaderPath)
+                     .addVertexInput(TerrainInstance::getBindingDescription(),
+                                     TerrainInstance::getAttributeDescriptions())
+                     .setColorAttachment(vk::Format::eR16G16B16A16Sfloat)
+                     .setDepthAttachment(vk::Format::eD32Sfloat, true)
+                     .setDescriptorSetLayouts(setLayouts)
+                     .setMultisample(4)
+                     .setFrontFace(vk::FrontFace::eClockwise)
+                     .addPushContantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(TerrainPush))
+                     .build();
+    m_depthPipeline = Pipeline::Builder(m_renderer.device())
+                          .setVertexShader(vertShaderPath)
+                          .addVertexInput(TerrainInstance::getBindingDescription(),
+                                          TerrainInstance::getAttributeDescriptions())
+                          .setDepthAttachment(vk::Format::eD32Sfloat, true)
+                          .setDescriptorSetLayouts(setLayouts)
+                          .setMultisample(4)
+                          .setFrontFace(vk::FrontFace::eClockwise)
+                          .addPushContantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(TerrainPush))
+                          .build();
+
+    m_instanceBuffers.resize(m_frameManager.getFramesInFlightCount());
+}
+
+TerrainRenderer::~TerrainRenderer()
+{
+    auto device = m_renderer.device();
+    if (m_heightsView)
+    {
+        device.destroyImageView(m_heightsView);
+    }
+    if (m_sampler)
+    {
+        device.destroySampler(m_sampler);
+    }
+}
+
+void TerrainRenderer::createGrid(vk::CommandBuffer cmd)
+{
+    // Quads of each quadrant together, split along the same diagonal as generatePlaneIndices. With
+    // odd vertices folded onto their even neighbours, that diagonal leaves exactly the coarser grid
+    const uint32_t quads = m_terrain.settings().gridSize;
+    const uint32_t half = quads / 2;
+    const uint32_t rows = quads + 1;
+    std::vector<uint32_t> indices;
+    indices.reserve(6 * quads * quads);
+    for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        const uint32_t firstX = (quadrant & 1) * half;
+        const uint32_t firstZ = (quadrant >> 1) * half;
+        for (uint32_t z = firstZ; z < firstZ + half; ++z)
+        {
+            for (uint32_t x = firstX; x < firstX + half; ++x)
+            {
+                const uint32_t bottomLeft = z * rows + x;
+                const uint32_t bottomRight = bottomLeft + 1;
+                const uint32_t topLeft = bottomLeft + rows;
+                const uint32_t topRight = topLeft + 1;
+                indices.insert(indices.end(), {bottomLeft, topLeft, bottomRight, bottomRight, topLeft, topRight});
+            }
+        }
+    }
+    m_quadrantIndexCount = static_cast<uint32_t>(indices.size() / 4);
+
+    const vk::DeviceSize bytes = indices.size() * sizeof(uint32_t);
+    auto staging = std::make_unique<Buffer>(
+        m_renderer.allocator(), bytes, vk::BufferUsageFlagBits::eTransferSrc, MemoryPlacement::Staging, "Terrain Staging");
+    memcpy(staging->mappedData(), indices.data(), bytes);
+    staging->flush();
+
+    m_indexBuffer = std::make_unique<Buffer>(m_renderer.allocator(),
+                                             bytes,
+                                             vk::BufferUsageFlagBits::eIndexBuffer
+                                                 | vk::BufferUsageFlagBits::eTransferDst,
+                                             MemoryPlacement::GpuOnly,
+                                             "Terrain Grid");
+    cmd.copyBuffer(staging->getHandle(), m_indexBuffer->getHandle(), vk::BufferCopy(0, 0, bytes));
+    m_frameManager.retire(std::move(staging));
+
+    const vk::BufferMemoryBarrier toIndexRead(vk::AccessFlagBits::eTransferWrite,
+                                              vk::AccessFlagBits::eIndexRead,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              m_indexBuffer->getHandle(),
+                                              0,
+                                              VK_WHOLE_SIZE);
+    // Layers are only sampled once uploaded, but the view is declared read-only as a whole
+    const vk::ImageMemoryBarrier toShader(
+        {},
+        vk::AccessFlagBits::eShaderRead,
+        vk::ImageLayout::eUndefined,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        m_heights->get(),
+        vk::ImageSubresourceRange(
+            vk::ImageAspectFlagBits::eColor, 0, 1, 0, m_terrain.settings().maxResidentTiles));
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader
+                            | vk::PipelineStageFlagBits::eComputeShader,
+                        {},
+                        nullptr,
+                        toIndexRead,
+                        toShader);
+}
+
+void TerrainRenderer::upload(vk::CommandBuffer cmd)
+{
+    const uint32_t resolution = m_terrain.layout().resolution;
+    const size_t tileBytes = static_cast<size_t>(resolution) * resolution * sizeof(uint16_t);
+    auto staging = std::make_unique<Buffer>(m_renderer.allocator(),
+                                            m_uploads.size() * tileBytes,
+                                            vk::BufferUsageFlagBits::eTransferSrc,
+                                            MemoryPlacement::Staging,
+                                            "Terrain Staging");
+    auto* bytes = static_cast<char*>(staging->mappedData());
+
+    std::vector<vk::ImageMemoryBarrier> toTransfer;
+    std::vector<vk::ImageMemoryBarrier> toShader;
+    std::vector<vk::BufferImageCopy> regions;
+    for (size_t i = 0; i < m_uploads.size(); ++i)
+    {
+        const auto& [slot, tile] = m_uploads[i];
+        memcpy(bytes + i * tileBytes, tile.samples.data(), tileBytes);
+
+        const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, slot, 1);
+        toTransfer.emplace_back(vk::AccessFlags{},
+                                vk::AccessFlagBits::eTransferWrite,
+                                vk::ImageLayout::eUndefined,
+                                vk::ImageLayout::eTransferDstOptimal,
+                                VK_QUEUE_FAMILY_IGNORED,
+                                VK_QUEUE_FAMILY_IGNORED,
+                                m_heights->get(),
+                                range);
+        toShader.emplace_back(vk::AccessFlagBits::eTransferWrite,
+                              vk::AccessFlagBits::eShaderRead,
+                              vk::ImageLayout::eTransferDstOptimal,
+                              vk::ImageLayout::eShaderReadOnlyOptimal,
+                              VK_QUEUE_FAMILY_IGNORED,
+                              VK_QUEUE_FAMILY_IGNORED,
+                              m_heights->get(),
+                              range);
+
+        vk::BufferImageCopy region{};
+        region.bufferOffset = i * tileBytes;
+        region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, slot, 1);
+        region.imageExtent = vk::Extent3D{resolution, resolution, 1};
+        regions.push_back(region);
+    }
+    staging->flush();
+
+    // A reused layer may still be read by frames in flight; waiting on the stages that sample it
+    // covers them, since they were submitted to this queue earlier. The prop scatter reads it too
+    constexpr auto readers = vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader;
+    cmd.pipelineBarrier(readers, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransfer);
+    cmd.copyBufferToImage(staging->getHandle(), m_heights->get(), vk::ImageLayout::eTransferDstOptimal, regions);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, readers, {}, nullptr, nullptr, toShader);
+    m_frameManager.retire(std::move(staging));
+}
+
+void TerrainRenderer::update(vk::CommandBuffer cmd,
+                             uint32_t frameIdx,
+                             const glm::vec3& focus,
+                             const glm::vec3& eye,
+                             const Frustum& frustum)
+{
+    if (!m_indexBuffer)
+    {
+        createGrid(cmd);
+    }
+
+    m_uploads.clear();
+    m_terrain.update(focus, m_uploads);
+    if (!m_uploads.empty())
+    {
+        upload(cmd);
+    }
+
+    m_chunks.clear();
+    m_terrain.select(frustum, eye, m_chunks);
+
+    // Grouped by index range, each group one instanced draw
+    m_ranges = {};
+    for (const TerrainChunk& chunk : m_chunks)
+    {
+        m_ranges[chunk.quadrant].instanceCount++;
+    }
+    uint32_t first = 0;
+    for (DrawRange& range : m_ranges)
+    {
+        range.firstInstance = first;
+        first += range.instanceCount;
+        range.instanceCount = 0;
+    }
+    m_instances.resize(m_chunks.size());
+    for (const TerrainChunk& chunk : m_chunks)
+    {
+        DrawRange& range = m_ranges[chunk.quadrant];
+        m_instances[range.firstInstance + range.instanceCount++] = {
+            glm::vec4(chunk.firstSample, static_cast<float>(1u << chunk.level), static_cast<float>(chunk.slot)),
+            glm::vec4(chunk.morphRange, chunk.tileOrigin),
+        };
+    }
+
+    auto& instanceBuffer = m_instanceBuffers[frameIdx];
+    const vk::DeviceSize bytes = std::max<size_t>(m_instances.size(), 1) * sizeof(TerrainInstance);
+    if (!instanceBuffer || instanceBuffer->size() < bytes)
+    {
+        m_frameManager.retire(std::move(instanceBuffer));
+        instanceBuffer = std::make_unique<Buffer>(m_renderer.allocator(),
+                                                  bytes + bytes / 2,
+                                                  vk::BufferUsageFlagBits::eVertexBuffer,
+                                                  MemoryPlacement::Dynamic,
+                                                  "Terrain Chunks");
+    }
+    memcpy(instanceBuffer->mappedData(), m_instances.data(), m_instances.size() * sizeof(TerrainInstance));
+    instanceBuffer->flush(0, m_instances.size() * sizeof(TerrainInstance));
+}
+
+void TerrainRenderer::draw(vk::CommandBuffer cmd,
+                           uint32_t frameIdx,
+                           vk::DescriptorSet sceneSet,
+                           const glm::vec3& eye,
+                           bool depthOnly) const
+{
+    if (m_instances.empty())
+    {
+        return;
+    }
+
+    const HeightTile& layout = m_terrain.layout();
+    const float spacing = layout.tileSize / static_cast<float>(layout.resolution - 1);
+    const TerrainPush push{glm::vec4(eye, spacing),
+                           glm::vec4(layout.minHeight,
+                                     (layout.maxHeight - layout.minHeight) / 65535.0f,
+                                     static_cast<float>(layout.resolution - 1),
+                                     static_cast<float>(m_terrain.settings().gridSize))};
+
+    const Pipeline& pipeline = depthOnly ? *m_depthPipeline : *m_pipeline;
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.get());
+    const std::array sets = {sceneSet, m_descriptors->get(0)};
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.getLayout(), 0, sets, nullptr);
+    cmd.pushConstants(pipeline.getLayout(), vk::ShaderStageFlagBits::eVertex, 0, sizeof(push), &push);
+
+    const vk::Buffer instanceBuffer = m_instanceBuffers[frameIdx]->getHandle();
+    const vk::DeviceSize offset = 0;
+    cmd.bindVertexBuffers(0, 1, &instanceBuffer, &offset);
+    cmd.bindIndexBuffer(m_indexBuffer->getHandle(), 0, vk::IndexType::eUint32);
+
+    for (uint32_t group = 0; group < m_ranges.size(); ++group)
+    {
+        const auto [firstInstance, instanceCount] = m_ranges[group];
+        if (instanceCount == 0)
+        {
+            continue;
+        }
+        if (group == Terrain::kWholeNode)
+        {
+            cmd.drawIndexed(4 * m_quadrantIndexCount, instanceCount, 0, 0, firstInstance);
+        }
+        else
+        {
+            cmd.drawIndexed(m_quadrantIndexCount, instanceCount, group * m_quadrantIndexCount, 0, firstInstance);
+        }
+    }
+}
+
+} // namespace reactor
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "../core/Frustum.hpp"
+#include "../core/Terrain.hpp"
+#include "Buffer.hpp"
+#include "DescriptorSet.hpp"
+#include "Image.hpp"
+#include "Pipeline.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reactor
+{
+
+class FrameManager;
+class VulkanRenderer;
+
+// Per-chunk input of terrain.vert, at instance rate on binding 0.
+struct TerrainInstance
+{
+    glm::vec4 node;  // node's first sample within its tile, samples per quad, texture layer
+    glm::vec4 morph; // morph start and end distance, world XZ of the tile's minimum corner
+
+    static vk::VertexInputBindingDescription getBindingDescription()
+    {
+        return {0, sizeof(TerrainInstance), vk::VertexInputRate::eInstance};
+    }
+
+    static std::vector<vk::VertexInputAttributeDescription> getAttributeDescriptions()
+    {
+        return {
+            {0, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(TerrainInstance, node)},
+            {1, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(TerrainInstance, morph)},
+        };
+    }
+};
+
+// Draws a streamed CDLOD Terrain (see Terrain.hpp). Each resident tile's heights fill one layer of
+// an R16 texture array, and every chunk draws the same grid from one shared index buffer with no
+// vertex buffer: terrain.vert places vertices by gl_VertexIndex, reads their heights and blends
+// them into the next coarser level. The indices are laid out quadrant by quadrant, so chunks that
+// cover a quarter of their node draw a quarter of the range. Render thread only.
+class TerrainRenderer
+{
+public:
+    // sceneLayout is the main pass's set 0: scene and light uniforms and the shadow map. The main
+    // pass shades with fragShaderPath, the mesh fragment shader.
+    TerrainRenderer(VulkanRenderer& renderer,
+                    FrameManager& frameManager,
+                    vk::DescriptorSetLayout sceneLayout,
+                    const std::string& directory,
+                    const std::string& vertShaderPath,
+                    const std::string& fragShaderPath);
+    ~TerrainRenderer();
+
+    TerrainRenderer(const TerrainRenderer&) = delete;
+    TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+
+    // False when the directory held no usable terrain; nothing else may be called then.
+    [[nodiscard]] bool valid() const
+    {
+        return m_terrain.valid();
+    }
+
+    // Streams tiles around focus, records the upload of those that arrived and selects this frame's
+    // chunks as seen from eye. Must be outside a render pass.
+    void update(vk::CommandBuffer cmd,
+                uint32_t frameIdx,
+                const glm::vec3& focus,
+                const glm::vec3& eye,
+                const Frustum& frustum);
+
+    // Records the chunks into the depth prepass or the main pass. sceneSet is bound again as set 0,
+    // since the terrain pipelines' layout is incompatible with the mesh pipeline's.
+    void draw(vk::CommandBuffer cmd,
+              uint32_t frameIdx,
+              vk::DescriptorSet sceneSet,
+              const glm::vec3& eye,
+              bool depthOnly) const;
+
+    [[nodiscard]] const TerrainStats& stats() const
+    {
+        return m_terrain.stats();
+    }
+
+    // For passes that sample the ground elsewhere (the prop scatter): the streamed tiles and the
+    // texture array holding their heights. The view is valid once the first update has recorded.
+    [[nodiscard]] const Terrain& terrain() const
+    {
+        return m_terrain;
+    }
+    [[nodiscard]] vk::ImageView heightsView() const
+    {
+        return m_heightsView;
+    }
+    [[nodiscard]] vk::Sampler heightsSampler() const
+    {
+        return m_sampler;
+    }
+
+private:
+    // Instances of one index range, read from this frame's instance buffer
+    struct DrawRange
+    {
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+    };
+
+    void createGrid(vk::CommandBuffer cmd);
+    void upload(vk::CommandBuffer cmd);
+
+    VulkanRenderer& m_renderer;
+    FrameManager& m_frameManager;
+    Terrain m_terrain;
+    vk::Sampler m_sampler;
+    std::unique_ptr<DescriptorSet> m_descriptors;
+    std::unique_ptr<Pipeline> m_pipeline;
+    std::unique_ptr<Pipeline> m_depthPipeline;
+
+    std::unique_ptr<Image> m_heights; // one layer per resident tile
+    vk::ImageView m_heightsView;
+    std::unique_ptr<Buffer> m_indexBuffer; // recorded by the first update
+    uint32_t m_quadrantIndexCount = 0;
+    std::vector<std::unique_ptr<Buffer>> m_instanceBuffers; // one per frame in flight
+
+    // Rebuilt by update each frame; quadrants 0-3, then whole nodes
+    std::array<DrawRange, Terrain::kWholeNode + 1> m_ranges{};
+    // Scratch
+    std::vector<TerrainUpload> m_uploads;
+    std::vector<TerrainChunk> m_chunks;
+    std::vector<TerrainInstance> m_instances;
+};
+
+} // namespace reactor
@@ -17,7 +17,7 @@ std::vector<std::unique_ptr<Buffer>>
              m_allocator,
              size,
              vk::BufferUsageFlagBits::eUniformBuffer,
-             VMA_MEMORY_USAGE_CPU_TO_GPU, "Uniform buffer"));
+             MemoryPlacement::Dynamic, "Uniform buffer"));
      }
      return buffers;
  }
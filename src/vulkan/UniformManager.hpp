@@ -24,10 +24,9 @@ public:
         const auto& name = m_uboTypeMap.at(std::type_index(typeid(T)));
         auto& buffer = m_uniformBuffers.at(name)[frameIndex];
 
-        void* mappedData = nullptr;
-        vmaMapMemory(m_allocator.getAllocator(), buffer->allocation(), &mappedData);
-        memcpy(mappedData, &data, sizeof(T));
-        vmaUnmapMemory(m_allocator.getAllocator(), buffer->allocation());
+        // Uniform buffers are persistently mapped, in device-local memory when the heap allows.
+        memcpy(buffer->mappedData(), &data, sizeof(T));
+        buffer->flush(0, sizeof(T));
     }
 
     // Get the descriptor info need to update a descriptor set.
@@ -0,0 +1,230 @@
+#include "UploadScheduler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace reactor
+{
+
+UploadScheduler::UploadScheduler(Allocator& allocator,
+                                 FrameManager& frameManager,
+                                 vk::DeviceSize maxBytesPerFrame,
+                                 uint32_t maxCopiesPerFrame)
+    : m_allocator(allocator), m_frameManager(frameManager), m_maxBytesPerFrame(maxBytesPerFrame),
+      m_maxCopiesPerFrame(maxCopiesPerFrame)
+{}
+
+UploadScheduler::~UploadScheduler()
+{
+    // Producers on I/O threads may still be filling reservations
+    {
+        std::unique_lock lock(m_mutex);
+        m_reservationsDone.wait(lock, [this] { return m_outstandingReservations == 0; });
+        std::move(m_incoming.begin(), m_incoming.end(), std::back_inserter(m_pending));
+        m_incoming.clear();
+    }
+
+    // Uploads that never ran still complete their callbacks so awaiting loaders can unwind
+    for (auto& request : m_pending)
+    {
+        if (request.onReady)
+        {
+            request.onReady();
+        }
+    }
+}
+
+std::shared_ptr<Buffer> UploadScheduler::enqueue(const void* data,
+                                                 vk::DeviceSize size,
+                                                 vk::BufferUsageFlags usage,
+                                                 const std::string& name,
+                                                 std::optional<glm::vec3> position,
+                                                 std::function<void()> onReady)
+{
+    UploadReservation reservation = reserve(size, usage, name, position);
+    memcpy(reservation.data(), data, size);
+
+    std::shared_ptr<Buffer> destination = reservation.destination;
+    commit(std::move(reservation), std::move(onReady));
+    return destination;
+}
+
+UploadReservation UploadScheduler::reserve(vk::DeviceSize size,
+                                           vk::BufferUsageFlags usage,
+                                           const std::string& name,
+                                           std::optional<glm::vec3> position)
+{
+    UploadReservation reservation;
+    reservation.position = position;
+
+    // Small uploads skip the queue entirely when they can land in host-visible device-local memory
+    if (size <= m_allocator.directUploadLimit())
+    {
+        auto direct = std::make_shared<Buffer>(m_allocator, size, usage, MemoryPlacement::StaticUpload, name);
+        if (direct->isHostVisible())
+        {
+            reservation.destination = std::move(direct);
+        }
+    }
+
+    if (!reservation.destination)
+    {
+        reservation.staging = std::make_unique<Buffer>(
+            m_allocator, size, vk::BufferUsageFlagBits::eTransferSrc, MemoryPlacement::Staging, name + " Staging");
+        reservation.destination = std::make_shared<Buffer>(
+            m_allocator, size, usage | vk::BufferUsageFlagBits::eTransferDst, MemoryPlacement::GpuOnly, name);
+    }
+
+    // Counted only once the buffers exist, so an allocation that throws leaves nothing to release
+    {
+        std::lock_guard lock(m_mutex);
+        m_outstandingReservations++;
+    }
+    return reservation;
+}
+
+void UploadScheduler::commit(UploadReservation&& reservation, std::function<void()> onReady)
+{
+    if (!reservation.staging)
+    {
+        reservation.destination->flush();
+        if (onReady)
+        {
+            onReady();
+        }
+        releaseReservation();
+        return;
+    }
+
+    reservation.staging->flush();
+
+    Request request;
+    request.size = reservation.destination->size();
+    request.staging = std::move(reservation.staging);
+    request.destination = std::move(reservation.destination);
+    request.position = reservation.position;
+    request.onReady = std::move(onReady);
+
+    {
+        std::lock_guard lock(m_mutex);
+        request.sequence = m_nextSequence++;
+        m_incoming.push_back(std::move(request));
+    }
+    releaseReservation();
+}
+
+void UploadScheduler::abandon(UploadReservation&& reservation)
+{
+    reservation.staging.reset();
+    reservation.destination.reset();
+    releaseReservation();
+}
+
+void UploadScheduler::releaseReservation()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_outstandingReservations--;
+    }
+    m_reservationsDone.notify_all();
+}
+
+void UploadScheduler::flush(vk::CommandBuffer cmd)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        std::move(m_incoming.begin(), m_incoming.end(), std::back_inserter(m_pending));
+        m_incoming.clear();
+    }
+
+    m_stats = {};
+    if (m_pending.empty())
+    {
+        return;
+    }
+
+    // Nearest first; unpositioned uploads ahead of everything; FIFO among equals
+    const glm::vec3 view = m_viewPosition;
+    auto distance2 = [view](const Request& request) {
+        if (!request.position)
+        {
+            return -1.0f;
+        }
+        const glm::vec3 d = *request.position - view;
+        return glm::dot(d, d);
+    };
+    std::sort(m_pending.begin(), m_pending.end(), [&distance2](const Request& a, const Request& b) {
+        const float da = distance2(a);
+        const float db = distance2(b);
+        if (da != db)
+        {
+            return da < db;
+        }
+        return a.sequence < b.sequence;
+    });
+
+    vk::DeviceSize bytesLeft = m_maxBytesPerFrame;
+    uint32_t copiesLeft = m_maxCopiesPerFrame;
+    std::vector<std::function<void()>> ready;
+
+    auto it = m_pending.begin();
+    while (it != m_pending.end() && bytesLeft > 0 && copiesLeft > 0)
+    {
+        Request& request = *it;
+        const vk::DeviceSize slice = std::min(request.size - request.offset, bytesLeft);
+
+        const vk::BufferCopy region(request.offset, request.offset, slice);
+        cmd.copyBuffer(request.staging->getHandle(), request.destination->getHandle(), 1, &region);
+
+        request.offset += slice;
+        bytesLeft -= slice;
+        --copiesLeft;
+        m_stats.bytesThisFrame += slice;
+        m_stats.copiesThisFrame++;
+
+        if (request.offset < request.size)
+        {
+            // Budget exhausted part-way through this buffer; the rest follows next frame
+            break;
+        }
+
+        // The staging buffer is read by this frame's copy, so it lives until the frame retires
+        m_frameManager.retire(std::move(request.staging));
+        if (request.onReady)
+        {
+            ready.push_back(std::move(request.onReady));
+        }
+        it = m_pending.erase(it);
+    }
+
+    if (m_stats.copiesThisFrame > 0)
+    {
+        vk::MemoryBarrier barrier{};
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+                                | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead
+                                | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                            vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader
+                                | vk::PipelineStageFlagBits::eFragmentShader
+                                | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                            {},
+                            barrier,
+                            nullptr,
+                            nullptr);
+    }
+
+    for (auto& callback : ready)
+    {
+        callback();
+    }
+
+    for (const auto& request : m_pending)
+    {
+        m_stats.pendingBytes += request.size - request.offset;
+    }
+    m_stats.pendingRequests = m_pending.size();
+}
+
+} // namespace reactor
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Allocator.hpp"
+#include "Buffer.hpp"
+#include "FrameManager.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace reactor
+{
+
+struct UploadStats
+{
+    vk::DeviceSize bytesThisFrame = 0;
+    uint32_t copiesThisFrame = 0;
+    vk::DeviceSize pendingBytes = 0;
+    size_t pendingRequests = 0;
+};
+
+// CPU-writable memory for one upload. Fill data() from any thread, then hand it back with
+// UploadScheduler::commit. When the upload could go straight into host-visible device-local memory
+// there is no staging buffer and data() points into the destination itself.
+struct UploadReservation
+{
+    std::unique_ptr<Buffer> staging;
+    std::shared_ptr<Buffer> destination;
+    std::optional<glm::vec3> position;
+
+    [[nodiscard]] void* data() const
+    {
+        return staging ? staging->mappedData() : destination->mappedData();
+    }
+    [[nodiscard]] vk::DeviceSize size() const
+    {
+        return destination->size();
+    }
+};
+
+// Spreads staging-to-device copies over frames so a burst of finished loads cannot stall one
+// frame. Every frame at most maxBytesPerFrame and maxCopiesPerFrame are recorded into the frame's
+// command buffer, nearest to the view position first; buffers larger than the remaining budget
+// are copied in slices across several frames.
+class UploadScheduler
+{
+public:
+    UploadScheduler(Allocator& allocator,
+                    FrameManager& frameManager,
+                    vk::DeviceSize maxBytesPerFrame = 16 * 1024 * 1024,
+                    uint32_t maxCopiesPerFrame = 32);
+
+    ~UploadScheduler();
+
+    UploadScheduler(const UploadScheduler&) = delete;
+    UploadScheduler& operator=(const UploadScheduler&) = delete;
+
+    // Copies data into staging memory now and returns the destination buffer, which is filled by
+    // later flush() calls. Uploads without a position go first. onReady runs on the render thread
+    // once the last slice has been recorded, so draws recorded after that flush see the data; it
+    // runs immediately when the data could be written into host-visible device-local memory, and
+    // from the destructor for uploads that were still pending.
+    // Safe to call from any thread.
+    std::shared_ptr<Buffer> enqueue(const void* data,
+                                    vk::DeviceSize size,
+                                    vk::BufferUsageFlags usage,
+                                    const std::string& name,
+                                    std::optional<glm::vec3> position = std::nullopt,
+                                    std::function<void()> onReady = {});
+
+    // Two-step form of enqueue for producers that can write the bytes in place, e.g. file reads
+    // targeting the mapped pointer. Every reservation must end in commit or abandon; the destructor
+    // waits for outstanding ones. All three are safe from any thread.
+    UploadReservation reserve(vk::DeviceSize size,
+                              vk::BufferUsageFlags usage,
+                              const std::string& name,
+                              std::optional<glm::vec3> position = std::nullopt);
+    void commit(UploadReservation&& reservation, std::function<void()> onReady = {});
+    void abandon(UploadReservation&& reservation);
+
+    // co_await scheduler.uploadAsync(std::move(reservations)) commits them and resumes once every
+    // copy has been recorded: on the render thread inside flush(), or inline for direct uploads.
+    auto uploadAsync(std::vector<UploadReservation> reservations)
+    {
+        struct Awaiter
+        {
+            UploadScheduler& scheduler;
+            std::vector<UploadReservation> reservations;
+
+            bool await_ready() const noexcept
+            {
+                return reservations.empty();
+            }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                // One token per upload plus one held until every commit has been issued, so the
+                // coroutine cannot resume while this frame is still being used.
+                auto remaining = std::make_shared<std::atomic<size_t>>(reservations.size() + 1);
+                for (auto& reservation : reservations)
+                {
+                    scheduler.commit(std::move(reservation), [remaining, handle] {
+                        if (remaining->fetch_sub(1) == 1)
+                            handle.resume();
+                    });
+                }
+                return remaining->fetch_sub(1) != 1;
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, std::move(reservations)};
+    }
+
+    void setViewPosition(const glm::vec3& position)
+    {
+        m_viewPosition = position;
+    }
+
+    // Records this frame's share of the pending copies followed by a barrier that makes them
+    // visible to vertex input and shaders. Call after the command buffer has begun and before any
+    // pass that draws.
+    void flush(vk::CommandBuffer cmd);
+
+    [[nodiscard]] const UploadStats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    void releaseReservation();
+
+    struct Request
+    {
+        std::unique_ptr<Buffer> staging;
+        std::shared_ptr<Buffer> destination;
+        vk::DeviceSize size = 0;
+        vk::DeviceSize offset = 0;
+        std::optional<glm::vec3> position;
+        std::function<void()> onReady;
+        uint64_t sequence = 0;
+    };
+
+    Allocator& m_allocator;
+    FrameManager& m_frameManager;
+    vk::DeviceSize m_maxBytesPerFrame;
+    uint32_t m_maxCopiesPerFrame;
+    glm::vec3 m_viewPosition{0.0f};
+
+    std::mutex m_mutex;
+    std::vector<Request> m_incoming;
+    std::vector<Request> m_pending;
+    uint64_t m_nextSequence = 0;
+    uint32_t m_outstandingReservations = 0;
+    std::condition_variable m_reservationsDone;
+
+    UploadStats m_stats;
+};
+
+} // namespace reactor
@@ -48,4 +48,28 @@ struct Vertex
     }
 };
 
+// Per-instance model matrix, read as four vec4 attributes (locations 4-7) from binding 1.
+struct InstanceTransform
+{
+    glm::mat4 model;
+
+    static vk::VertexInputBindingDescription getBindingDescription()
+    {
+        return {1, sizeof(InstanceTransform), vk::VertexInputRate::eInstance};
+    }
+
+    static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions()
+    {
+        std::array<vk::VertexInputAttributeDescription, 4> attributeDescriptions{};
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            attributeDescriptions[column].binding = 1;
+            attributeDescriptions[column].location = 4 + column;
+            attributeDescriptions[column].format = vk::Format::eR32G32B32A32Sfloat;
+            attributeDescriptions[column].offset = column * sizeof(glm::vec4);
+        }
+        return attributeDescriptions;
+    }
+};
+
 } // namespace reactor
\ No newline at end of file
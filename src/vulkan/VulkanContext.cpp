@@ -1,5 +1,7 @@
 #include "VulkanContext.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 #include <spdlog/spdlog.h>
@@ -147,6 +149,13 @@ QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice device) c
     return indices;
 }
 
+bool VulkanContext::isDeviceExtensionSupported(const char* extensionName) const {
+    const auto available = m_physicalDevice.enumerateDeviceExtensionProperties();
+    return std::any_of(available.begin(), available.end(), [extensionName](const vk::ExtensionProperties& props) {
+        return std::strcmp(props.extensionName, extensionName) == 0;
+    });
+}
+
 void VulkanContext::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(m_physicalDevice);
 
@@ -162,7 +171,12 @@ void VulkanContext::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    vk::PhysicalDeviceFeatures deviceFeatures{}; // No special features for now
+    // Optional: the Hi-Z downsampler indexes its array of mip images with a loop counter, and
+    // GPU-built indirect draws start each draw's instances at a nonzero firstInstance
+    const vk::PhysicalDeviceFeatures supportedFeatures = m_physicalDevice.getFeatures();
+    vk::PhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.shaderStorageImageArrayDynamicIndexing = supportedFeatures.shaderStorageImageArrayDynamicIndexing;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
     vk::PhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
     dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
@@ -172,6 +186,12 @@ void VulkanContext::createLogicalDevice() {
         // VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
     };
 
+    // Optional: lets the allocator report real per-heap budgets
+    m_memoryBudgetSupported = isDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_memoryBudgetSupported) {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
     vk::DeviceCreateInfo createInfo{};
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -193,6 +213,7 @@ void VulkanContext::createLogicalDevice() {
         m_graphicsQueue = m_device.getQueue(indices.graphicsFamily.value(), 0);
         m_presentQueue = m_device.getQueue(indices.presentFamily.value(), 0);
         m_queueFamilies = indices; // Store the found queue families
+        m_enabledFeatures = deviceFeatures;
 
         spdlog::info("Logical device created");
     } catch (const vk::SystemError& err) {
@@ -33,6 +33,8 @@ public:
     [[nodiscard]] vk::Queue graphicsQueue() const { return m_graphicsQueue; }
     [[nodiscard]] vk::Queue presentQueue() const { return m_presentQueue; }
     [[nodiscard]] QueueFamilyIndices queueFamilies() const { return m_queueFamilies; }
+    [[nodiscard]] bool memoryBudgetSupported() const { return m_memoryBudgetSupported; }
+    [[nodiscard]] const vk::PhysicalDeviceFeatures& enabledFeatures() const { return m_enabledFeatures; }
 
 private:
     // Private helper methods to keep the constructor clean
@@ -43,6 +45,7 @@ private:
 
     bool isDeviceSuitable(vk::PhysicalDevice device);
     [[nodiscard]] QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device) const;
+    [[nodiscard]] bool isDeviceExtensionSupported(const char* extensionName) const;
 
     // Member variables - these are owned by the context
     vk::Instance m_instance;
@@ -55,6 +58,9 @@ private:
     vk::Queue m_presentQueue;
     QueueFamilyIndices m_queueFamilies;
 
+    bool m_memoryBudgetSupported = false;
+    vk::PhysicalDeviceFeatures m_enabledFeatures;
+
 };
 
 } // reactor
@@ -1,14 +1,28 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <utility>
 
+#include "../core/AssetLoader.hpp"
+#include "../core/AssetManager.hpp"
 #include "../core/Camera.hpp"
+#include "../core/MaskedOcclusion.hpp"
+#include "../core/SceneIO.hpp"
+#include "../core/SceneStore.hpp"
 #include "../core/Uniforms.hpp"
 #include "../core/Window.hpp"
+#include "../core/WorldPartition.hpp"
 #include "../imgui/Imgui.hpp"
 #include "Allocator.hpp"
+#include "Defragmenter.hpp"
 #include "DescriptorSet.hpp"
+#include "DrawPacket.hpp"
 #include "FrameManager.hpp"
+#include "GpuCulling.hpp"
+#include "GpuScatter.hpp"
+#include "HiZPyramid.hpp"
+#include "ImpostorRenderer.hpp"
 #include "Image.hpp"
 #include "ImageStateTracker.h"
 #include "Mesh.hpp"
@@ -17,7 +31,9 @@
 #include "Sampler.hpp"
 #include "ShadowMapping.hpp"
 #include "Swapchain.hpp"
+#include "TerrainRenderer.hpp"
 #include "UniformManager.hpp"
+#include "UploadScheduler.hpp"
 #include "VulkanContext.hpp"
 
 namespace reactor
@@ -32,12 +48,20 @@ struct RendererConfig
     std::string fragShaderPath;
     std::string compositeVertShaderPath;
     std::string compositeFragShaderPath;
-};
-
-struct RenderObject
-{
-    std::shared_ptr<Mesh> mesh;
-    glm::mat4 transform = glm::mat4(1.0f);
+    std::string cullShaderPath; // empty culls and selects LODs on the CPU
+    std::string hizShaderPath;  // depth pyramid for the GPU path's occlusion culling
+    bool softwareOcclusion = false; // CPU path: cull the camera behind EntityOccluder proxies
+    // CPU path: distant instances draw as impostors when their mesh has one; empty keeps geometry
+    std::string impostorVertShaderPath;
+    std::string impostorFragShaderPath;
+    std::string worldDirectory; // streamed world cells; empty disables streaming
+    // Streamed heightmap tiles drawn in place of the ground plane; empty or tileless keeps the plane
+    std::string terrainDirectory;
+    std::string terrainVertShaderPath;
+    // Procedural props placed on the GPU from .scatter density layers; empty disables them
+    std::string scatterDirectory;
+    std::string scatterShaderPath;
+    std::string scenePath;      // loaded at startup when present, and the editor's save target
 };
 
 class VulkanRenderer
@@ -48,12 +72,35 @@ public:
 
     void drawFrame();
 
+    // File-backed objects, the camera and the light go to a binary scene file. Objects built from
+    // in-memory geometry belong to code and are neither saved nor replaced on load.
+    bool saveScene(const std::string& path) const;
+    bool loadScene(const std::string& path);
+
+    // Point the world partition streams cells around, usually the orbit target. It is also saved
+    // as the scene camera's target.
+    void setStreamingFocus(const glm::vec3& focus)
+    {
+        m_streamingFocus = focus;
+    }
+
+    // The camera of the scene loaded since the last call, if any, so the caller can reseat
+    // whatever drives the camera. Position, orientation and field of view are already applied.
+    std::optional<SceneCamera> takeLoadedCamera()
+    {
+        return std::exchange(m_loadedCamera, std::nullopt);
+    }
+
+    // Point where the ray under the cursor, in window coordinates, meets the bounds of the nearest
+    // visible entity, if it meets any.
+    std::optional<glm::vec3> pick(double x, double y) const;
+
     vk::Device device() const;
     Allocator& allocator();
     vk::DescriptorPool descriptorPool() const;
 
 private:
-    const RendererConfig& m_config;
+    const RendererConfig m_config;
     Window& m_window;
     Camera& m_camera;
 
@@ -61,6 +108,10 @@ private:
     std::unique_ptr<Swapchain> m_swapchain;
     std::unique_ptr<Allocator> m_allocator;
     std::unique_ptr<FrameManager> m_frameManager;
+    std::unique_ptr<Defragmenter> m_defragmenter;
+    std::unique_ptr<UploadScheduler> m_uploadScheduler;
+    std::unique_ptr<AssetLoader> m_assetLoader;
+    std::unique_ptr<AssetManager> m_assetManager;
     std::unique_ptr<DescriptorSet> m_descriptorSet;
     std::unique_ptr<Pipeline> m_pipeline;
     std::unique_ptr<Pipeline> m_compositePipeline;
@@ -70,6 +121,11 @@ private:
     std::unique_ptr<UniformManager> m_uniformManager;
     std::unique_ptr<Imgui> m_imgui;
     std::unique_ptr<ShadowMapping> m_shadowMapping;
+    std::unique_ptr<HiZPyramid> m_hiZ; // before m_gpuCulling, which refers to it
+    std::unique_ptr<GpuCulling> m_gpuCulling;
+    std::unique_ptr<ImpostorRenderer> m_impostors;
+    std::unique_ptr<TerrainRenderer> m_terrain;
+    std::unique_ptr<GpuScatter> m_scatter; // after m_terrain, whose heights it samples
 
     ImageStateTracker m_imageStateTracker;
 
@@ -87,7 +143,38 @@ private:
     std::vector<vk::DescriptorSet> m_depthImageDescriptorSets;
 
     DirectionalLightUBO m_light;
-    std::vector<RenderObject> m_objects;
+    ThreadPool m_jobs; // per-frame data-parallel work; the render thread joins in
+    SceneStore m_scene;
+    std::shared_ptr<Mesh> m_placeholderMesh;
+    std::unique_ptr<WorldPartition> m_worldPartition;
+    glm::vec3 m_streamingFocus{0.0f};
+    std::optional<SceneCamera> m_loadedCamera;
+
+    // Instances of one mesh, read from this frame's instance buffer in front-to-back order
+    struct DrawBatch
+    {
+        const Mesh* mesh;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+        uint32_t nearestDepth; // depth bits of the first instance's sort key
+    };
+    // Rebuilt by buildDrawLists each frame
+    std::vector<DrawBatch> m_cameraDrawList;
+    std::vector<DrawBatch> m_depthDrawList; // camera batches, nearest first
+    std::vector<DrawBatch> m_shadowDrawList;
+    std::vector<ImpostorBatch> m_impostorDrawList; // camera, after its meshes
+    MaskedOcclusion m_occlusion; // CPU path, camera only
+    bool m_softwareOcclusion = false; // config.softwareOcclusion, cleared when culling on the GPU
+    std::vector<std::unique_ptr<Buffer>> m_instanceBuffers; // one per frame in flight
+    // Scratch
+    std::vector<uint32_t> m_visible;
+    std::vector<DrawPacket> m_packets;
+    std::vector<DrawPacket> m_packetScratch;
+    std::vector<InstanceTransform> m_instanceData;
+    std::vector<std::pair<float, uint32_t>> m_occluderCandidates; // projected size, entity
+    std::vector<Occluder> m_occluders;
+    float m_lodPixelError = 1.0f;
+    float m_impostorPixels = 24.0f; // projected bounding radius below which an impostor stands in
 
     vk::DescriptorPool m_descriptorPool;
 
@@ -106,10 +193,17 @@ private:
     void createDescriptorPool();
 
     void handleSwapchainResizing();
+    void recreateRenderTargets();
     void beginCommandBuffer(vk::CommandBuffer cmd);
     void beginDynamicRendering(vk::CommandBuffer cmd, vk::ImageView colorImageView, vk::ImageView depthImageView, vk::Extent2D extent, bool clearColor, bool clearDepth);
     void bindDescriptorSets(vk::CommandBuffer cmd);
-    void drawGeometry(vk::CommandBuffer cmd);
+    // Pixels covered by one world unit at distance 1
+    [[nodiscard]] float viewPixelsPerUnit(const vk::Extent2D& extent) const;
+    void buildDrawLists(vk::CommandBuffer cmd, const vk::Extent2D& extent, uint32_t frameIdx);
+    void renderOccluders(const vk::Extent2D& extent, float pixelsPerUnitAtOne);
+    void drawPass(vk::CommandBuffer cmd, DrawPass pass, uint32_t frameIdx);
+    void drawLateOcclusionPhase(vk::CommandBuffer cmd, const vk::Extent2D& extent, uint32_t frameIdx);
+    void drawGeometry(vk::CommandBuffer cmd, const std::vector<DrawBatch>& batches);
     void renderUI(vk::CommandBuffer cmd) const;
     static void endDynamicRendering(vk::CommandBuffer cmd);
     static void endCommandBuffer(vk::CommandBuffer cmd);